@@ -0,0 +1,120 @@
+// Бенчмарк загрузки корпуса из файла: построчное чтение через std::getline против LoadCorpus
+// (отображение файла в память, параллельный разбор и пакетное добавление).
+// Собирается так же, как search_benchmark. Корпус генерируется во временный файл.
+//
+// Запуск: corpus_load_benchmark [document_count] [seed]
+// Результат печатается в std::cout в формате JSON, пропускная способность - в МБ/с.
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../corpus_generator.h"
+#include "../corpus_loader.h"
+#include "../search_server.h"
+
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+struct BenchmarkConfig
+{
+    int document_count = 100'000;
+    uint32_t seed = 42;
+    int dictionary_size = 20'000;
+    int max_word_length = 10;
+    int document_word_count = 50;
+};
+
+const DocumentStatus STATUSES[] = {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED,
+                                   DocumentStatus::REMOVED};
+
+//Прежний способ: строка за строкой, поля разбираются потоком
+void LoadByLines(const string& path, SearchServer& search_server)
+{
+    ifstream input(path);
+    string line;
+    while (getline(input, line)) {
+        if (line.empty()) { continue; }
+        istringstream fields(line);
+        string id, status, ratings_text, text;
+        getline(fields, id, '\t');
+        getline(fields, status, '\t');
+        getline(fields, ratings_text, '\t');
+        getline(fields, text);
+        vector<int> ratings;
+        istringstream ratings_input(ratings_text);
+        for (int rating; ratings_input >> rating;) {
+            ratings.push_back(rating);
+        }
+        const DocumentStatus document_status = status == "ACTUAL"s ? DocumentStatus::ACTUAL
+                : status == "IRRELEVANT"s ? DocumentStatus::IRRELEVANT
+                : status == "BANNED"s ? DocumentStatus::BANNED : DocumentStatus::REMOVED;
+        search_server.AddDocument(stoi(id), text, document_status, ratings);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    BenchmarkConfig config;
+    try {
+        if (argc > 1) { config.document_count = stoi(argv[1]); }
+        if (argc > 2) { config.seed = static_cast<uint32_t>(stoul(argv[2])); }
+    }
+    catch (const exception&) {
+        cerr << "Usage: corpus_load_benchmark [document_count] [seed]" << endl;
+        return 1;
+    }
+    if (config.document_count <= 0) {
+        cerr << "Document count must be greater than zero." << endl;
+        return 1;
+    }
+
+    char directory_template[] = "/tmp/corpus-load-benchmark-XXXXXX";
+    const string directory = mkdtemp(directory_template);
+    const string path = directory + "/corpus.tsv"s;
+    {
+        mt19937 generator(config.seed);
+        const auto dictionary = GenerateDictionary(generator, config.dictionary_size, config.max_word_length);
+        ZipfWordSampler sampler(dictionary, 1.0);
+        ofstream output(path);
+        for (int id = 0; id < config.document_count; ++id) {
+            const string text = GenerateZipfQuery(generator, sampler, config.document_word_count);
+            output << FormatCorpusRecord({id, STATUSES[id % 4], {id % 7, -(id % 5), 3}, text});
+        }
+    }
+
+    SearchServer line_server("and in on"s);
+    const Clock::time_point line_start = Clock::now();
+    LoadByLines(path, line_server);
+    const double line_seconds = chrono::duration<double>(Clock::now() - line_start).count();
+
+    SearchServer mapped_server("and in on"s);
+    const CorpusLoadStats stats = LoadCorpus(path, mapped_server);
+    remove(path.c_str());
+    rmdir(directory.c_str());
+    if (line_server.GetDocumentCount() != mapped_server.GetDocumentCount()) {
+        cerr << "Loaders returned different document counts." << endl;
+        return 1;
+    }
+
+    const double megabytes = stats.bytes / (1024.0 * 1024.0);
+    cout << "{\n"
+         << "  \"document_count\": " << stats.document_count << ",\n"
+         << "  \"seed\": " << config.seed << ",\n"
+         << "  \"megabytes\": " << megabytes << ",\n"
+         << "  \"getline_mb_s\": " << megabytes / line_seconds << ",\n"
+         << "  \"mmap_parse_mb_s\": " << (stats.parse_seconds > 0 ? megabytes / stats.parse_seconds : 0) << ",\n"
+         << "  \"mmap_load_mb_s\": " << stats.GetMegabytesPerSecond() << "\n"
+         << "}" << endl;
+}
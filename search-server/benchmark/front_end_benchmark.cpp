@@ -0,0 +1,174 @@
+// Нагрузочный бенчмарк сетевого фронтенда: пропускная способность и задержки запросов.
+// Собирается так же, как search_benchmark. Фронтенд запускается в этом же процессе на Unix-сокете,
+// клиенты в отдельных потоках отправляют запросы, не дожидаясь ответов (до pipeline_depth одновременно).
+//
+// Запуск: front_end_benchmark [connections] [pipeline_depth] [requests_per_connection] [corpus_size] [seed]
+// Результат печатается в std::cout в формате JSON.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../corpus_generator.h"
+#include "../profiler.h"
+#include "../search_front_end.h"
+#include "../search_server.h"
+#include "../shard_protocol.h"
+
+using namespace std;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+struct BenchmarkConfig
+{
+    int connections = 8;
+    int pipeline_depth = 32;
+    int requests_per_connection = 20'000;
+    int corpus_size = 10'000;
+    uint32_t seed = 42;
+    int dictionary_size = 5'000;
+    int max_word_length = 10;
+    int document_word_count = 50;
+    int query_count = 1'000;
+    int query_word_count = 5;
+};
+
+//Отправляет запросы и возвращает задержки ответов в наносекундах
+vector<uint64_t> RunClient(const string& socket_path, const vector<string>& queries, const BenchmarkConfig& config,
+        size_t first_query)
+{
+    const int fd = ConnectUnixSocket(socket_path);
+    vector<uint64_t> latencies;
+    latencies.reserve(config.requests_per_connection);
+    deque<Clock::time_point> sent_times;
+    int sent = 0;
+    string buffer(64 * 1024, '\0');
+    string request;
+    while (latencies.size() < static_cast<size_t>(config.requests_per_connection)) {
+        request.clear();
+        while (sent < config.requests_per_connection && static_cast<int>(sent_times.size()) < config.pipeline_depth) {
+            request += queries[(first_query + sent) % queries.size()];
+            request += '\n';
+            sent_times.push_back(Clock::now());
+            ++sent;
+        }
+        for (size_t offset = 0; offset < request.size();) {
+            const ssize_t result = write(fd, request.data() + offset, request.size() - offset);
+            if (result <= 0) { throw runtime_error("write failed"); }
+            offset += static_cast<size_t>(result);
+        }
+        const ssize_t result = read(fd, buffer.data(), buffer.size());
+        if (result <= 0) { throw runtime_error("read failed"); }
+        const Clock::time_point now = Clock::now();
+        for (ssize_t i = 0; i < result; ++i) {
+            if (buffer[i] == '\n') {
+                latencies.push_back(chrono::duration_cast<chrono::nanoseconds>(now - sent_times.front()).count());
+                sent_times.pop_front();
+            }
+        }
+    }
+    close(fd);
+    return latencies;
+}
+
+uint64_t GetPercentile(const vector<uint64_t>& sorted_values, double percentile)
+{
+    if (sorted_values.empty()) { return 0; }
+    const size_t index = static_cast<size_t>(percentile / 100.0 * (sorted_values.size() - 1) + 0.5);
+    return sorted_values[index];
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    BenchmarkConfig config;
+    try {
+        if (argc > 1) { config.connections = stoi(argv[1]); }
+        if (argc > 2) { config.pipeline_depth = stoi(argv[2]); }
+        if (argc > 3) { config.requests_per_connection = stoi(argv[3]); }
+        if (argc > 4) { config.corpus_size = stoi(argv[4]); }
+        if (argc > 5) { config.seed = static_cast<uint32_t>(stoul(argv[5])); }
+    }
+    catch (const exception&) {
+        cerr << "Usage: front_end_benchmark [connections] [pipeline_depth] [requests_per_connection] [corpus_size] "
+                "[seed]" << endl;
+        return 1;
+    }
+    if (config.connections <= 0 || config.pipeline_depth <= 0 || config.requests_per_connection <= 0
+            || config.corpus_size <= 0) {
+        cerr << "All parameters must be greater than zero." << endl;
+        return 1;
+    }
+
+    mt19937 generator(config.seed);
+    const auto dictionary = GenerateDictionary(generator, config.dictionary_size, config.max_word_length);
+    ZipfWordSampler sampler(dictionary, 1.0);
+    SearchServer search_server(dictionary[0]);
+    for (int id = 0; id < config.corpus_size; ++id) {
+        search_server.AddDocument(id, GenerateZipfQuery(generator, sampler, config.document_word_count),
+                DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    const auto queries = GenerateZipfQueries(generator, sampler, config.query_count, config.query_word_count);
+
+    char directory_template[] = "/tmp/front-end-benchmark-XXXXXX";
+    const string directory = mkdtemp(directory_template);
+    const string socket_path = directory + "/front_end.sock"s;
+    vector<uint64_t> latencies;
+    double elapsed_s = 0;
+    {
+        SearchFrontEnd front_end(search_server);
+        front_end.ListenUnix(socket_path);
+        thread server_thread([&front_end]() { front_end.Run(); });
+        ResetProfile();
+
+        const Clock::time_point start = Clock::now();
+        vector<vector<uint64_t>> client_latencies(config.connections);
+        vector<thread> clients;
+        for (int i = 0; i < config.connections; ++i) {
+            clients.emplace_back([&, i]() {
+                client_latencies[i] = RunClient(socket_path, queries, config, static_cast<size_t>(i) * 97);
+            });
+        }
+        for (thread& client : clients) {
+            client.join();
+        }
+        elapsed_s = chrono::duration<double>(Clock::now() - start).count();
+        front_end.Stop();
+        server_thread.join();
+        for (const auto& client : client_latencies) {
+            latencies.insert(latencies.end(), client.begin(), client.end());
+        }
+    }
+    rmdir(directory.c_str());
+
+    sort(latencies.begin(), latencies.end());
+    uint64_t server_p99_ns = 0;
+    for (const StageProfile& profile : GetProfileSnapshot()) {
+        if (profile.stage == ProfileStage::SERVE_REQUEST) {
+            server_p99_ns = profile.GetPercentileNs(99);
+        }
+    }
+    cout << "{\n"
+         << "  \"connections\": " << config.connections << ",\n"
+         << "  \"pipeline_depth\": " << config.pipeline_depth << ",\n"
+         << "  \"corpus_size\": " << config.corpus_size << ",\n"
+         << "  \"seed\": " << config.seed << ",\n"
+         << "  \"requests\": " << latencies.size() << ",\n"
+         << "  \"qps\": " << latencies.size() / elapsed_s << ",\n"
+         << "  \"latency_us\": {\"p50\": " << GetPercentile(latencies, 50) / 1000.0
+         << ", \"p99\": " << GetPercentile(latencies, 99) / 1000.0
+         << ", \"max\": " << (latencies.empty() ? 0 : latencies.back()) / 1000.0 << "},\n"
+         << "  \"server_p99_us\": " << server_p99_ns / 1000.0 << "\n"
+         << "}" << endl;
+}
@@ -0,0 +1,382 @@
+// Воспроизводимый набор бенчмарков поискового сервера.
+// Собирается отдельно от main.cpp вместе с остальными .cpp каталога search-server.
+//
+// Запуск: search_benchmark [repetitions] [seed] [corpus_size...]
+// Результат печатается в std::cout в формате JSON.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <execution>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "../corpus_generator.h"
+#include "../process_queries.h"
+#include "../remove_duplicates.h"
+#include "../search_server.h"
+#include "../string_processing.h"
+
+using namespace std;
+
+namespace {
+
+struct BenchmarkConfig
+{
+    int repetitions = 5;
+    uint32_t seed = 42;
+    vector<int> corpus_sizes{1'000, 5'000};
+    int dictionary_size = 5'000;
+    int max_word_length = 10;
+    int document_word_count = 50;
+    int query_count = 100;
+    int query_word_count = 10;
+    double zipf_exponent = 1.0;
+    double minus_prob = 0.1;
+};
+
+struct Corpus
+{
+    vector<string> dictionary;
+    vector<string> documents;
+    vector<string> queries;
+};
+
+struct Statistics
+{
+    double min_ms = 0;
+    double max_ms = 0;
+    double mean_ms = 0;
+    double median_ms = 0;
+    double stddev_ms = 0;
+};
+
+struct BenchmarkResult
+{
+    string name;
+    int corpus_size = 0;
+    size_t operations = 0;
+    Statistics statistics;
+};
+
+Statistics ComputeStatistics(vector<double> samples)
+{
+    Statistics statistics;
+    if (samples.empty()) { return statistics; }
+    sort(samples.begin(), samples.end());
+    statistics.min_ms = samples.front();
+    statistics.max_ms = samples.back();
+    statistics.mean_ms = accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    const size_t middle = samples.size() / 2;
+    statistics.median_ms = samples.size() % 2 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2;
+    double square_sum = 0;
+    for (double sample : samples) {
+        square_sum += (sample - statistics.mean_ms) * (sample - statistics.mean_ms);
+    }
+    statistics.stddev_ms = samples.size() > 1 ? sqrt(square_sum / (samples.size() - 1)) : 0.0;
+    return statistics;
+}
+
+//Значение, которое не даёт компилятору выбросить измеряемый код
+volatile double benchmark_sink = 0;
+
+//setup выполняется перед каждым повтором и в замер не входит, run получает его результат
+template<typename Setup, typename Run>
+Statistics Measure(int repetitions, Setup setup, Run run)
+{
+    using Clock = chrono::steady_clock;
+    vector<double> samples;
+    samples.reserve(repetitions);
+    for (int i = 0; i < repetitions; ++i) {
+        auto state = setup();
+        const auto start = Clock::now();
+        benchmark_sink = benchmark_sink + run(state);
+        const auto finish = Clock::now();
+        samples.push_back(chrono::duration<double, milli>(finish - start).count());
+    }
+    return ComputeStatistics(move(samples));
+}
+
+Corpus GenerateCorpus(const BenchmarkConfig& config, int corpus_size)
+{
+    mt19937 generator(config.seed);
+    Corpus corpus;
+    corpus.dictionary = GenerateDictionary(generator, config.dictionary_size, config.max_word_length);
+    ZipfWordSampler sampler(corpus.dictionary, config.zipf_exponent);
+    corpus.documents = GenerateZipfQueries(generator, sampler, corpus_size, config.document_word_count);
+    //Каждый двадцатый документ - копия предыдущего, чтобы RemoveDuplicates было что удалять
+    for (size_t i = 20; i < corpus.documents.size(); i += 20) {
+        corpus.documents[i] = corpus.documents[i - 1];
+    }
+    corpus.queries = GenerateZipfQueries(generator, sampler, config.query_count, config.query_word_count,
+            config.minus_prob);
+    return corpus;
+}
+
+//Первые required_count плюс-слов каждого запроса становятся обязательными: "+слово"
+vector<string> MakeRequiredQueries(const vector<string>& queries, int required_count)
+{
+    vector<string> required_queries;
+    required_queries.reserve(queries.size());
+    for (const string& query : queries) {
+        string required_query;
+        int count = 0;
+        for (const string_view word : SplitIntoWordsView(query)) {
+            if (word.empty()) { continue; }
+            if (!required_query.empty()) { required_query += ' '; }
+            if (word[0] != '-' && count++ < required_count) { required_query += '+'; }
+            required_query += word;
+        }
+        required_queries.push_back(move(required_query));
+    }
+    return required_queries;
+}
+
+unique_ptr<SearchServer> BuildServer(const Corpus& corpus)
+{
+    auto search_server = make_unique<SearchServer>(corpus.dictionary[0]);
+    for (size_t i = 0; i < corpus.documents.size(); ++i) {
+        const int id = static_cast<int>(i);
+        search_server->AddDocument(id, corpus.documents[i], id % 4 ? DocumentStatus::ACTUAL : DocumentStatus::BANNED,
+                {id % 7, id % 5, -(id % 3)});
+    }
+    return search_server;
+}
+
+template<typename Policy>
+double RunFindTopDocuments(const SearchServer& search_server, const vector<string>& queries, Policy policy)
+{
+    double total_relevance = 0;
+    for (const string& query : queries) {
+        for (const Document& document : search_server.FindTopDocuments(policy, query)) {
+            total_relevance += document.relevance;
+        }
+    }
+    return total_relevance;
+}
+
+template<typename Policy>
+double RunFindTopDocumentsWithPredicate(const SearchServer& search_server, const vector<string>& queries,
+        Policy policy)
+{
+    double total_relevance = 0;
+    for (const string& query : queries) {
+        const auto documents = search_server.FindTopDocuments(policy, query,
+                [](int document_id, DocumentStatus status, int rating) {
+                    return status == DocumentStatus::ACTUAL && rating > 0 && document_id % 2 == 0;
+                });
+        for (const Document& document : documents) {
+            total_relevance += document.relevance;
+        }
+    }
+    return total_relevance;
+}
+
+//Тот же отбор, что и в RunFindTopDocumentsWithPredicate, но через DocumentFilter
+template<typename Policy>
+double RunFindTopDocumentsWithFilter(const SearchServer& search_server, const vector<string>& queries, Policy policy)
+{
+    const DocumentFilter filter = DocumentFilter::StatusIn({DocumentStatus::ACTUAL})
+                                  && DocumentFilter::RatingAtLeast(1) && DocumentFilter::IdModulo(2, 0);
+    double total_relevance = 0;
+    for (const string& query : queries) {
+        for (const Document& document : search_server.FindTopDocuments(policy, query, filter)) {
+            total_relevance += document.relevance;
+        }
+    }
+    return total_relevance;
+}
+
+template<typename Policy>
+double RunMatchDocument(const SearchServer& search_server, const vector<string>& queries, int corpus_size,
+        Policy policy)
+{
+    size_t matched_count = 0;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        const int document_id = static_cast<int>(i * 7919 % corpus_size);
+        const auto [words, status] = search_server.MatchDocument(policy, queries[i], document_id);
+        matched_count += words.size();
+    }
+    return static_cast<double>(matched_count);
+}
+
+//Подсветка выдачи: каждый запрос сопоставляется с MATCH_BATCH_SIZE документами
+const int MATCH_BATCH_SIZE = 64;
+
+template<typename Policy>
+double RunMatchDocuments(const SearchServer& search_server, const vector<string>& queries, int corpus_size,
+        Policy policy, bool is_batched)
+{
+    size_t matched_count = 0;
+    vector<int> document_ids(MATCH_BATCH_SIZE);
+    vector<tuple<vector<string_view>, DocumentStatus>> results;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        for (int k = 0; k < MATCH_BATCH_SIZE; ++k) {
+            document_ids[k] = static_cast<int>((i * 7919 + k * 104729) % corpus_size);
+        }
+        if (is_batched) {
+            search_server.MatchDocuments(policy, queries[i], document_ids, results);
+        }
+        else {
+            results.clear();
+            for (const int document_id : document_ids) {
+                results.push_back(search_server.MatchDocument(policy, queries[i], document_id));
+            }
+        }
+        for (const auto& [words, status] : results) {
+            matched_count += words.size();
+        }
+    }
+    return static_cast<double>(matched_count);
+}
+
+vector<BenchmarkResult> RunBenchmarks(const BenchmarkConfig& config)
+{
+    vector<BenchmarkResult> results;
+    for (const int corpus_size : config.corpus_sizes) {
+        const Corpus corpus = GenerateCorpus(config, corpus_size);
+        const size_t query_count = corpus.queries.size();
+        auto add_result = [&](const string& name, size_t operations, Statistics statistics) {
+            results.push_back({name, corpus_size, operations, statistics});
+        };
+        
+        add_result("AddDocument", corpus.documents.size(), Measure(config.repetitions, [] { return 0; },
+                [&](int) { return static_cast<double>(BuildServer(corpus)->GetDocumentCount()); }));
+        
+        const auto search_server = BuildServer(corpus);
+        auto no_setup = [] { return 0; };
+        add_result("FindTopDocuments/seq/status", query_count, Measure(config.repetitions, no_setup,
+                [&](int) { return RunFindTopDocuments(*search_server, corpus.queries, execution::seq); }));
+        add_result("FindTopDocuments/par/status", query_count, Measure(config.repetitions, no_setup,
+                [&](int) { return RunFindTopDocuments(*search_server, corpus.queries, execution::par); }));
+        add_result("FindTopDocuments/seq/predicate", query_count, Measure(config.repetitions, no_setup,
+                [&](int) { return RunFindTopDocumentsWithPredicate(*search_server, corpus.queries, execution::seq); }));
+        add_result("FindTopDocuments/par/predicate", query_count, Measure(config.repetitions, no_setup,
+                [&](int) { return RunFindTopDocumentsWithPredicate(*search_server, corpus.queries, execution::par); }));
+        add_result("FindTopDocuments/seq/filter", query_count, Measure(config.repetitions, no_setup,
+                [&](int) { return RunFindTopDocumentsWithFilter(*search_server, corpus.queries, execution::seq); }));
+        add_result("FindTopDocuments/par/filter", query_count, Measure(config.repetitions, no_setup,
+                [&](int) { return RunFindTopDocumentsWithFilter(*search_server, corpus.queries, execution::par); }));
+        const vector<string> required_queries = MakeRequiredQueries(corpus.queries, 2);
+        add_result("FindTopDocuments/seq/required", query_count, Measure(config.repetitions, no_setup,
+                [&](int) { return RunFindTopDocuments(*search_server, required_queries, execution::seq); }));
+        add_result("FindTopDocuments/par/required", query_count, Measure(config.repetitions, no_setup,
+                [&](int) { return RunFindTopDocuments(*search_server, required_queries, execution::par); }));
+        add_result("MatchDocument/seq", query_count, Measure(config.repetitions, no_setup,
+                [&](int) { return RunMatchDocument(*search_server, corpus.queries, corpus_size, execution::seq); }));
+        add_result("MatchDocument/par", query_count, Measure(config.repetitions, no_setup,
+                [&](int) { return RunMatchDocument(*search_server, corpus.queries, corpus_size, execution::par); }));
+        add_result("MatchDocuments/seq/one_by_one", query_count * MATCH_BATCH_SIZE, Measure(config.repetitions,
+                no_setup, [&](int) {
+                    return RunMatchDocuments(*search_server, corpus.queries, corpus_size, execution::seq, false);
+                }));
+        add_result("MatchDocuments/seq", query_count * MATCH_BATCH_SIZE, Measure(config.repetitions, no_setup,
+                [&](int) { return RunMatchDocuments(*search_server, corpus.queries, corpus_size, execution::seq, true); }));
+        add_result("MatchDocuments/par", query_count * MATCH_BATCH_SIZE, Measure(config.repetitions, no_setup,
+                [&](int) { return RunMatchDocuments(*search_server, corpus.queries, corpus_size, execution::par, true); }));
+        add_result("ProcessQueries", query_count, Measure(config.repetitions, no_setup, [&](int) {
+            return static_cast<double>(ProcessQueriesJoinedInVector(*search_server, corpus.queries).size());
+        }));
+        
+        //Удаляется каждый второй документ; построение сервера в замер не входит
+        const size_t removed_count = (corpus.documents.size() + 1) / 2;
+        auto build = [&] { return BuildServer(corpus); };
+        add_result("RemoveDocument/seq", removed_count, Measure(config.repetitions, build,
+                [&](unique_ptr<SearchServer>& server) {
+                    for (size_t id = 0; id < corpus.documents.size(); id += 2) {
+                        server->RemoveDocument(execution::seq, static_cast<int>(id));
+                    }
+                    return static_cast<double>(server->GetDocumentCount());
+                }));
+        add_result("RemoveDocument/par", removed_count, Measure(config.repetitions, build,
+                [&](unique_ptr<SearchServer>& server) {
+                    for (size_t id = 0; id < corpus.documents.size(); id += 2) {
+                        server->RemoveDocument(execution::par, static_cast<int>(id));
+                    }
+                    return static_cast<double>(server->GetDocumentCount());
+                }));
+        
+        add_result("ReorderDocuments", corpus.documents.size(), Measure(config.repetitions, build,
+                [&](unique_ptr<SearchServer>& server) {
+                    server->ReorderDocuments();
+                    return server->GetMemoryUsage().GetAverageGapBits();
+                }));
+        //Тот же поиск после перенумерации документов
+        search_server->ReorderDocuments();
+        add_result("FindTopDocuments/seq/status/reordered", query_count, Measure(config.repetitions, no_setup,
+                [&](int) { return RunFindTopDocuments(*search_server, corpus.queries, execution::seq); }));
+        
+        //RemoveDuplicates печатает удалённые id в cout, который занят под JSON
+        add_result("RemoveDuplicates", corpus.documents.size(), Measure(config.repetitions, build,
+                [&](unique_ptr<SearchServer>& server) {
+                    ostringstream discarded;
+                    auto* const cout_buffer = cout.rdbuf(discarded.rdbuf());
+                    RemoveDuplicates(*server);
+                    cout.rdbuf(cout_buffer);
+                    return static_cast<double>(server->GetDocumentCount());
+                }));
+    }
+    return results;
+}
+
+void PrintJson(ostream& out, const BenchmarkConfig& config, const vector<BenchmarkResult>& results)
+{
+    out << fixed << setprecision(4);
+    out << "{\n";
+    out << "  \"seed\": " << config.seed << ",\n";
+    out << "  \"repetitions\": " << config.repetitions << ",\n";
+    out << "  \"dictionary_size\": " << config.dictionary_size << ",\n";
+    out << "  \"document_word_count\": " << config.document_word_count << ",\n";
+    out << "  \"query_word_count\": " << config.query_word_count << ",\n";
+    out << "  \"zipf_exponent\": " << config.zipf_exponent << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        const Statistics& statistics = result.statistics;
+        out << "    {\"name\": \"" << result.name << "\", \"corpus_size\": " << result.corpus_size
+                << ", \"operations\": " << result.operations
+                << ", \"min_ms\": " << statistics.min_ms
+                << ", \"median_ms\": " << statistics.median_ms
+                << ", \"mean_ms\": " << statistics.mean_ms
+                << ", \"stddev_ms\": " << statistics.stddev_ms
+                << ", \"max_ms\": " << statistics.max_ms << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    BenchmarkConfig config;
+    try {
+        if (argc > 1) { config.repetitions = stoi(argv[1]); }
+        if (argc > 2) { config.seed = static_cast<uint32_t>(stoul(argv[2])); }
+        if (argc > 3) {
+            config.corpus_sizes.clear();
+            for (int i = 3; i < argc; ++i) {
+                config.corpus_sizes.push_back(stoi(argv[i]));
+            }
+        }
+    }
+    catch (const exception&) {
+        cerr << "Usage: search_benchmark [repetitions] [seed] [corpus_size...]" << endl;
+        return 1;
+    }
+    if (config.repetitions <= 0 || any_of(config.corpus_sizes.begin(), config.corpus_sizes.end(),
+            [](int size) { return size <= 0; })) {
+        cerr << "Repetitions and corpus sizes must be greater than zero." << endl;
+        return 1;
+    }
+    PrintJson(cout, config, RunBenchmarks(config));
+}
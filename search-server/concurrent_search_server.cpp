@@ -0,0 +1,79 @@
+#include "concurrent_search_server.h"
+
+#include <thread>
+
+ConcurrentSearchServer::ConcurrentSearchServer(const std::string& stop_words_text) : servers_{
+        SearchServer(stop_words_text), SearchServer(stop_words_text)} {}
+
+void ConcurrentSearchServer::AddDocument(int document_id, const std::string_view& document, DocumentStatus status,
+        const std::vector<int>& ratings)
+{
+    Write([document_id, &document, status, &ratings](SearchServer& server) {
+        server.AddDocument(document_id, document, status, ratings);
+    });
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id)
+{
+    Write([document_id](SearchServer& server) {
+        server.RemoveDocument(document_id);
+    });
+}
+
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(const std::string_view& raw_query,
+        DocumentStatus status) const
+{
+    return Read([&raw_query, status](const SearchServer& server) {
+        return server.FindTopDocuments(raw_query, status);
+    });
+}
+
+std::vector<Document> ConcurrentSearchServer::FindTopDocuments(const std::string_view& raw_query) const
+{
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::tuple<std::vector<std::string>, DocumentStatus> ConcurrentSearchServer::MatchDocument(
+        const std::string_view& raw_query, int document_id) const
+{
+    return Read([&raw_query, document_id](const SearchServer& server) {
+        const auto [words, status] = server.MatchDocument(raw_query, document_id);
+        return std::tuple(std::vector<std::string>(words.begin(), words.end()), status);
+    });
+}
+
+int ConcurrentSearchServer::GetDocumentCount() const
+{
+    return Read([](const SearchServer& server) {
+        return server.GetDocumentCount();
+    });
+}
+
+void ConcurrentSearchServer::WaitForReaders(size_t index) const
+{
+    while (readers_[index].count.load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+ConcurrentSearchServer::ReadGuard::ReadGuard(const ConcurrentSearchServer& server) : server_(server)
+{
+    //После увеличения счётчика проверяем, что копия всё ещё активна: иначе писатель мог
+    //не увидеть нас и уже начать её изменять
+    while (true) {
+        index_ = server_.active_index_.load();
+        server_.readers_[index_].count.fetch_add(1);
+        if (server_.active_index_.load() == index_) { return; }
+        server_.readers_[index_].count.fetch_sub(1);
+    }
+}
+
+ConcurrentSearchServer::ReadGuard::~ReadGuard()
+{
+    server_.readers_[index_].count.fetch_sub(1);
+}
+
+size_t ConcurrentSearchServer::ReadGuard::GetIndex() const
+{
+    return index_;
+}
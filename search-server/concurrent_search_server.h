@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "search_server.h"
+
+//Поисковый сервер, который можно читать во время добавления и удаления документов (схема left-right).
+//Хранит две копии индекса. Читатель закрепляет активную копию и работает с ней без блокировок:
+//пока он её держит, копия не меняется. Писатель изменяет неактивную копию, атомарно делает её активной,
+//дожидается ухода читателей со старой копии и повторяет изменение на ней.
+//Запросы не ждут писателей, писатели ждут только завершения уже начатых запросов.
+//Цена - двойной объём памяти и двойная работа при изменении
+class ConcurrentSearchServer
+{
+public:
+    explicit ConcurrentSearchServer(const std::string& stop_words_text);
+    
+    template<typename StringContainer>
+    explicit ConcurrentSearchServer(const StringContainer& stop_words) : servers_{SearchServer(stop_words),
+            SearchServer(stop_words)} {}
+    
+    ConcurrentSearchServer(const ConcurrentSearchServer&) = delete;
+    
+    ConcurrentSearchServer& operator=(const ConcurrentSearchServer&) = delete;
+    
+    //Добавление и удаление выполняются по одному; при исключении сервер не меняется
+    void AddDocument(int document_id, const std::string_view& document, DocumentStatus status,
+            const std::vector<int>& ratings);
+    
+    void RemoveDocument(int document_id);
+    
+    //Вызывает func(const SearchServer&) для закреплённой версии индекса. Ссылки и string_view,
+    //полученные от сервера, действительны только внутри func
+    template<typename Function>
+    auto Read(Function func) const
+    {
+        const ReadGuard guard(*this);
+        return func(servers_[guard.GetIndex()]);
+    }
+    
+    template<typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query,
+            DocumentPredicate document_predicate) const
+    {
+        return Read([&raw_query, &document_predicate](const SearchServer& server) {
+            return server.FindTopDocuments(raw_query, document_predicate);
+        });
+    }
+    
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentStatus status) const;
+    
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query) const;
+    
+    //Слова копируются, потому что версия индекса освобождается после возврата
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(const std::string_view& raw_query,
+            int document_id) const;
+    
+    int GetDocumentCount() const;
+
+private:
+    //Закрепляет активную копию на время жизни
+    class ReadGuard
+    {
+    public:
+        explicit ReadGuard(const ConcurrentSearchServer& server);
+        
+        ReadGuard(const ReadGuard&) = delete;
+        
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        
+        ~ReadGuard();
+        
+        size_t GetIndex() const;
+
+    private:
+        const ConcurrentSearchServer& server_;
+        size_t index_;
+    };
+    
+    //Счётчики в разных кэш-линиях, чтобы читатели разных копий не мешали друг другу
+    struct alignas(64) ReaderCount
+    {
+        std::atomic<int64_t> count{0};
+    };
+    
+    SearchServer servers_[2];
+    std::atomic<size_t> active_index_{0};
+    mutable ReaderCount readers_[2];
+    std::mutex write_mutex_;
+    
+    //Применяет update(SearchServer&) к обеим копиям. update должен давать одинаковый результат на обеих
+    template<typename Update>
+    void Write(Update update)
+    {
+        std::lock_guard guard(write_mutex_);
+        const size_t old_index = active_index_.load();
+        const size_t new_index = 1 - old_index;
+        //Исключение здесь оставляет обе копии неизменными
+        update(servers_[new_index]);
+        active_index_.store(new_index);
+        WaitForReaders(old_index);
+        update(servers_[old_index]);
+    }
+    
+    void WaitForReaders(size_t index) const;
+};
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "corpus_generator.h"
+
+std::string GenerateWord(std::mt19937& generator, int max_length)
+{
+    const int length = std::uniform_int_distribution(1, max_length)(generator);
+    std::string word;
+    word.reserve(length);
+    for (int i = 0; i < length; ++i) {
+        word.push_back(std::uniform_int_distribution('a', 'z')(generator));
+    }
+    return word;
+}
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length)
+{
+    std::vector<std::string> words;
+    words.reserve(word_count);
+    for (int i = 0; i < word_count; ++i) {
+        words.push_back(GenerateWord(generator, max_length));
+    }
+    words.erase(unique(words.begin(), words.end()), words.end());
+    return words;
+}
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count,
+        double minus_prob)
+{
+    std::string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (std::uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += dictionary[std::uniform_int_distribution<int>(0, dictionary.size() - 1)(generator)];
+    }
+    return query;
+}
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+        int query_count, int max_word_count)
+{
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateQuery(generator, dictionary, max_word_count));
+    }
+    return queries;
+}
+
+ZipfWordSampler::ZipfWordSampler(const std::vector<std::string>& dictionary, double exponent) : dictionary_(
+        dictionary)
+{
+    if (dictionary.empty()) { throw std::invalid_argument("Dictionary cannot be empty."); }
+    std::vector<double> weights(dictionary.size());
+    for (size_t rank = 0; rank < weights.size(); ++rank) {
+        weights[rank] = 1.0 / std::pow(static_cast<double>(rank + 1), exponent);
+    }
+    distribution_ = std::discrete_distribution<size_t>(weights.begin(), weights.end());
+}
+
+const std::string& ZipfWordSampler::operator()(std::mt19937& generator)
+{
+    return dictionary_[distribution_(generator)];
+}
+
+std::string GenerateZipfQuery(std::mt19937& generator, ZipfWordSampler& sampler, int word_count, double minus_prob)
+{
+    std::string query;
+    for (int i = 0; i < word_count; ++i) {
+        if (!query.empty()) {
+            query.push_back(' ');
+        }
+        if (std::uniform_real_distribution<>(0, 1)(generator) < minus_prob) {
+            query.push_back('-');
+        }
+        query += sampler(generator);
+    }
+    return query;
+}
+
+std::vector<std::string> GenerateZipfQueries(std::mt19937& generator, ZipfWordSampler& sampler, int query_count,
+        int word_count, double minus_prob)
+{
+    std::vector<std::string> queries;
+    queries.reserve(query_count);
+    for (int i = 0; i < query_count; ++i) {
+        queries.push_back(GenerateZipfQuery(generator, sampler, word_count, minus_prob));
+    }
+    return queries;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <random>
+#include <string>
+#include <vector>
+
+std::string GenerateWord(std::mt19937& generator, int max_length);
+
+std::vector<std::string> GenerateDictionary(std::mt19937& generator, int word_count, int max_length);
+
+std::string GenerateQuery(std::mt19937& generator, const std::vector<std::string>& dictionary, int word_count,
+        double minus_prob = 0);
+
+std::vector<std::string> GenerateQueries(std::mt19937& generator, const std::vector<std::string>& dictionary,
+        int query_count, int max_word_count);
+
+//Выбор слов словаря по закону Ципфа: слово с рангом r выпадает с вероятностью ~ 1 / r^exponent
+class ZipfWordSampler
+{
+public:
+    ZipfWordSampler(const std::vector<std::string>& dictionary, double exponent);
+    
+    const std::string& operator()(std::mt19937& generator);
+
+private:
+    const std::vector<std::string>& dictionary_;
+    std::discrete_distribution<size_t> distribution_;
+};
+
+std::string GenerateZipfQuery(std::mt19937& generator, ZipfWordSampler& sampler, int word_count,
+        double minus_prob = 0);
+
+std::vector<std::string> GenerateZipfQueries(std::mt19937& generator, ZipfWordSampler& sampler, int query_count,
+        int word_count, double minus_prob = 0);
@@ -0,0 +1,217 @@
+#include "corpus_loader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <fcntl.h>
+#include <future>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "thread_pool.h"
+
+namespace {
+
+//Части не меньше мегабайта, чтобы накладные расходы задач были незаметны
+const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+const char* const STATUS_NAMES[] = {"ACTUAL", "IRRELEVANT", "BANNED", "REMOVED"};
+
+std::string MakeErrorMessage(const std::string& message)
+{
+    return message + ": " + std::strerror(errno);
+}
+
+[[noreturn]] void ThrowFormatError(size_t offset, const std::string& message)
+{
+    throw std::invalid_argument("Corpus record at offset " + std::to_string(offset) + ": " + message);
+}
+
+//Отделяет от line поле до табуляции
+std::string_view TakeField(std::string_view& line, size_t offset)
+{
+    const size_t tab_pos = line.find('\t');
+    if (tab_pos == std::string_view::npos) { ThrowFormatError(offset, "expected 4 tab-separated fields."); }
+    const std::string_view field = line.substr(0, tab_pos);
+    line.remove_prefix(tab_pos + 1);
+    return field;
+}
+
+int ParseInt(std::string_view text, size_t offset)
+{
+    int value = 0;
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (error != std::errc() || end != text.data() + text.size()) {
+        ThrowFormatError(offset, "\"" + std::string(text) + "\" is not an integer.");
+    }
+    return value;
+}
+
+DocumentStatus ParseStatus(std::string_view text, size_t offset)
+{
+    for (size_t i = 0; i < std::size(STATUS_NAMES); ++i) {
+        if (text == STATUS_NAMES[i]) { return static_cast<DocumentStatus>(i); }
+    }
+    ThrowFormatError(offset, "unknown status \"" + std::string(text) + "\".");
+}
+
+DocumentRecord ParseRecord(std::string_view line, size_t offset)
+{
+    DocumentRecord document;
+    document.id = ParseInt(TakeField(line, offset), offset);
+    document.status = ParseStatus(TakeField(line, offset), offset);
+    std::string_view ratings = TakeField(line, offset);
+    while (!ratings.empty()) {
+        const size_t space_pos = ratings.find(' ');
+        const std::string_view rating = ratings.substr(0, space_pos);
+        if (!rating.empty()) { document.ratings.push_back(ParseInt(rating, offset)); }
+        ratings.remove_prefix(space_pos == std::string_view::npos ? ratings.size() : space_pos + 1);
+    }
+    document.text = line;
+    return document;
+}
+
+//chunk начинается с начала строки, offset - его смещение от начала корпуса
+std::vector<DocumentRecord> ParseChunk(std::string_view chunk, size_t offset)
+{
+    std::vector<DocumentRecord> documents;
+    while (!chunk.empty()) {
+        const size_t line_end = std::min(chunk.find('\n'), chunk.size());
+        std::string_view line = chunk.substr(0, line_end);
+        if (!line.empty() && line.back() == '\r') { line.remove_suffix(1); }
+        if (!line.empty()) { documents.push_back(ParseRecord(line, offset)); }
+        const size_t next = std::min(line_end + 1, chunk.size());
+        chunk.remove_prefix(next);
+        offset += next;
+    }
+    return documents;
+}
+
+} // namespace
+
+MappedFile::MappedFile(const std::string& path)
+{
+    const int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) { throw std::runtime_error(MakeErrorMessage("Cannot open " + path)); }
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) < 0) {
+        const std::string message = MakeErrorMessage("Cannot stat " + path);
+        close(fd);
+        throw std::runtime_error(message);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    //Пустой файл отобразить нельзя, он читается как пустая строка
+    if (size_ != 0) {
+        data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data_ == MAP_FAILED) {
+            const std::string message = MakeErrorMessage("Cannot map " + path);
+            close(fd);
+            throw std::runtime_error(message);
+        }
+        madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (size_ != 0) {
+        munmap(data_, size_);
+    }
+}
+
+std::string_view MappedFile::GetData() const
+{
+    return {static_cast<const char*>(data_), size_};
+}
+
+std::vector<DocumentRecord> ParseCorpus(std::string_view data, size_t chunk_count)
+{
+    chunk_count = std::max<size_t>(1, std::min(chunk_count, data.size() / MIN_CHUNK_SIZE));
+    //Граница части сдвигается на начало следующей строки
+    std::vector<size_t> bounds{0};
+    for (size_t i = 1; i < chunk_count; ++i) {
+        const size_t line_end = data.find('\n', std::max(bounds.back(), data.size() / chunk_count * i));
+        if (line_end == std::string_view::npos) { break; }
+        bounds.push_back(line_end + 1);
+    }
+    bounds.push_back(data.size());
+
+    std::vector<std::future<std::vector<DocumentRecord>>> futures;
+    for (size_t i = 0; i + 1 < bounds.size(); ++i) {
+        futures.push_back(ThreadPool::Shared().Submit([data, begin = bounds[i], end = bounds[i + 1]]() {
+            return ParseChunk(data.substr(begin, end - begin), begin);
+        }));
+    }
+    //Дожидаемся всех частей, даже если одна из них завершилась ошибкой: они читают data,
+    //которую вызывающий освободит при исключении
+    std::vector<std::vector<DocumentRecord>> chunks;
+    std::exception_ptr error;
+    for (auto& future : futures) {
+        try {
+            chunks.push_back(future.get());
+        }
+        catch (...) {
+            if (!error) { error = std::current_exception(); }
+        }
+    }
+    if (error) { std::rethrow_exception(error); }
+    if (chunks.size() == 1) {
+        return std::move(chunks.front());
+    }
+    std::vector<DocumentRecord> documents;
+    size_t document_count = 0;
+    for (const auto& chunk : chunks) {
+        document_count += chunk.size();
+    }
+    documents.reserve(document_count);
+    for (auto& chunk : chunks) {
+        std::move(chunk.begin(), chunk.end(), std::back_inserter(documents));
+    }
+    return documents;
+}
+
+std::string FormatCorpusRecord(const DocumentRecord& document)
+{
+    std::string record = std::to_string(document.id);
+    record += '\t';
+    record += STATUS_NAMES[static_cast<int>(document.status)];
+    record += '\t';
+    for (size_t i = 0; i < document.ratings.size(); ++i) {
+        if (i != 0) { record += ' '; }
+        record += std::to_string(document.ratings[i]);
+    }
+    record += '\t';
+    record += document.text;
+    record += '\n';
+    return record;
+}
+
+double CorpusLoadStats::GetMegabytesPerSecond() const
+{
+    const double seconds = parse_seconds + index_seconds;
+    return seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0;
+}
+
+CorpusLoadStats LoadCorpus(const std::string& path, SearchServer& search_server)
+{
+    using Clock = std::chrono::steady_clock;
+    CorpusLoadStats stats;
+    const MappedFile file(path);
+    const std::string_view data = file.GetData();
+    stats.bytes = data.size();
+
+    const Clock::time_point parse_start = Clock::now();
+    //Частей больше, чем потоков, чтобы потоки не простаивали из-за неравных частей
+    const std::vector<DocumentRecord> documents = ParseCorpus(data, ThreadPool::Shared().GetThreadCount() * 4);
+    const Clock::time_point index_start = Clock::now();
+    search_server.AddDocuments(std::execution::par, documents);
+    stats.index_seconds = std::chrono::duration<double>(Clock::now() - index_start).count();
+    stats.parse_seconds = std::chrono::duration<double>(index_start - parse_start).count();
+    stats.document_count = documents.size();
+    return stats;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document.h"
+#include "search_server.h"
+
+//Файл корпуса: по документу в строке, поля разделены табуляцией: "<id>\t<status>\t<ratings>\t<text>".
+//status - ACTUAL, IRRELEVANT, BANNED или REMOVED, ratings - целые числа через пробел (может быть пусто).
+//Пустые строки пропускаются
+
+//Файл, отображённый в память только для чтения
+class MappedFile
+{
+public:
+    //Бросает std::runtime_error
+    explicit MappedFile(const std::string& path);
+    
+    MappedFile(const MappedFile&) = delete;
+    
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    ~MappedFile();
+    
+    std::string_view GetData() const;
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+//Разбивает data на chunk_count частей по границам строк и разбирает их параллельно в общем пуле потоков.
+//Тексты документов указывают в data, поэтому data должна пережить результат.
+//Ошибка формата - std::invalid_argument со смещением записи от начала data
+std::vector<DocumentRecord> ParseCorpus(std::string_view data, size_t chunk_count);
+
+//Строка корпуса с документом, включая перевод строки
+std::string FormatCorpusRecord(const DocumentRecord& document);
+
+struct CorpusLoadStats
+{
+    size_t bytes = 0;
+    size_t document_count = 0;
+    double parse_seconds = 0;
+    double index_seconds = 0;
+    
+    //Пропускная способность загрузки целиком: разбор и добавление в индекс
+    double GetMegabytesPerSecond() const;
+};
+
+//Отображает файл в память, разбирает его параллельно и добавляет документы пакетом.
+//Ошибки чтения - std::runtime_error, ошибки формата и документов - std::invalid_argument;
+//при ошибке сервер не меняется
+CorpusLoadStats LoadCorpus(const std::string& path, SearchServer& search_server);
@@ -0,0 +1,23 @@
+#include <cmath>
+#include "corpus_statistics.h"
+
+void CorpusStatistics::Merge(const CorpusStatistics& other)
+{
+    document_count += other.document_count;
+    for (const auto& [word, document_freq] : other.document_freqs) {
+        auto it = document_freqs.find(word);
+        if (it == document_freqs.end()) {
+            document_freqs.emplace(word, document_freq);
+        }
+        else {
+            it->second += document_freq;
+        }
+    }
+}
+
+double CorpusStatistics::ComputeInverseDocumentFreq(std::string_view word) const
+{
+    const auto it = document_freqs.find(word);
+    if (it == document_freqs.end() || it->second == 0) { return 0.0; }
+    return std::log(document_count * 1.0 / it->second);
+}
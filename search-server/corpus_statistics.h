@@ -0,0 +1,19 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <string_view>
+
+//Статистика корпуса для вычисления IDF, общая для нескольких серверов (шардов)
+struct CorpusStatistics
+{
+    int document_count = 0;
+    //Слово -> число документов с этим словом
+    std::map<std::string, int, std::less<>> document_freqs;
+    
+    void Merge(const CorpusStatistics& other);
+    
+    //Для слова без документов - 0: слово не влияет на релевантность. Так бывает, если документ со словом
+    //добавлен на шард после сбора статистики
+    double ComputeInverseDocumentFreq(std::string_view word) const;
+};
@@ -1,3 +1,4 @@
+#include <stdexcept>
 #include "document.h"
 
 std::ostream& operator<<(std::ostream& os, const Document& document)
@@ -7,3 +8,22 @@ std::ostream& operator<<(std::ostream& os, const Document& document)
             << document.rating << " }"s;
     return os;
 }
+
+SearchCursor SearchCursor::After(const Document& document)
+{
+    SearchCursor cursor;
+    cursor.is_at_start_ = false;
+    cursor.last_document_ = document;
+    return cursor;
+}
+
+bool SearchCursor::IsAtStart() const
+{
+    return is_at_start_;
+}
+
+const Document& SearchCursor::GetLastDocument() const
+{
+    if (is_at_start_) { throw std::logic_error("Search cursor is at the start of the results."); }
+    return last_document_;
+}
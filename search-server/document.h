@@ -1,6 +1,8 @@
 #pragma once
 
 #include <iostream>
+#include <string_view>
+#include <vector>
 
 struct Document
 {
@@ -15,7 +17,38 @@ struct Document
     friend std::ostream& operator<<(std::ostream& os, const Document& document);
 };
 
+//Позиция в выдаче для постраничного поиска: следующая страница начинается с документа,
+//идущего за курсором в порядке SearchServer::CompareByRelevance.
+//Курсор по умолчанию указывает на начало выдачи
+class SearchCursor
+{
+public:
+    SearchCursor() = default;
+    
+    //Курсор за документом; запоминаются его релевантность, рейтинг и id
+    static SearchCursor After(const Document& document);
+    
+    bool IsAtStart() const;
+    
+    //Для курсора в начале выдачи бросает std::logic_error
+    const Document& GetLastDocument() const;
+
+private:
+    bool is_at_start_ = true;
+    Document last_document_;
+};
+
 enum class DocumentStatus
 {
     ACTUAL, IRRELEVANT, BANNED, REMOVED,
+};
+
+//Документ для пакетного добавления
+struct DocumentRecord
+{
+    int id = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+    //Текст не копируется и должен существовать, пока документ добавляется
+    std::string_view text;
 };
\ No newline at end of file
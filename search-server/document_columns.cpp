@@ -0,0 +1,133 @@
+#include "document_columns.h"
+
+#include <algorithm>
+#include "memory_usage.h"
+
+namespace {
+
+//Таблица прямой адресации может быть больше числа документов не более чем во столько раз (плюс запас)
+const size_t MAX_DENSE_OVERHEAD = 4;
+const size_t DENSE_SLACK = 1024;
+
+} // namespace
+
+DocumentColumns::DocumentColumns(std::pmr::memory_resource* resource) : ids_(resource), ratings_(resource),
+        statuses_(resource), dense_ordinals_(resource), sparse_ordinals_(resource) {}
+
+void DocumentColumns::Insert(int document_id, int rating, DocumentStatus status)
+{
+    const int ordinal = static_cast<int>(ids_.size());
+    ids_.push_back(document_id);
+    ratings_.push_back(rating);
+    statuses_.push_back(static_cast<uint8_t>(status));
+    GrowDenseOrdinals(document_id);
+    SetOrdinal(document_id, ordinal);
+}
+
+bool DocumentColumns::Erase(int document_id)
+{
+    const int ordinal = FindOrdinal(document_id);
+    if (ordinal < 0) { return false; }
+    //Последний документ переносится на место удалённого
+    const int last_id = ids_.back();
+    ids_[ordinal] = last_id;
+    ratings_[ordinal] = ratings_.back();
+    statuses_[ordinal] = statuses_.back();
+    SetOrdinal(last_id, ordinal);
+    ids_.pop_back();
+    ratings_.pop_back();
+    statuses_.pop_back();
+    if (static_cast<size_t>(document_id) < dense_ordinals_.size()) {
+        dense_ordinals_[document_id] = -1;
+    }
+    else {
+        sparse_ordinals_.erase(document_id);
+    }
+    return true;
+}
+
+void DocumentColumns::Reorder(const std::vector<int>& order)
+{
+    std::pmr::vector<int> ids(ids_.get_allocator());
+    std::pmr::vector<int32_t> ratings(ratings_.get_allocator());
+    std::pmr::vector<uint8_t> statuses(statuses_.get_allocator());
+    ids.reserve(order.size());
+    ratings.reserve(order.size());
+    statuses.reserve(order.size());
+    for (const int ordinal : order) {
+        ids.push_back(ids_[ordinal]);
+        ratings.push_back(ratings_[ordinal]);
+        statuses.push_back(statuses_[ordinal]);
+    }
+    ids_ = std::move(ids);
+    ratings_ = std::move(ratings);
+    statuses_ = std::move(statuses);
+    for (size_t ordinal = 0; ordinal < ids_.size(); ++ordinal) {
+        SetOrdinal(ids_[ordinal], static_cast<int>(ordinal));
+    }
+}
+
+const std::pmr::vector<int>& DocumentColumns::GetIdColumn() const
+{
+    return ids_;
+}
+
+const std::pmr::vector<int32_t>& DocumentColumns::GetRatingColumn() const
+{
+    return ratings_;
+}
+
+const std::pmr::vector<uint8_t>& DocumentColumns::GetStatusColumn() const
+{
+    return statuses_;
+}
+
+size_t DocumentColumns::size() const
+{
+    return ids_.size();
+}
+
+size_t DocumentColumns::GetBytes() const
+{
+    return EstimateAllocationBytes(ids_.capacity() * sizeof(int))
+           + EstimateAllocationBytes(ratings_.capacity() * sizeof(int32_t))
+           + EstimateAllocationBytes(statuses_.capacity() * sizeof(uint8_t))
+           + EstimateAllocationBytes(dense_ordinals_.capacity() * sizeof(int))
+           + sparse_ordinals_.size() * EstimateAllocationBytes(2 * sizeof(void*) + 2 * sizeof(int))
+           + EstimateAllocationBytes(sparse_ordinals_.bucket_count() * sizeof(void*));
+}
+
+int DocumentColumns::FindSparseOrdinal(int document_id) const
+{
+    const auto it = sparse_ordinals_.find(document_id);
+    return it == sparse_ordinals_.end() ? -1 : it->second;
+}
+
+void DocumentColumns::SetOrdinal(int document_id, int ordinal)
+{
+    if (static_cast<size_t>(document_id) < dense_ordinals_.size()) {
+        dense_ordinals_[document_id] = ordinal;
+    }
+    else {
+        sparse_ordinals_[document_id] = ordinal;
+    }
+}
+
+void DocumentColumns::GrowDenseOrdinals(int document_id)
+{
+    const size_t id = static_cast<size_t>(document_id);
+    if (id < dense_ordinals_.size() || id >= MAX_DENSE_OVERHEAD * ids_.size() + DENSE_SLACK) { return; }
+    const size_t new_size = std::min(std::max(id + 1, 2 * dense_ordinals_.size()),
+            MAX_DENSE_OVERHEAD * ids_.size() + DENSE_SLACK);
+    dense_ordinals_.resize(new_size, -1);
+    //id из хеш-таблицы, попавшие в таблицу прямой адресации, переносятся в неё
+    for (auto it = sparse_ordinals_.begin(); it != sparse_ordinals_.end();) {
+        if (static_cast<size_t>(it->first) < new_size) {
+            dense_ordinals_[it->first] = it->second;
+            it = sparse_ordinals_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
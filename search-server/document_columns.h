@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "document.h"
+
+//Метаданные документов по столбцам: рейтинги и статусы лежат в плотных массивах по порядковым номерам документов.
+//Номер по id находится в таблице прямой адресации; id, намного большие числа документов, хранятся в хеш-таблице.
+//Удаление переносит последний документ на место удалённого, поэтому номера меняются при удалении и при Reorder
+class DocumentColumns
+{
+public:
+    explicit DocumentColumns(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    
+    //Документа с таким id быть не должно, id не меньше нуля
+    void Insert(int document_id, int rating, DocumentStatus status);
+    
+    //Возвращает false, если документа нет
+    bool Erase(int document_id);
+    
+    //Переставляет документы: order[k] - прежний порядковый номер документа, который получает номер k.
+    //order должен быть перестановкой номеров 0..size() - 1
+    void Reorder(const std::vector<int>& order);
+    
+    //-1, если документа нет
+    int FindOrdinal(int document_id) const
+    {
+        if (document_id >= 0 && static_cast<size_t>(document_id) < dense_ordinals_.size()) {
+            return dense_ordinals_[document_id];
+        }
+        return FindSparseOrdinal(document_id);
+    }
+    
+    //Для несуществующего документа бросает std::out_of_range
+    int GetOrdinal(int document_id) const
+    {
+        const int ordinal = FindOrdinal(document_id);
+        if (ordinal < 0) { throw std::out_of_range("Document is not found."); }
+        return ordinal;
+    }
+    
+    bool Contains(int document_id) const
+    {
+        return FindOrdinal(document_id) >= 0;
+    }
+    
+    int GetId(int ordinal) const
+    {
+        return ids_[ordinal];
+    }
+    
+    int GetRating(int ordinal) const
+    {
+        return ratings_[ordinal];
+    }
+    
+    DocumentStatus GetStatus(int ordinal) const
+    {
+        return static_cast<DocumentStatus>(statuses_[ordinal]);
+    }
+    
+    //Столбцы целиком, по порядковым номерам
+    const std::pmr::vector<int>& GetIdColumn() const;
+    
+    const std::pmr::vector<int32_t>& GetRatingColumn() const;
+    
+    const std::pmr::vector<uint8_t>& GetStatusColumn() const;
+    
+    size_t size() const;
+    
+    //Приблизительная память всех массивов и хеш-таблицы
+    size_t GetBytes() const;
+
+private:
+    std::pmr::vector<int> ids_;
+    std::pmr::vector<int32_t> ratings_;
+    std::pmr::vector<uint8_t> statuses_;
+    //Номер документа по id или -1 для всех id меньше размера таблицы
+    std::pmr::vector<int> dense_ordinals_;
+    //Номера документов с id не меньше размера dense_ordinals_
+    std::pmr::unordered_map<int, int> sparse_ordinals_;
+    
+    int FindSparseOrdinal(int document_id) const;
+    
+    void SetOrdinal(int document_id, int ordinal);
+    
+    //Расширяет таблицу прямой адресации, чтобы в неё попал document_id, если она останется плотной
+    void GrowDenseOrdinals(int document_id);
+};
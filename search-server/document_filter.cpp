@@ -0,0 +1,113 @@
+#include "document_filter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+CandidateBitmap::CandidateBitmap(std::vector<uint64_t> words, size_t size) : words_(std::move(words)), size_(size) {}
+
+size_t CandidateBitmap::Count() const
+{
+    return std::accumulate(words_.begin(), words_.end(), size_t{0}, [](size_t count, uint64_t word) {
+        return count + __builtin_popcountll(word);
+    });
+}
+
+size_t CandidateBitmap::size() const
+{
+    return size_;
+}
+
+DocumentFilter DocumentFilter::StatusIn(std::initializer_list<DocumentStatus> statuses)
+{
+    DocumentFilter filter;
+    filter.status_mask_ = 0;
+    for (const DocumentStatus status : statuses) {
+        filter.status_mask_ |= static_cast<uint8_t>(1u << static_cast<int>(status));
+    }
+    return filter;
+}
+
+DocumentFilter DocumentFilter::RatingAtLeast(int rating)
+{
+    DocumentFilter filter;
+    filter.min_rating_ = rating;
+    return filter;
+}
+
+DocumentFilter DocumentFilter::RatingAtMost(int rating)
+{
+    DocumentFilter filter;
+    filter.max_rating_ = rating;
+    return filter;
+}
+
+DocumentFilter DocumentFilter::IdModulo(int divisor, int remainder)
+{
+    if (divisor <= 0) { throw std::invalid_argument("Id divisor must be greater than zero."); }
+    DocumentFilter filter;
+    filter.id_moduli_.emplace_back(divisor, remainder);
+    return filter;
+}
+
+DocumentFilter operator&&(DocumentFilter lhs, const DocumentFilter& rhs)
+{
+    lhs.status_mask_ &= rhs.status_mask_;
+    lhs.min_rating_ = std::max(lhs.min_rating_, rhs.min_rating_);
+    lhs.max_rating_ = std::min(lhs.max_rating_, rhs.max_rating_);
+    lhs.id_moduli_.insert(lhs.id_moduli_.end(), rhs.id_moduli_.begin(), rhs.id_moduli_.end());
+    return lhs;
+}
+
+bool DocumentFilter::Matches(int document_id, DocumentStatus status, int rating) const
+{
+    return ((status_mask_ >> static_cast<int>(status)) & 1) && rating >= min_rating_ && rating <= max_rating_
+           && std::all_of(id_moduli_.begin(), id_moduli_.end(), [document_id](const std::pair<int, int>& modulo) {
+               return document_id % modulo.first == modulo.second;
+           });
+}
+
+CandidateBitmap DocumentFilter::Evaluate(const DocumentColumns& columns) const
+{
+    const size_t size = columns.size();
+    const int* const ids = columns.GetIdColumn().data();
+    const int32_t* const ratings = columns.GetRatingColumn().data();
+    const uint8_t* const statuses = columns.GetStatusColumn().data();
+
+    //Сначала по байту на документ: циклы без ветвлений над столбцами векторизуются
+    std::vector<uint8_t> passed((size + 63) / 64 * 64, 0);
+    const uint8_t status_mask = status_mask_;
+    const int min_rating = min_rating_;
+    const int max_rating = max_rating_;
+    for (size_t i = 0; i < size; ++i) {
+        passed[i] = ((status_mask >> statuses[i]) & 1) & (ratings[i] >= min_rating) & (ratings[i] <= max_rating);
+    }
+    for (const auto& [divisor, remainder] : id_moduli_) {
+        //id неотрицательны, поэтому для степени двойки остаток - младшие биты
+        if ((divisor & (divisor - 1)) == 0) {
+            const int mask = divisor - 1;
+            for (size_t i = 0; i < size; ++i) {
+                passed[i] &= (ids[i] & mask) == remainder;
+            }
+        }
+        else {
+            for (size_t i = 0; i < size; ++i) {
+                passed[i] &= ids[i] % divisor == remainder;
+            }
+        }
+    }
+
+    //Упаковка: умножение собирает младшие биты восьми байтов в старший байт (порядок байтов little-endian)
+    std::vector<uint64_t> words(passed.size() / 64);
+    for (size_t word = 0; word < words.size(); ++word) {
+        uint64_t bits = 0;
+        for (size_t part = 0; part < 8; ++part) {
+            uint64_t bytes;
+            std::memcpy(&bytes, passed.data() + word * 64 + part * 8, sizeof(bytes));
+            bits |= ((bytes * 0x0102040810204080ULL) >> 56) << (part * 8);
+        }
+        words[word] = bits;
+    }
+    return CandidateBitmap(std::move(words), size);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+#include <vector>
+#include "document.h"
+#include "document_columns.h"
+
+//Множество документов, заданное битами по порядковым номерам DocumentColumns
+class CandidateBitmap
+{
+public:
+    CandidateBitmap() = default;
+    
+    explicit CandidateBitmap(std::vector<uint64_t> words, size_t size);
+    
+    bool Test(int ordinal) const
+    {
+        return (words_[static_cast<size_t>(ordinal) / 64] >> (ordinal % 64)) & 1;
+    }
+    
+    //Число документов в множестве
+    size_t Count() const;
+    
+    //Число порядковых номеров, покрытых картой
+    size_t size() const;
+
+private:
+    std::vector<uint64_t> words_;
+    size_t size_ = 0;
+};
+
+//Фильтр документов по статусу, рейтингу и id - конъюнкция простых условий, например
+//DocumentFilter::StatusIn({ACTUAL, IRRELEVANT}) && DocumentFilter::RatingAtLeast(3) && DocumentFilter::IdModulo(2, 0).
+//В отличие от предиката-лямбды, вызываемого на каждую запись постинга, фильтр вычисляется один раз на запрос
+//циклами без ветвлений по столбцам DocumentColumns, которые компилятор векторизует, и даёт CandidateBitmap.
+//Фильтр по умолчанию пропускает все документы
+class DocumentFilter
+{
+public:
+    DocumentFilter() = default;
+    
+    static DocumentFilter StatusIn(std::initializer_list<DocumentStatus> statuses);
+    
+    static DocumentFilter RatingAtLeast(int rating);
+    
+    static DocumentFilter RatingAtMost(int rating);
+    
+    //id % divisor == remainder. При divisor <= 0 бросает std::invalid_argument
+    static DocumentFilter IdModulo(int divisor, int remainder);
+    
+    //Документ проходит, если проходит оба фильтра
+    friend DocumentFilter operator&&(DocumentFilter lhs, const DocumentFilter& rhs);
+    
+    bool Matches(int document_id, DocumentStatus status, int rating) const;
+    
+    CandidateBitmap Evaluate(const DocumentColumns& columns) const;
+
+private:
+    //Бит i - статус со значением i
+    uint8_t status_mask_ = 0xFF;
+    int min_rating_ = INT_MIN;
+    int max_rating_ = INT_MAX;
+    //Пары делитель, остаток
+    std::vector<std::pair<int, int>> id_moduli_;
+};
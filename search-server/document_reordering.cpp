@@ -0,0 +1,133 @@
+#include "document_reordering.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+//Отрезок не больше этого размера не делится, документы в нём идут в прежнем порядке
+const size_t MIN_PARTITION_SIZE = 16;
+//Наибольшее число раундов обмена между половинами одного отрезка
+const int MAX_SWAP_ROUNDS = 20;
+//Обмен пары документов с меньшим выигрышем - шум округления
+const double MIN_SWAP_GAIN = 1e-9;
+
+using OrderIterator = std::vector<int>::iterator;
+
+class GraphBisection
+{
+public:
+    GraphBisection(const std::vector<std::vector<int>>& document_terms, size_t term_count) : document_terms_(
+            document_terms), left_degrees_(term_count), right_degrees_(term_count), gains_to_right_(term_count),
+            gains_to_left_(term_count) {}
+
+    void Bisect(OrderIterator begin, OrderIterator end)
+    {
+        const size_t size = end - begin;
+        if (size <= MIN_PARTITION_SIZE) {
+            std::sort(begin, end);
+            return;
+        }
+        const OrderIterator middle = begin + size / 2;
+        for (int round = 0; round < MAX_SWAP_ROUNDS && SwapRound(begin, middle, end); ++round) {}
+        Bisect(begin, middle);
+        Bisect(middle, end);
+    }
+
+private:
+    const std::vector<std::vector<int>>& document_terms_;
+    //Число документов со словом в левой и правой половинах
+    std::vector<int> left_degrees_;
+    std::vector<int> right_degrees_;
+    //Выигрыш от переноса документа со словом в другую половину
+    std::vector<double> gains_to_right_;
+    std::vector<double> gains_to_left_;
+    //Слова документов отрезка: только их счётчики нужно обнулить
+    std::vector<int> touched_terms_;
+    std::vector<std::pair<double, int>> left_gains_;
+    std::vector<std::pair<double, int>> right_gains_;
+
+    //Оценка числа бит на постинг слова, которое есть у degree документов половины размера 2^log_size:
+    //разности соседних номеров около size / (degree + 1)
+    static double ComputeCost(int degree, double log_size)
+    {
+        return degree * (log_size - std::log2(degree + 1.0));
+    }
+
+    void CountDegrees(OrderIterator begin, OrderIterator end, std::vector<int>& degrees)
+    {
+        for (OrderIterator it = begin; it != end; ++it) {
+            for (const int term : document_terms_[*it]) {
+                if (left_degrees_[term] == 0 && right_degrees_[term] == 0) {
+                    touched_terms_.push_back(term);
+                }
+                ++degrees[term];
+            }
+        }
+    }
+
+    //Документы половины по убыванию выигрыша от переноса, при равенстве - по возрастанию номера
+    void CollectGains(OrderIterator begin, OrderIterator end, const std::vector<double>& term_gains,
+            std::vector<std::pair<double, int>>& gains) const
+    {
+        gains.clear();
+        for (OrderIterator it = begin; it != end; ++it) {
+            double gain = 0;
+            for (const int term : document_terms_[*it]) {
+                gain += term_gains[term];
+            }
+            gains.emplace_back(-gain, *it);
+        }
+        std::sort(gains.begin(), gains.end());
+    }
+
+    //Обменивает пары документов, пока их суммарный выигрыш положителен. false, если обменов не было
+    bool SwapRound(OrderIterator begin, OrderIterator middle, OrderIterator end)
+    {
+        touched_terms_.clear();
+        CountDegrees(begin, middle, left_degrees_);
+        CountDegrees(middle, end, right_degrees_);
+        const double log_left = std::log2(static_cast<double>(middle - begin));
+        const double log_right = std::log2(static_cast<double>(end - middle));
+        for (const int term : touched_terms_) {
+            const int left = left_degrees_[term];
+            const int right = right_degrees_[term];
+            const double cost = ComputeCost(left, log_left) + ComputeCost(right, log_right);
+            gains_to_right_[term] = left == 0 ? 0
+                    : cost - ComputeCost(left - 1, log_left) - ComputeCost(right + 1, log_right);
+            gains_to_left_[term] = right == 0 ? 0
+                    : cost - ComputeCost(left + 1, log_left) - ComputeCost(right - 1, log_right);
+        }
+        for (const int term : touched_terms_) {
+            left_degrees_[term] = 0;
+            right_degrees_[term] = 0;
+        }
+        CollectGains(begin, middle, gains_to_right_, left_gains_);
+        CollectGains(middle, end, gains_to_left_, right_gains_);
+
+        size_t swap_count = 0;
+        while (swap_count < left_gains_.size() && swap_count < right_gains_.size()
+                && -(left_gains_[swap_count].first + right_gains_[swap_count].first) > MIN_SWAP_GAIN) {
+            ++swap_count;
+        }
+        if (swap_count == 0) { return false; }
+        for (size_t i = 0; i < swap_count; ++i) {
+            std::swap(left_gains_[i].second, right_gains_[i].second);
+        }
+        std::transform(left_gains_.begin(), left_gains_.end(), begin, [](const auto& gain) { return gain.second; });
+        std::transform(right_gains_.begin(), right_gains_.end(), middle, [](const auto& gain) { return gain.second; });
+        return true;
+    }
+};
+
+} // namespace
+
+std::vector<int> ComputeLocalityOrder(const std::vector<std::vector<int>>& document_terms, size_t term_count)
+{
+    std::vector<int> order(document_terms.size());
+    std::iota(order.begin(), order.end(), 0);
+    GraphBisection(document_terms, term_count).Bisect(order.begin(), order.end());
+    return order;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+//Порядок документов, в котором документы с общими словами стоят рядом: рекурсивная бисекция графа
+//документы-слова (Dhulipala et al., 2016). Отрезок документов делится пополам, затем документы несколько раз
+//обмениваются между половинами, пока обмен уменьшает оценку суммарной длины логарифмов разностей соседних
+//номеров в постингах; половины упорядочиваются так же. Разности в постингах становятся меньше,
+//а документы одного постинга - ближе в памяти.
+//document_terms[i] - номера слов документа i без повторов, каждый меньше term_count.
+//Возвращает order: order[k] - документ, который получает номер k
+std::vector<int> ComputeLocalityOrder(const std::vector<std::vector<int>>& document_terms, size_t term_count);
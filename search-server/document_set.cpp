@@ -0,0 +1,386 @@
+#include "document_set.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+//Массив больше 4096 номеров занимает больше битовой карты на 2^16 бит
+const size_t ARRAY_MAX_SIZE = 4096;
+const size_t BITMAP_WORD_COUNT = (1 << 16) / 64;
+
+uint16_t GetKey(int ordinal)
+{
+    return static_cast<uint16_t>(ordinal >> 16);
+}
+
+uint16_t GetLow(int ordinal)
+{
+    return static_cast<uint16_t>(ordinal & 0xFFFF);
+}
+
+} // namespace
+
+DocumentSet::Container::Container(uint16_t key, std::pmr::memory_resource* resource) : key(key), values(resource),
+        bits(resource) {}
+
+DocumentSet::Container::Container(const Container& other, std::pmr::memory_resource* resource) : key(other.key),
+        kind(other.kind), cardinality(other.cardinality), values(other.values, resource), bits(other.bits, resource) {}
+
+DocumentSet::DocumentSet(const allocator_type& allocator) : containers_(allocator.resource()) {}
+
+DocumentSet::DocumentSet(const DocumentSet& other, const allocator_type& allocator) : containers_(
+        allocator.resource()), size_(other.size_)
+{
+    containers_.reserve(other.containers_.size());
+    for (const Container& container : other.containers_) {
+        containers_.emplace_back(container, allocator.resource());
+    }
+}
+
+DocumentSet::DocumentSet(DocumentSet&& other, const allocator_type& allocator) : containers_(
+        std::move(other.containers_), allocator.resource()), size_(other.size_)
+{
+    other.size_ = 0;
+}
+
+void DocumentSet::Insert(int ordinal)
+{
+    const uint16_t key = GetKey(ordinal);
+    const uint16_t low = GetLow(ordinal);
+    auto it = containers_.end();
+    if (containers_.empty() || containers_.back().key < key) {
+        containers_.emplace_back(key, GetResource());
+        it = std::prev(containers_.end());
+    }
+    else {
+        it = std::lower_bound(containers_.begin(), containers_.end(), key, [](const Container& container, uint16_t k) {
+            return container.key < k;
+        });
+        if (it == containers_.end() || it->key != key) {
+            it = containers_.emplace(it, key, GetResource());
+        }
+    }
+    Container& container = *it;
+    if (ContainerContains(container, low)) { return; }
+    if (container.kind == Kind::RUN) {
+        //Продолжение последнего отрезка - обычный случай при добавлении документов по возрастанию номеров
+        const size_t last = container.values.size() - 2;
+        if (container.values[last] + container.values[last + 1] + 1 == low) {
+            ++container.values[last + 1];
+            ++container.cardinality;
+            ++size_;
+            return;
+        }
+        ExpandRuns(container);
+    }
+    if (container.kind == Kind::ARRAY) {
+        if (container.values.empty() || container.values.back() < low) {
+            container.values.push_back(low);
+        }
+        else {
+            container.values.insert(std::lower_bound(container.values.begin(), container.values.end(), low), low);
+        }
+        ++container.cardinality;
+        if (container.cardinality > ARRAY_MAX_SIZE) {
+            SetBits(container, ToBits(container));
+        }
+    }
+    else {
+        container.bits[low / 64] |= uint64_t{1} << (low % 64);
+        ++container.cardinality;
+    }
+    ++size_;
+}
+
+void DocumentSet::Erase(int ordinal)
+{
+    const uint16_t key = GetKey(ordinal);
+    const uint16_t low = GetLow(ordinal);
+    auto it = std::lower_bound(containers_.begin(), containers_.end(), key, [](const Container& container, uint16_t k) {
+        return container.key < k;
+    });
+    if (it == containers_.end() || it->key != key || !ContainerContains(*it, low)) { return; }
+    Container& container = *it;
+    if (container.kind == Kind::RUN) {
+        ExpandRuns(container);
+    }
+    if (container.kind == Kind::ARRAY) {
+        container.values.erase(std::lower_bound(container.values.begin(), container.values.end(), low));
+        --container.cardinality;
+    }
+    else {
+        container.bits[low / 64] &= ~(uint64_t{1} << (low % 64));
+        --container.cardinality;
+        if (container.cardinality <= ARRAY_MAX_SIZE) {
+            SetBits(container, ToBits(container));
+        }
+    }
+    --size_;
+    if (container.cardinality == 0) {
+        containers_.erase(it);
+    }
+}
+
+bool DocumentSet::Contains(int ordinal) const
+{
+    if (ordinal < 0) { return false; }
+    const auto it = FindContainerFrom(GetKey(ordinal));
+    return it != containers_.end() && it->key == GetKey(ordinal) && ContainerContains(*it, GetLow(ordinal));
+}
+
+size_t DocumentSet::size() const
+{
+    return size_;
+}
+
+bool DocumentSet::empty() const
+{
+    return size_ == 0;
+}
+
+void DocumentSet::Optimize()
+{
+    for (Container& container : containers_) {
+        std::vector<uint16_t> runs;
+        ForEachInRange(static_cast<int>(container.key) << 16, (static_cast<int>(container.key) + 1) << 16,
+                [&runs](int ordinal) {
+                    const uint16_t low = GetLow(ordinal);
+                    if (!runs.empty() && runs[runs.size() - 2] + runs.back() + 1 == low) {
+                        ++runs.back();
+                    }
+                    else {
+                        runs.push_back(low);
+                        runs.push_back(0);
+                    }
+                });
+        const size_t run_bytes = runs.size() * sizeof(uint16_t);
+        const size_t other_bytes = std::min(container.cardinality * sizeof(uint16_t),
+                BITMAP_WORD_COUNT * sizeof(uint64_t));
+        if (run_bytes < other_bytes) {
+            container.kind = Kind::RUN;
+            container.values.assign(runs.begin(), runs.end());
+            container.bits.clear();
+        }
+        else if (container.kind == Kind::RUN) {
+            ExpandRuns(container);
+        }
+        container.values.shrink_to_fit();
+        container.bits.shrink_to_fit();
+    }
+    containers_.shrink_to_fit();
+}
+
+size_t DocumentSet::GetBytes() const
+{
+    size_t bytes = containers_.capacity() * sizeof(Container);
+    for (const Container& container : containers_) {
+        bytes += container.values.capacity() * sizeof(uint16_t) + container.bits.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+size_t DocumentSet::GetArrayCount() const
+{
+    return std::count_if(containers_.begin(), containers_.end(), [](const Container& container) {
+        return container.kind == Kind::ARRAY;
+    });
+}
+
+size_t DocumentSet::GetBitmapCount() const
+{
+    return std::count_if(containers_.begin(), containers_.end(), [](const Container& container) {
+        return container.kind == Kind::BITMAP;
+    });
+}
+
+size_t DocumentSet::GetRunCount() const
+{
+    return std::count_if(containers_.begin(), containers_.end(), [](const Container& container) {
+        return container.kind == Kind::RUN;
+    });
+}
+
+DocumentSet operator&(const DocumentSet& lhs, const DocumentSet& rhs)
+{
+    using Container = DocumentSet::Container;
+    using Kind = DocumentSet::Kind;
+    DocumentSet result(lhs.GetResource());
+    auto lhs_it = lhs.containers_.begin();
+    auto rhs_it = rhs.containers_.begin();
+    while (lhs_it != lhs.containers_.end() && rhs_it != rhs.containers_.end()) {
+        if (lhs_it->key != rhs_it->key) {
+            (lhs_it->key < rhs_it->key ? lhs_it : rhs_it) += 1;
+            continue;
+        }
+        Container container(lhs_it->key, result.GetResource());
+        if (lhs_it->kind == Kind::ARRAY || rhs_it->kind == Kind::ARRAY) {
+            //Номера массива проверяются по другому контейнеру
+            const Container& array = lhs_it->kind == Kind::ARRAY ? *lhs_it : *rhs_it;
+            const Container& other = lhs_it->kind == Kind::ARRAY ? *rhs_it : *lhs_it;
+            std::vector<uint16_t> values;
+            for (const uint16_t value : array.values) {
+                if (DocumentSet::ContainerContains(other, value)) { values.push_back(value); }
+            }
+            DocumentSet::SetValues(container, std::move(values));
+        }
+        else {
+            std::vector<uint64_t> bits = DocumentSet::ToBits(*lhs_it);
+            const std::vector<uint64_t> rhs_bits = DocumentSet::ToBits(*rhs_it);
+            for (size_t i = 0; i < bits.size(); ++i) {
+                bits[i] &= rhs_bits[i];
+            }
+            DocumentSet::SetBits(container, bits);
+        }
+        if (container.cardinality != 0) {
+            result.size_ += container.cardinality;
+            result.containers_.push_back(std::move(container));
+        }
+        ++lhs_it;
+        ++rhs_it;
+    }
+    return result;
+}
+
+DocumentSet operator|(const DocumentSet& lhs, const DocumentSet& rhs)
+{
+    using Container = DocumentSet::Container;
+    using Kind = DocumentSet::Kind;
+    DocumentSet result(lhs.GetResource());
+    auto lhs_it = lhs.containers_.begin();
+    auto rhs_it = rhs.containers_.begin();
+    while (lhs_it != lhs.containers_.end() || rhs_it != rhs.containers_.end()) {
+        //Контейнер только одного множества копируется как есть
+        if (rhs_it == rhs.containers_.end() || (lhs_it != lhs.containers_.end() && lhs_it->key < rhs_it->key)) {
+            result.containers_.emplace_back(*lhs_it, result.GetResource());
+            result.size_ += (lhs_it++)->cardinality;
+            continue;
+        }
+        if (lhs_it == lhs.containers_.end() || rhs_it->key < lhs_it->key) {
+            result.containers_.emplace_back(*rhs_it, result.GetResource());
+            result.size_ += (rhs_it++)->cardinality;
+            continue;
+        }
+        Container container(lhs_it->key, result.GetResource());
+        if (lhs_it->kind == Kind::ARRAY && rhs_it->kind == Kind::ARRAY) {
+            std::vector<uint16_t> values;
+            std::set_union(lhs_it->values.begin(), lhs_it->values.end(), rhs_it->values.begin(), rhs_it->values.end(),
+                    std::back_inserter(values));
+            DocumentSet::SetValues(container, std::move(values));
+        }
+        else {
+            std::vector<uint64_t> bits = DocumentSet::ToBits(*lhs_it);
+            const std::vector<uint64_t> rhs_bits = DocumentSet::ToBits(*rhs_it);
+            for (size_t i = 0; i < bits.size(); ++i) {
+                bits[i] |= rhs_bits[i];
+            }
+            DocumentSet::SetBits(container, bits);
+        }
+        result.size_ += container.cardinality;
+        result.containers_.push_back(std::move(container));
+        ++lhs_it;
+        ++rhs_it;
+    }
+    return result;
+}
+
+std::pmr::memory_resource* DocumentSet::GetResource() const
+{
+    return containers_.get_allocator().resource();
+}
+
+std::pmr::vector<DocumentSet::Container>::const_iterator DocumentSet::FindContainerFrom(uint16_t key) const
+{
+    return std::lower_bound(containers_.begin(), containers_.end(), key, [](const Container& container, uint16_t k) {
+        return container.key < k;
+    });
+}
+
+bool DocumentSet::ContainerContains(const Container& container, uint16_t value)
+{
+    switch (container.kind) {
+        case Kind::ARRAY:
+            return std::binary_search(container.values.begin(), container.values.end(), value);
+        case Kind::BITMAP:
+            return (container.bits[value / 64] >> (value % 64)) & 1;
+        case Kind::RUN: {
+            //Последний отрезок, который начинается не позже value
+            size_t left = 0;
+            size_t right = container.values.size() / 2;
+            while (left < right) {
+                const size_t middle = (left + right) / 2;
+                if (container.values[2 * middle] <= value) { left = middle + 1; }
+                else { right = middle; }
+            }
+            return left != 0 && value - container.values[2 * (left - 1)] <= container.values[2 * (left - 1) + 1];
+        }
+    }
+    return false;
+}
+
+std::vector<uint64_t> DocumentSet::ToBits(const Container& container)
+{
+    if (container.kind == Kind::BITMAP) {
+        return {container.bits.begin(), container.bits.end()};
+    }
+    std::vector<uint64_t> bits(BITMAP_WORD_COUNT, 0);
+    if (container.kind == Kind::ARRAY) {
+        for (const uint16_t value : container.values) {
+            bits[value / 64] |= uint64_t{1} << (value % 64);
+        }
+    }
+    else {
+        for (size_t i = 0; i < container.values.size(); i += 2) {
+            const size_t run_end = container.values[i] + container.values[i + 1] + 1;
+            for (size_t value = container.values[i]; value < run_end; ++value) {
+                bits[value / 64] |= uint64_t{1} << (value % 64);
+            }
+        }
+    }
+    return bits;
+}
+
+void DocumentSet::SetBits(Container& container, const std::vector<uint64_t>& bits)
+{
+    size_t cardinality = 0;
+    for (const uint64_t word : bits) {
+        cardinality += __builtin_popcountll(word);
+    }
+    container.cardinality = static_cast<uint32_t>(cardinality);
+    if (cardinality > ARRAY_MAX_SIZE) {
+        container.kind = Kind::BITMAP;
+        container.bits.assign(bits.begin(), bits.end());
+        container.values.clear();
+        container.values.shrink_to_fit();
+        return;
+    }
+    container.kind = Kind::ARRAY;
+    container.values.clear();
+    container.values.reserve(cardinality);
+    for (size_t word_index = 0; word_index < bits.size(); ++word_index) {
+        for (uint64_t word = bits[word_index]; word != 0; word &= word - 1) {
+            container.values.push_back(static_cast<uint16_t>(word_index * 64 + __builtin_ctzll(word)));
+        }
+    }
+    container.bits.clear();
+    container.bits.shrink_to_fit();
+}
+
+void DocumentSet::SetValues(Container& container, std::vector<uint16_t> values)
+{
+    if (values.size() > ARRAY_MAX_SIZE) {
+        Container array(container.key, container.values.get_allocator().resource());
+        array.values.assign(values.begin(), values.end());
+        SetBits(container, ToBits(array));
+        return;
+    }
+    container.kind = Kind::ARRAY;
+    container.cardinality = static_cast<uint32_t>(values.size());
+    container.values.assign(values.begin(), values.end());
+    container.bits.clear();
+}
+
+void DocumentSet::ExpandRuns(Container& container)
+{
+    SetBits(container, ToBits(container));
+}
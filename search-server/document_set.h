@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+//Множество порядковых номеров документов в виде контейнеров по 2^16 номеров (Roaring, Lemire et al., 2016):
+//редкие номера отрезка хранятся отсортированным массивом, частые - битовой картой, подряд идущие - отрезками.
+//Проверка принадлежности - поиск контейнера и проверка бита или двоичный поиск в массиве на 4096 элементов,
+//пересечение и объединение битовых карт - циклы по 64-битным словам, которые компилятор векторизует
+class DocumentSet
+{
+public:
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+    
+    DocumentSet() = default;
+    
+    explicit DocumentSet(const allocator_type& allocator);
+    
+    DocumentSet(const DocumentSet& other, const allocator_type& allocator);
+    
+    DocumentSet(DocumentSet&& other, const allocator_type& allocator);
+    
+    DocumentSet(const DocumentSet& other) = default;
+    
+    DocumentSet(DocumentSet&& other) = default;
+    
+    DocumentSet& operator=(const DocumentSet& other) = default;
+    
+    DocumentSet& operator=(DocumentSet&& other) = default;
+    
+    //Номер больше всех номеров множества добавляется без поиска контейнера
+    void Insert(int ordinal);
+    
+    void Erase(int ordinal);
+    
+    bool Contains(int ordinal) const;
+    
+    size_t size() const;
+    
+    bool empty() const;
+    
+    //Вызывает action(ordinal) для номеров из [begin, end) по возрастанию
+    template<typename Action>
+    void ForEachInRange(int begin, int end, Action action) const;
+    
+    template<typename Action>
+    void ForEach(Action action) const
+    {
+        ForEachInRange(0, std::numeric_limits<int>::max(), action);
+    }
+    
+    //Переводит каждый контейнер в самое компактное из трёх представлений. Вставка в контейнер из отрезков,
+    //кроме продолжения последнего отрезка, возвращает его в массив или битовую карту
+    void Optimize();
+    
+    //Память контейнеров вместе с их массивами
+    size_t GetBytes() const;
+    
+    //Число контейнеров-массивов, битовых карт и отрезков
+    size_t GetArrayCount() const;
+    size_t GetBitmapCount() const;
+    size_t GetRunCount() const;
+    
+    friend DocumentSet operator&(const DocumentSet& lhs, const DocumentSet& rhs);
+    
+    friend DocumentSet operator|(const DocumentSet& lhs, const DocumentSet& rhs);
+
+private:
+    enum class Kind : uint8_t
+    {
+        ARRAY,
+        BITMAP,
+        RUN
+    };
+    
+    struct Container
+    {
+        Container(uint16_t key, std::pmr::memory_resource* resource);
+        
+        Container(const Container& other, std::pmr::memory_resource* resource);
+        
+        uint16_t key;
+        Kind kind = Kind::ARRAY;
+        uint32_t cardinality = 0;
+        //ARRAY - номера по возрастанию, RUN - пары (начало, длина - 1)
+        std::pmr::vector<uint16_t> values;
+        //BITMAP - 1024 слова
+        std::pmr::vector<uint64_t> bits;
+    };
+    
+    std::pmr::vector<Container> containers_;
+    size_t size_ = 0;
+    
+    std::pmr::memory_resource* GetResource() const;
+    
+    //Первый контейнер с ключом не меньше key
+    std::pmr::vector<Container>::const_iterator FindContainerFrom(uint16_t key) const;
+    
+    static bool ContainerContains(const Container& container, uint16_t value);
+    
+    //Биты контейнера любого вида
+    static std::vector<uint64_t> ToBits(const Container& container);
+    
+    //Массив при числе номеров не больше ARRAY_MAX_SIZE, иначе битовая карта
+    static void SetBits(Container& container, const std::vector<uint64_t>& bits);
+    
+    static void SetValues(Container& container, std::vector<uint16_t> values);
+    
+    //Контейнер из отрезков переводится в массив или битовую карту
+    static void ExpandRuns(Container& container);
+};
+
+template<typename Action>
+void DocumentSet::ForEachInRange(int begin, int end, Action action) const
+{
+    if (begin < 0) { begin = 0; }
+    for (auto it = FindContainerFrom(static_cast<uint16_t>(begin >> 16));
+            it != containers_.end() && (static_cast<int>(it->key) << 16) < end; ++it) {
+        const int base = static_cast<int>(it->key) << 16;
+        const int low_begin = begin > base ? begin - base : 0;
+        const int low_end = end - base < (1 << 16) ? end - base : 1 << 16;
+        switch (it->kind) {
+            case Kind::ARRAY:
+                for (const uint16_t value : it->values) {
+                    if (value >= low_end) { break; }
+                    if (value >= low_begin) { action(base + value); }
+                }
+                break;
+            case Kind::BITMAP:
+                for (int word_index = low_begin / 64; word_index * 64 < low_end; ++word_index) {
+                    uint64_t word = it->bits[word_index];
+                    if (word_index == low_begin / 64) { word &= ~uint64_t{0} << (low_begin % 64); }
+                    while (word != 0) {
+                        const int value = word_index * 64 + __builtin_ctzll(word);
+                        if (value >= low_end) { break; }
+                        action(base + value);
+                        word &= word - 1;
+                    }
+                }
+                break;
+            case Kind::RUN:
+                for (size_t i = 0; i < it->values.size(); i += 2) {
+                    const int run_end = it->values[i] + it->values[i + 1] + 1;
+                    for (int value = it->values[i] > low_begin ? it->values[i] : low_begin;
+                            value < run_end && value < low_end; ++value) {
+                        action(base + value);
+                    }
+                    if (run_end >= low_end) { break; }
+                }
+                break;
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include "memory_usage.h"
+
+size_t MemoryUsage::GetTotalBytes() const
+{
+    size_t total = 0;
+    for (const StructureMemoryUsage& structure : structures) {
+        total += structure.bytes;
+    }
+    return total;
+}
+
+void MemoryUsage::AddPostingLength(size_t posting_length)
+{
+    size_t bucket = 0;
+    while (posting_length > 1) {
+        posting_length >>= 1;
+        ++bucket;
+    }
+    if (posting_length_histogram.size() <= bucket) {
+        posting_length_histogram.resize(bucket + 1);
+    }
+    ++posting_length_histogram[bucket];
+}
+
+void MemoryUsage::AddPostingGap(size_t gap)
+{
+    size_t bit_count = 0;
+    while (gap > 1) {
+        gap >>= 1;
+        ++bit_count;
+    }
+    ++posting_gap_count;
+    posting_gap_bits += 2 * bit_count + 1;
+}
+
+double MemoryUsage::GetAverageGapBits() const
+{
+    return posting_gap_count == 0 ? 0.0 : static_cast<double>(posting_gap_bits) / posting_gap_count;
+}
+
+std::ostream& operator<<(std::ostream& out, const MemoryUsage& memory_usage)
+{
+    using namespace std;
+    for (const StructureMemoryUsage& structure : memory_usage.structures) {
+        out << structure.name << ": "s << structure.element_count << " elements, "s << structure.bytes << " bytes"s
+                << endl;
+    }
+    out << "total: "s << memory_usage.GetTotalBytes() << " bytes"s << endl;
+    out << "posting lengths:"s;
+    for (size_t bucket = 0; bucket < memory_usage.posting_length_histogram.size(); ++bucket) {
+        out << " ["s << (size_t{1} << bucket) << ", "s << (size_t{1} << (bucket + 1)) << "): "s
+                << memory_usage.posting_length_histogram[bucket];
+    }
+    out << endl << "posting gaps: "s << memory_usage.posting_gap_count << ", "s << memory_usage.GetAverageGapBits()
+            << " bits per gap"s;
+    return out << endl;
+}
+
+size_t EstimateAllocationBytes(size_t size)
+{
+    if (size == 0) { return 0; }
+    return std::max<size_t>(32, (size + 8 + 15) & ~size_t{15});
+}
+
+size_t EstimateStringHeapBytes(const std::string& str)
+{
+    //Small string optimization: короткая строка лежит в буфере внутри объекта
+    const char* data = str.data();
+    const char* object = reinterpret_cast<const char*>(&str);
+    if (data >= object && data < object + sizeof(str)) { return 0; }
+    return EstimateAllocationBytes(str.capacity() + 1);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//Память, занимаемая одной структурой индекса
+struct StructureMemoryUsage
+{
+    std::string_view name;
+    size_t element_count = 0;
+    size_t bytes = 0;
+};
+
+struct MemoryUsage
+{
+    std::vector<StructureMemoryUsage> structures;
+    //posting_length_histogram[i] - число слов, у которых длина постинга лежит в [2^i, 2^(i+1))
+    std::vector<size_t> posting_length_histogram;
+    //Разности соседних порядковых номеров документов в постингах (первая - от -1) и сумма длин их
+    //гамма-кодов Элиаса: оценка размера сжатых постингов, которая зависит от порядка документов
+    size_t posting_gap_count = 0;
+    size_t posting_gap_bits = 0;
+    
+    size_t GetTotalBytes() const;
+    
+    void AddPostingLength(size_t posting_length);
+    
+    //gap больше нуля
+    void AddPostingGap(size_t gap);
+    
+    //0, если разностей нет
+    double GetAverageGapBits() const;
+};
+
+std::ostream& operator<<(std::ostream& out, const MemoryUsage& memory_usage);
+
+//Оценка размера блока, который выделит malloc под size байт (заголовок 8 байт, выравнивание 16)
+size_t EstimateAllocationBytes(size_t size);
+
+//Узел красно-чёрного дерева std::map/std::set: цвет и три указателя плюс значение
+template<typename Value>
+size_t EstimateTreeNodeBytes()
+{
+    return EstimateAllocationBytes(4 * sizeof(void*) + sizeof(Value));
+}
+
+//Память строки вне её объекта: при короткой строке данные хранятся внутри объекта
+size_t EstimateStringHeapBytes(const std::string& str);
@@ -1,7 +1,14 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
+#include "document.h"
 
 template<typename T_it>
 struct IteratorRange {
@@ -12,19 +19,99 @@ struct IteratorRange {
 template <typename T_it>
 std::ostream& operator<<(std::ostream& out, const IteratorRange<T_it>& range);
 
+//Страницы диапазона. Границы страницы находятся при переходе к ней, поэтому диапазон не просматривается заранее.
+//Пустой диапазон - одна пустая страница
 template<typename T_it>
 class Paginator
 {
 public:
-    Paginator(T_it begin_it, T_it end_it, int page_size);
-    auto begin() const;
-    auto end() const;
+    class PageIterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = IteratorRange<T_it>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = IteratorRange<T_it>;
+        
+        PageIterator(T_it page_begin, T_it range_end, int page_size, bool is_end);
+        
+        IteratorRange<T_it> operator*() const;
+        
+        PageIterator& operator++();
+        
+        bool operator==(const PageIterator& other) const;
+        
+        bool operator!=(const PageIterator& other) const;
+    
+    private:
+        T_it page_begin_;
+        T_it page_end_;
+        T_it range_end_;
+        int page_size_;
+        bool is_end_;
+        
+        T_it FindPageEnd() const;
+    };
     
+    Paginator(T_it begin_it, T_it end_it, int page_size);
+    PageIterator begin() const;
+    PageIterator end() const;
+
 private:
     
+    T_it begin_it_;
+    T_it end_it_;
     int page_size_;
-    std::vector<IteratorRange<T_it>> iterators_;
+
+};
+
+//Страницы выдачи, которые запрашиваются по мере обхода (search-after).
+//fetch_page(cursor, page_size) возвращает не больше page_size документов, идущих за cursor,
+//например SearchServer::FindTopDocuments с курсором. Обход заканчивается на неполной странице
+template<typename FetchPage>
+class CursorPaginator
+{
+public:
+    class PageIterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::vector<Document>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::vector<Document>*;
+        using reference = const std::vector<Document>&;
+        
+        //Итератор конца
+        PageIterator() = default;
+        
+        explicit PageIterator(const CursorPaginator& paginator);
+        
+        const std::vector<Document>& operator*() const;
+        
+        const std::vector<Document>* operator->() const;
+        
+        PageIterator& operator++();
+        
+        //Итераторы равны, только если оба в конце: страницы не сравниваются
+        bool operator==(const PageIterator& other) const;
+        
+        bool operator!=(const PageIterator& other) const;
+    
+    private:
+        const CursorPaginator* paginator_ = nullptr;
+        std::vector<Document> page_;
+    };
     
+    CursorPaginator(FetchPage fetch_page, size_t page_size);
+    PageIterator begin() const;
+    PageIterator end() const;
+
+private:
+    
+    FetchPage fetch_page_;
+    size_t page_size_;
+
 };
 
 template<typename T_it>
@@ -37,46 +124,156 @@ std::ostream& operator<<(std::ostream& out, const IteratorRange<T_it>& range)
 }
 
 template<typename T_it>
-Paginator<T_it>::Paginator(T_it begin_it, T_it end_it, int page_size) : page_size_(page_size)
+Paginator<T_it>::PageIterator::PageIterator(T_it page_begin, T_it range_end, int page_size, bool is_end)
+        : page_begin_(page_begin), page_end_(page_begin), range_end_(range_end), page_size_(page_size), is_end_(is_end)
 {
-    int container_size = count_if(begin_it, end_it, [](auto) { return true; });
-    if (container_size <= page_size_) {
-        iterators_.push_back(IteratorRange<T_it>{begin_it, end_it});
+    if (!is_end_) {
+        page_end_ = FindPageEnd();
     }
-    else if (page_size_ > 0) {
-        int i = page_size_;
-        while (i < container_size) {
-            T_it it_start = begin_it + i - page_size_;
-            T_it it_end = begin_it + i;
-            IteratorRange<T_it> iterator_range{it_start, it_end};
-            iterators_.push_back(iterator_range);
-            i += page_size_;
-        }
-        if (i > container_size - 1) {
-            i -= page_size_;
-            T_it it_start = begin_it + i;
-            T_it it_end = end_it;
-            IteratorRange<T_it> iterator_range{it_start, it_end};
-            iterators_.push_back(iterator_range);
-        }
+}
+
+template<typename T_it>
+IteratorRange<T_it> Paginator<T_it>::PageIterator::operator*() const
+{
+    return {page_begin_, page_end_};
+}
+
+template<typename T_it>
+typename Paginator<T_it>::PageIterator& Paginator<T_it>::PageIterator::operator++()
+{
+    page_begin_ = page_end_;
+    if (page_begin_ == range_end_) {
+        is_end_ = true;
+    }
+    else {
+        page_end_ = FindPageEnd();
+    }
+    return *this;
+}
+
+template<typename T_it>
+bool Paginator<T_it>::PageIterator::operator==(const PageIterator& other) const
+{
+    return is_end_ == other.is_end_ && (is_end_ || page_begin_ == other.page_begin_);
+}
+
+template<typename T_it>
+bool Paginator<T_it>::PageIterator::operator!=(const PageIterator& other) const
+{
+    return !(*this == other);
+}
+
+template<typename T_it>
+T_it Paginator<T_it>::PageIterator::FindPageEnd() const
+{
+    if constexpr (std::is_base_of_v<std::random_access_iterator_tag,
+            typename std::iterator_traits<T_it>::iterator_category>) {
+        return page_begin_ + std::min<std::ptrdiff_t>(page_size_, range_end_ - page_begin_);
     }
     else {
+        T_it it = page_begin_;
+        for (int i = 0; i < page_size_ && it != range_end_; ++i) {
+            ++it;
+        }
+        return it;
+    }
+}
+
+template<typename T_it>
+Paginator<T_it>::Paginator(T_it begin_it, T_it end_it, int page_size)
+        : begin_it_(begin_it), end_it_(end_it), page_size_(page_size)
+{
+    if (page_size_ <= 0) {
         throw std::invalid_argument("Page size must be greater than zero.");
     }
 }
 
 template<typename T_it>
-auto Paginator<T_it>::begin() const {
-    return iterators_.begin();
+typename Paginator<T_it>::PageIterator Paginator<T_it>::begin() const {
+    return PageIterator(begin_it_, end_it_, page_size_, false);
 }
 
 template<typename T_it>
-auto Paginator<T_it>::end() const {
-    return iterators_.end();
+typename Paginator<T_it>::PageIterator Paginator<T_it>::end() const {
+    return PageIterator(end_it_, end_it_, page_size_, true);
 }
 
 template<typename Container>
 auto Paginate(const Container& c, size_t page_size)
 {
     return Paginator(begin(c), end(c), page_size);
-}
\ No newline at end of file
+}
+
+template<typename FetchPage>
+CursorPaginator<FetchPage>::PageIterator::PageIterator(const CursorPaginator& paginator)
+        : paginator_(&paginator), page_(paginator.fetch_page_(SearchCursor(), paginator.page_size_))
+{
+    if (page_.empty()) {
+        paginator_ = nullptr;
+    }
+}
+
+template<typename FetchPage>
+const std::vector<Document>& CursorPaginator<FetchPage>::PageIterator::operator*() const
+{
+    return page_;
+}
+
+template<typename FetchPage>
+const std::vector<Document>* CursorPaginator<FetchPage>::PageIterator::operator->() const
+{
+    return &page_;
+}
+
+template<typename FetchPage>
+typename CursorPaginator<FetchPage>::PageIterator& CursorPaginator<FetchPage>::PageIterator::operator++()
+{
+    if (page_.size() < paginator_->page_size_) {
+        paginator_ = nullptr;
+        page_.clear();
+        return *this;
+    }
+    page_ = paginator_->fetch_page_(SearchCursor::After(page_.back()), paginator_->page_size_);
+    if (page_.empty()) {
+        paginator_ = nullptr;
+    }
+    return *this;
+}
+
+template<typename FetchPage>
+bool CursorPaginator<FetchPage>::PageIterator::operator==(const PageIterator& other) const
+{
+    return paginator_ == nullptr && other.paginator_ == nullptr;
+}
+
+template<typename FetchPage>
+bool CursorPaginator<FetchPage>::PageIterator::operator!=(const PageIterator& other) const
+{
+    return !(*this == other);
+}
+
+template<typename FetchPage>
+CursorPaginator<FetchPage>::CursorPaginator(FetchPage fetch_page, size_t page_size)
+        : fetch_page_(std::move(fetch_page)), page_size_(page_size)
+{
+    if (page_size_ == 0) {
+        throw std::invalid_argument("Page size must be greater than zero.");
+    }
+}
+
+template<typename FetchPage>
+typename CursorPaginator<FetchPage>::PageIterator CursorPaginator<FetchPage>::begin() const {
+    return PageIterator(*this);
+}
+
+template<typename FetchPage>
+typename CursorPaginator<FetchPage>::PageIterator CursorPaginator<FetchPage>::end() const {
+    return PageIterator();
+}
+
+//Ленивые страницы выдачи: следующая страница запрашивается у fetch_page при переходе к ней
+template<typename FetchPage>
+auto PaginateByCursor(FetchPage fetch_page, size_t page_size)
+{
+    return CursorPaginator<FetchPage>(std::move(fetch_page), page_size);
+}
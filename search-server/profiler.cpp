@@ -0,0 +1,234 @@
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include "profiler.h"
+
+namespace {
+
+struct StageCounters
+{
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> max_ns{0};
+    std::array<std::atomic<uint64_t>, PROFILE_HISTOGRAM_BUCKET_COUNT> histogram{};
+};
+
+//Счётчики одного потока: [родитель][этап]. Пишет только поток-владелец,
+//поэтому достаточно relaxed-операций без read-modify-write
+struct ThreadProfile
+{
+    std::array<std::array<StageCounters, PROFILE_STAGE_COUNT>, PROFILE_STAGE_COUNT + 1> counters;
+};
+
+void Increase(std::atomic<uint64_t>& counter, uint64_t value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void AddCounters(ThreadProfile& to, const ThreadProfile& from)
+{
+    for (size_t parent = 0; parent <= PROFILE_STAGE_COUNT; ++parent) {
+        for (size_t stage = 0; stage < PROFILE_STAGE_COUNT; ++stage) {
+            StageCounters& to_counters = to.counters[parent][stage];
+            const StageCounters& from_counters = from.counters[parent][stage];
+            Increase(to_counters.count, from_counters.count.load(std::memory_order_relaxed));
+            Increase(to_counters.total_ns, from_counters.total_ns.load(std::memory_order_relaxed));
+            to_counters.max_ns.store(std::max(to_counters.max_ns.load(std::memory_order_relaxed),
+                    from_counters.max_ns.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+            for (size_t bucket = 0; bucket < PROFILE_HISTOGRAM_BUCKET_COUNT; ++bucket) {
+                Increase(to_counters.histogram[bucket], from_counters.histogram[bucket].load(std::memory_order_relaxed));
+            }
+        }
+    }
+}
+
+size_t GetBucket(uint64_t duration_ns)
+{
+    size_t bucket = 0;
+    while (duration_ns != 0 && bucket + 1 < PROFILE_HISTOGRAM_BUCKET_COUNT) {
+        duration_ns >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+class ProfileRegistry
+{
+public:
+    ThreadProfile& Register()
+    {
+        std::lock_guard guard(mutex_);
+        profiles_.push_back(std::make_unique<ThreadProfile>());
+        return *profiles_.back();
+    }
+    
+    //При завершении потока его счётчики добавляются к общим счётчикам завершённых потоков, а профиль удаляется,
+    //поэтому сервер с потоком на соединение не накапливает профили
+    void Retire(const ThreadProfile& profile)
+    {
+        std::lock_guard guard(mutex_);
+        AddCounters(retired_, profile);
+        profiles_.erase(std::find_if(profiles_.begin(), profiles_.end(),
+                [&profile](const std::unique_ptr<ThreadProfile>& item) { return item.get() == &profile; }));
+    }
+    
+    //Профили работающих потоков и счётчики завершённых
+    template<typename Function>
+    void ForEach(Function func)
+    {
+        std::lock_guard guard(mutex_);
+        func(retired_);
+        for (auto& profile : profiles_) {
+            func(*profile);
+        }
+    }
+    
+    size_t GetActiveCount()
+    {
+        std::lock_guard guard(mutex_);
+        return profiles_.size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ThreadProfile>> profiles_;
+    ThreadProfile retired_;
+};
+
+ProfileRegistry& GetRegistry()
+{
+    //Реестр намеренно не уничтожается: потоки статических пулов завершаются при выходе позже него
+    //и сдают свои профили в деструкторах thread_local
+    static ProfileRegistry& registry = *new ProfileRegistry;
+    return registry;
+}
+
+//Регистрирует профиль при первой записи потока и сдаёт его в реестр при завершении потока
+class ThreadProfileHolder
+{
+public:
+    ThreadProfileHolder() : profile(GetRegistry().Register()) {}
+    
+    ThreadProfileHolder(const ThreadProfileHolder&) = delete;
+    
+    ThreadProfileHolder& operator=(const ThreadProfileHolder&) = delete;
+    
+    ~ThreadProfileHolder()
+    {
+        GetRegistry().Retire(profile);
+    }
+    
+    ThreadProfile& profile;
+};
+
+ThreadProfile& GetThreadProfile()
+{
+    thread_local ThreadProfileHolder holder;
+    return holder.profile;
+}
+
+} // namespace
+
+thread_local ProfileStage ScopedStageTimer::current_stage_ = ProfileStage::NONE;
+
+std::string_view GetProfileStageName(ProfileStage stage)
+{
+    switch (stage) {
+        case ProfileStage::FIND_TOP_DOCUMENTS:
+            return "find_top_documents";
+        case ProfileStage::MATCH_DOCUMENT:
+            return "match_document";
+        case ProfileStage::PARSE:
+            return "parse";
+        case ProfileStage::SCORE:
+            return "score";
+        case ProfileStage::MINUS_WORDS:
+            return "minus_words";
+        case ProfileStage::COLLECT:
+            return "collect";
+        case ProfileStage::TOP_K:
+            return "top_k";
+        case ProfileStage::SERVE_REQUEST:
+            return "serve_request";
+        case ProfileStage::NONE:
+            break;
+    }
+    return "none";
+}
+
+uint64_t StageProfile::GetPercentileNs(double percentile) const
+{
+    if (count == 0) { return 0; }
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(percentile / 100.0 * count + 0.5));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < histogram.size(); ++bucket) {
+        seen += histogram[bucket];
+        if (seen >= rank) {
+            return std::min(max_ns, bucket == 0 ? uint64_t{0} : (uint64_t{1} << bucket) - 1);
+        }
+    }
+    return max_ns;
+}
+
+void RecordStageDuration(ProfileStage parent, ProfileStage stage, uint64_t duration_ns)
+{
+    StageCounters& counters = GetThreadProfile().counters[static_cast<size_t>(parent)][static_cast<size_t>(stage)];
+    Increase(counters.count, 1);
+    Increase(counters.total_ns, duration_ns);
+    if (duration_ns > counters.max_ns.load(std::memory_order_relaxed)) {
+        counters.max_ns.store(duration_ns, std::memory_order_relaxed);
+    }
+    Increase(counters.histogram[GetBucket(duration_ns)], 1);
+}
+
+std::vector<StageProfile> GetProfileSnapshot()
+{
+    std::array<std::array<StageProfile, PROFILE_STAGE_COUNT>, PROFILE_STAGE_COUNT + 1> merged;
+    GetRegistry().ForEach([&merged](const ThreadProfile& profile) {
+        for (size_t parent = 0; parent <= PROFILE_STAGE_COUNT; ++parent) {
+            for (size_t stage = 0; stage < PROFILE_STAGE_COUNT; ++stage) {
+                const StageCounters& counters = profile.counters[parent][stage];
+                StageProfile& result = merged[parent][stage];
+                result.count += counters.count.load(std::memory_order_relaxed);
+                result.total_ns += counters.total_ns.load(std::memory_order_relaxed);
+                result.max_ns = std::max(result.max_ns, counters.max_ns.load(std::memory_order_relaxed));
+                for (size_t bucket = 0; bucket < PROFILE_HISTOGRAM_BUCKET_COUNT; ++bucket) {
+                    result.histogram[bucket] += counters.histogram[bucket].load(std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+    
+    std::vector<StageProfile> snapshot;
+    for (size_t parent = 0; parent <= PROFILE_STAGE_COUNT; ++parent) {
+        for (size_t stage = 0; stage < PROFILE_STAGE_COUNT; ++stage) {
+            StageProfile& result = merged[parent][stage];
+            if (result.count == 0) { continue; }
+            result.parent = static_cast<ProfileStage>(parent);
+            result.stage = static_cast<ProfileStage>(stage);
+            snapshot.push_back(result);
+        }
+    }
+    return snapshot;
+}
+
+size_t GetActiveProfileCount()
+{
+    return GetRegistry().GetActiveCount();
+}
+
+void ResetProfile()
+{
+    GetRegistry().ForEach([](ThreadProfile& profile) {
+        for (auto& parent_counters : profile.counters) {
+            for (StageCounters& counters : parent_counters) {
+                counters.count.store(0, std::memory_order_relaxed);
+                counters.total_ns.store(0, std::memory_order_relaxed);
+                counters.max_ns.store(0, std::memory_order_relaxed);
+                for (auto& bucket : counters.histogram) {
+                    bucket.store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "log_duration.h"
+
+/**
+ * Низкозатратное профилирование этапов поиска.
+ *
+ * Каждый поток пишет в собственные гистограммы без блокировок, GetProfileSnapshot
+ * суммирует их по всем потокам. Этапы вложены: время этапа учитывается отдельно
+ * для каждого родительского этапа, внутри которого он был запущен.
+ *
+ * Пример использования:
+ *
+ *  void Search() {
+ *      PROFILE_STAGE(ProfileStage::FIND_TOP_DOCUMENTS);
+ *      {
+ *          PROFILE_STAGE(ProfileStage::PARSE);
+ *          ...
+ *      }
+ *  }
+ *
+ * При определённом SEARCH_SERVER_DISABLE_PROFILING макрос PROFILE_STAGE ничего не делает.
+ */
+#ifdef SEARCH_SERVER_DISABLE_PROFILING
+#define PROFILE_STAGE(stage) ((void)0)
+#else
+#define PROFILE_STAGE(stage) ScopedStageTimer UNIQUE_VAR_NAME_PROFILE(stage)
+#endif
+
+enum class ProfileStage
+{
+    FIND_TOP_DOCUMENTS, MATCH_DOCUMENT, PARSE, SCORE, MINUS_WORDS, COLLECT, TOP_K, SERVE_REQUEST, NONE,
+};
+
+const size_t PROFILE_STAGE_COUNT = static_cast<size_t>(ProfileStage::NONE);
+//Корзина i гистограммы содержит длительности из [2^(i-1), 2^i) наносекунд
+const size_t PROFILE_HISTOGRAM_BUCKET_COUNT = 48;
+
+std::string_view GetProfileStageName(ProfileStage stage);
+
+struct StageProfile
+{
+    ProfileStage stage = ProfileStage::NONE;
+    //NONE для этапов верхнего уровня
+    ProfileStage parent = ProfileStage::NONE;
+    uint64_t count = 0;
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    std::array<uint64_t, PROFILE_HISTOGRAM_BUCKET_COUNT> histogram{};
+    
+    //Оценка сверху по границе корзины гистограммы
+    uint64_t GetPercentileNs(double percentile) const;
+};
+
+//Этапы, запускавшиеся хотя бы раз, упорядоченные по (parent, stage)
+std::vector<StageProfile> GetProfileSnapshot();
+
+//Обнуление во время выполнения запросов может потерять часть одновременных записей
+void ResetProfile();
+
+//Число работающих потоков, у которых есть профиль. Данные завершившихся потоков остаются в снимке
+size_t GetActiveProfileCount();
+
+void RecordStageDuration(ProfileStage parent, ProfileStage stage, uint64_t duration_ns);
+
+class ScopedStageTimer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    explicit ScopedStageTimer(ProfileStage stage) : stage_(stage), parent_(current_stage_)
+    {
+        current_stage_ = stage_;
+    }
+    
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+    
+    ~ScopedStageTimer()
+    {
+        const auto duration = Clock::now() - start_time_;
+        current_stage_ = parent_;
+        RecordStageDuration(parent_, stage_,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    }
+
+private:
+    static thread_local ProfileStage current_stage_;
+    
+    const ProfileStage stage_;
+    const ProfileStage parent_;
+    const Clock::time_point start_time_ = Clock::now();
+};
@@ -0,0 +1,27 @@
+#include "query_budget.h"
+
+CancellationToken::CancellationToken() : is_cancelled_(std::make_shared<std::atomic_bool>(false)) {}
+
+void CancellationToken::Cancel() const
+{
+    is_cancelled_->store(true, std::memory_order_relaxed);
+}
+
+bool CancellationToken::IsCancelled() const
+{
+    return is_cancelled_->load(std::memory_order_relaxed);
+}
+
+QueryBudget::QueryBudget(Clock::duration timeout) : deadline_(Clock::now() + timeout) {}
+
+QueryBudget::QueryBudget(Clock::duration timeout, const CancellationToken& token) : QueryBudget(
+        Clock::now() + timeout, token) {}
+
+QueryBudget::QueryBudget(Clock::time_point deadline, const CancellationToken& token) : deadline_(deadline), token_(
+        std::make_shared<const CancellationToken>(token)) {}
+
+bool QueryBudget::IsExhausted() const
+{
+    if (token_ && token_->IsCancelled()) { return true; }
+    return deadline_ != Clock::time_point::max() && Clock::now() >= deadline_;
+}
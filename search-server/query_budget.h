@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "document.h"
+
+//Через сколько просмотренных записей постинга проверять бюджет запроса
+const size_t POSTING_BLOCK_SIZE = 256;
+
+//Разделяемый флаг отмены: копии токена ссылаются на один и тот же флаг
+class CancellationToken
+{
+public:
+    CancellationToken();
+    
+    void Cancel() const;
+    
+    bool IsCancelled() const;
+
+private:
+    std::shared_ptr<std::atomic_bool> is_cancelled_;
+};
+
+//Ограничение на выполнение запроса: крайний срок и (необязательно) токен отмены
+class QueryBudget
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    //Без ограничений
+    QueryBudget() = default;
+    
+    explicit QueryBudget(Clock::duration timeout);
+    
+    QueryBudget(Clock::duration timeout, const CancellationToken& token);
+    
+    QueryBudget(Clock::time_point deadline, const CancellationToken& token);
+    
+    bool IsExhausted() const;
+
+private:
+    Clock::time_point deadline_ = Clock::time_point::max();
+    std::shared_ptr<const CancellationToken> token_;
+};
+
+//Результат поиска с бюджетом. is_partial == true, если бюджет закончился
+//до полного обхода постингов и документы - лучшие из найденных к этому моменту
+struct TopDocumentsResult
+{
+    std::vector<Document> documents;
+    bool is_partial = false;
+};
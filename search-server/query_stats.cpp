@@ -0,0 +1,52 @@
+#include "query_stats.h"
+
+uint64_t QueryStats::GetStageNs(ProfileStage stage) const
+{
+    if (stage == ProfileStage::NONE) { return 0; }
+    return stage_ns[static_cast<size_t>(stage)];
+}
+
+std::string_view GetQueryStrategyName(QueryStrategy strategy)
+{
+    switch (strategy) {
+        case QueryStrategy::TERM_AT_A_TIME:
+            return "term_at_a_time";
+        case QueryStrategy::DOCUMENT_AT_A_TIME:
+            return "document_at_a_time";
+        case QueryStrategy::MAX_SCORE:
+            return "max_score";
+        case QueryStrategy::EMPTY_RESULT:
+            return "empty_result";
+        case QueryStrategy::INTERSECTION:
+            return "intersection";
+    }
+    return "unknown";
+}
+
+std::ostream& operator<<(std::ostream& out, const QueryStats& stats)
+{
+    using namespace std;
+    out << "{ plus_terms = "s << stats.plus_term_count << ", minus_terms = "s << stats.minus_term_count
+            << ", postings_scanned = "s << stats.postings_scanned << ", postings_skipped = "s << stats.postings_skipped
+            << ", rejected_by_predicate = "s << stats.rejected_by_predicate << ", removed_by_minus_words = "s
+            << stats.removed_by_minus_words << ", removed_by_required_words = "s << stats.removed_by_required_words
+            << ", candidates = "s << stats.candidates_before_top_k
+            << ", results = "s << stats.result_count << ", partial = "s << boolalpha << stats.is_partial
+            << ", strategy = "s << GetQueryStrategyName(stats.strategy) << ", minus_first = "s << stats.is_minus_first
+            << noboolalpha;
+    out << ", terms = ["s;
+    for (size_t i = 0; i < stats.terms.size(); ++i) {
+        const TermStats& term = stats.terms[i];
+        out << (i ? ", "s : ""s) << (term.is_minus ? "-"s : ""s) << term.word << ": "s << term.posting_length;
+    }
+    out << "], stages_ns = {"s;
+    bool is_first = true;
+    for (size_t stage = 0; stage < PROFILE_STAGE_COUNT; ++stage) {
+        if (stats.stage_ns[stage] == 0) { continue; }
+        out << (is_first ? ""s : ", "s) << GetProfileStageName(static_cast<ProfileStage>(stage)) << ": "s
+                << stats.stage_ns[stage];
+        is_first = false;
+    }
+    out << "} }"s;
+    return out;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "profiler.h"
+
+struct TermStats
+{
+    std::string word;
+    bool is_minus = false;
+    //0, если слова нет в индексе
+    size_t posting_length = 0;
+};
+
+//Способ вычисления релевантности, выбранный планировщиком запроса
+enum class QueryStrategy
+{
+    //Постинги слов по очереди добавляются в накопитель по всем документам
+    TERM_AT_A_TIME,
+    //Постинги слов обходятся одновременно, документ оценивается целиком; накопителя по всем документам нет
+    DOCUMENT_AT_A_TIME,
+    //Обход по документам, в котором слова с малыми верхними оценками вклада только дооценивают кандидатов (MaxScore)
+    MAX_SCORE,
+    //Минус-слово есть во всех документах или обязательного слова нет ни в одном: постинги не просматриваются
+    EMPTY_RESULT,
+    //Кандидаты - документы самого редкого обязательного слова (+слово), остальные обязательные слова проверяются
+    //по их множествам документов
+    INTERSECTION,
+};
+
+std::string_view GetQueryStrategyName(QueryStrategy strategy);
+
+//Статистика выполнения одного запроса (режим explain)
+struct QueryStats
+{
+    size_t plus_term_count = 0;
+    size_t minus_term_count = 0;
+    std::vector<TermStats> terms;
+    
+    size_t postings_scanned = 0;
+    //Записи постингов плюс-слов, не просмотренные из-за исчерпания бюджета
+    size_t postings_skipped = 0;
+    size_t rejected_by_predicate = 0;
+    size_t removed_by_minus_words = 0;
+    //Отброшенные из-за отсутствия обязательного слова (+слово): записи постингов, при пересечении - документы
+    size_t removed_by_required_words = 0;
+    size_t candidates_before_top_k = 0;
+    size_t result_count = 0;
+    bool is_partial = false;
+    QueryStrategy strategy = QueryStrategy::TERM_AT_A_TIME;
+    //Минус-слова применены до оценки документов
+    bool is_minus_first = false;
+    
+    std::array<uint64_t, PROFILE_STAGE_COUNT> stage_ns{};
+    
+    uint64_t GetStageNs(ProfileStage stage) const;
+};
+
+std::ostream& operator<<(std::ostream& out, const QueryStats& stats);
+
+//Добавляет время жизни объекта к этапу stage в stats. При stats == nullptr ничего не делает
+class QueryStageTimer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    QueryStageTimer(QueryStats* stats, ProfileStage stage) : stats_(stats), stage_(stage)
+    {
+        if (stats_) { start_time_ = Clock::now(); }
+    }
+    
+    QueryStageTimer(const QueryStageTimer&) = delete;
+    
+    QueryStageTimer& operator=(const QueryStageTimer&) = delete;
+    
+    ~QueryStageTimer()
+    {
+        if (stats_) {
+            stats_->stage_ns[static_cast<size_t>(stage_)] += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    Clock::now() - start_time_).count();
+        }
+    }
+
+private:
+    QueryStats* const stats_;
+    const ProfileStage stage_;
+    Clock::time_point start_time_;
+};
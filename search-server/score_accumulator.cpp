@@ -0,0 +1,9 @@
+#include "score_accumulator.h"
+
+ScoreAccumulator::ScoreAccumulator(int first_ordinal, size_t size) : first_ordinal_(first_ordinal), scores_(size),
+        states_(size, UNSCORED) {}
+
+size_t ScoreAccumulator::GetScoredCount() const
+{
+    return scored_ordinals_.size();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Релевантность документов с порядковыми номерами [first_ordinal, first_ordinal + size) в плотном массиве:
+//добавление - обращение по индексу, а не вставка в дерево. Вклады слов в релевантность документа
+//складываются в порядке вызовов Add, поэтому при одном порядке слов сумма не зависит от того,
+//как номера разбиты на накопители и сколько потоков их заполняет
+class ScoreAccumulator
+{
+public:
+    ScoreAccumulator(int first_ordinal, size_t size);
+    
+    //Вклад в исключённый документ не учитывается, но документ считается оценённым
+    void Add(int ordinal, double score)
+    {
+        State& state = states_[ordinal - first_ordinal_];
+        if (state == UNSCORED || state == EXCLUDED) {
+            state = state == UNSCORED ? SCORED : EXCLUDED_SCORED;
+            scored_ordinals_.push_back(ordinal);
+        }
+        if (state == SCORED) {
+            scores_[ordinal - first_ordinal_] += score;
+        }
+    }
+    
+    //Документ не попадёт в результат, оценён он до этого или будет оценён после
+    void Exclude(int ordinal)
+    {
+        State& state = states_[ordinal - first_ordinal_];
+        state = state == UNSCORED || state == EXCLUDED ? EXCLUDED : EXCLUDED_SCORED;
+    }
+    
+    bool IsExcluded(int ordinal) const
+    {
+        const State state = states_[ordinal - first_ordinal_];
+        return state == EXCLUDED || state == EXCLUDED_SCORED;
+    }
+    
+    int GetFirstOrdinal() const
+    {
+        return first_ordinal_;
+    }
+    
+    //Номер после последнего номера накопителя
+    int GetEndOrdinal() const
+    {
+        return first_ordinal_ + static_cast<int>(states_.size());
+    }
+    
+    //Число документов, которым хоть раз вызван Add, включая исключённые
+    size_t GetScoredCount() const;
+    
+    //Вызывает action(ordinal, relevance) для оценённых и не исключённых документов в порядке первого Add
+    template<typename Action>
+    void ForEachScored(Action action) const
+    {
+        for (const int ordinal : scored_ordinals_) {
+            const size_t index = ordinal - first_ordinal_;
+            if (states_[index] == SCORED) {
+                action(ordinal, scores_[index]);
+            }
+        }
+    }
+
+private:
+    enum State : uint8_t
+    {
+        UNSCORED,
+        SCORED,
+        EXCLUDED,
+        EXCLUDED_SCORED
+    };
+    
+    int first_ordinal_;
+    std::vector<double> scores_;
+    std::vector<State> states_;
+    std::vector<int> scored_ordinals_;
+};
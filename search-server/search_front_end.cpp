@@ -0,0 +1,466 @@
+#include "search_front_end.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <execution>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "shard_protocol.h"
+
+namespace {
+
+//Идентификаторы событий epoll: 0 - пробуждение, старший бит - слушающий сокет, остальные - соединения
+const uint64_t WAKE_EVENT_ID = 0;
+const uint64_t LISTENER_EVENT_TAG = uint64_t{1} << 63;
+//Запрос длиннее этого считается ошибкой клиента, соединение закрывается
+const size_t MAX_QUERY_LENGTH = 64 * 1024;
+const size_t READ_BUFFER_SIZE = 64 * 1024;
+//За одно событие соединения читается не больше, чтобы оно не задерживало остальные
+const size_t MAX_READ_SIZE = 4 * READ_BUFFER_SIZE;
+//Запросов одного соединения в пакете: остальные прочитанные строки ждут следующих итераций
+const size_t MAX_PENDING_QUERIES = 1024;
+//Пока у соединения столько непрочитанного ввода или неотправленных ответов, оно не читается:
+//клиент, который отправляет запросы и не читает ответы, не заставит сервер копить их без ограничений
+const size_t MAX_INPUT_SIZE = 1 << 20;
+const size_t MAX_OUTPUT_SIZE = 1 << 20;
+const int MAX_EPOLL_EVENTS = 256;
+
+int OpenReserveDescriptor()
+{
+    return open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
+std::runtime_error MakeSystemError(const std::string& message)
+{
+    return std::runtime_error(message + ": " + std::strerror(errno));
+}
+
+void SetNonBlocking(int fd)
+{
+    const int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) { throw MakeSystemError("fcntl failed"); }
+}
+
+void AppendNumber(std::string& out, double value)
+{
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+void AppendNumber(std::string& out, int value)
+{
+    char buffer[16];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+} // namespace
+
+SearchFrontEnd::SearchFrontEnd(const SearchServer& search_server, size_t max_batch_size) : search_server_(
+        search_server), max_batch_size_(max_batch_size)
+{
+    if (max_batch_size_ == 0) { throw std::invalid_argument("Batch size must be greater than zero."); }
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) { throw MakeSystemError("epoll_create1 failed"); }
+    wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd_ < 0) {
+        close(epoll_fd_);
+        throw MakeSystemError("eventfd failed");
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = WAKE_EVENT_ID;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+    reserve_fd_ = OpenReserveDescriptor();
+}
+
+SearchFrontEnd::~SearchFrontEnd()
+{
+    for (auto& [connection_id, connection] : connections_) {
+        close(connection.fd);
+    }
+    for (const int fd : listen_fds_) {
+        close(fd);
+    }
+    for (const std::string& path : unix_paths_) {
+        unlink(path.c_str());
+    }
+    if (reserve_fd_ >= 0) { close(reserve_fd_); }
+    close(wake_fd_);
+    close(epoll_fd_);
+}
+
+uint16_t SearchFrontEnd::ListenTcp(const std::string& address, uint16_t port)
+{
+    sockaddr_in socket_address{};
+    socket_address.sin_family = AF_INET;
+    socket_address.sin_port = htons(port);
+    if (inet_pton(AF_INET, address.c_str(), &socket_address.sin_addr) != 1) {
+        throw std::runtime_error("Invalid IPv4 address \"" + address + "\".");
+    }
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (fd < 0) { throw MakeSystemError("socket failed"); }
+    const int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    socklen_t length = sizeof(socket_address);
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&socket_address), sizeof(socket_address)) < 0
+            || listen(fd, SOMAXCONN) < 0
+            || getsockname(fd, reinterpret_cast<sockaddr*>(&socket_address), &length) < 0) {
+        const std::runtime_error error = MakeSystemError("Cannot listen on " + address + ":" + std::to_string(port));
+        close(fd);
+        throw error;
+    }
+    AddListener(fd);
+    return ntohs(socket_address.sin_port);
+}
+
+void SearchFrontEnd::ListenUnix(const std::string& path)
+{
+    const int fd = ListenUnixSocket(path);
+    unix_paths_.push_back(path);
+    try {
+        SetNonBlocking(fd);
+    }
+    catch (...) {
+        close(fd);
+        throw;
+    }
+    AddListener(fd);
+}
+
+void SearchFrontEnd::Run()
+{
+    epoll_event events[MAX_EPOLL_EVENTS];
+    bool is_stopped = false;
+    while (!is_stopped) {
+        //Строки, не вошедшие в прошлый пакет, выполняются без ожидания новых событий
+        const int event_count = epoll_wait(epoll_fd_, events, MAX_EPOLL_EVENTS, backlog_ids_.empty() ? -1 : 0);
+        if (event_count < 0) {
+            if (errno == EINTR) { continue; }
+            throw MakeSystemError("epoll_wait failed");
+        }
+        ExtractBacklogQueries();
+        for (int i = 0; i < event_count; ++i) {
+            const uint64_t id = events[i].data.u64;
+            if (id == WAKE_EVENT_ID) {
+                uint64_t value;
+                [[maybe_unused]] const ssize_t result = read(wake_fd_, &value, sizeof(value));
+                is_stopped = true;
+                continue;
+            }
+            if (id & LISTENER_EVENT_TAG) {
+                AcceptConnections(listen_fds_[id & ~LISTENER_EVENT_TAG]);
+                continue;
+            }
+            const auto it = connections_.find(id);
+            if (it == connections_.end()) { continue; }
+            if (events[i].events & EPOLLERR) {
+                CloseConnection(id);
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP)) {
+                ReadQueries(id, it->second);
+            }
+            if (events[i].events & EPOLLOUT) {
+                WriteOutput(id, it->second);
+            }
+        }
+        //Запросы, прочитанные за итерацию, выполняются вместе
+        ExecuteBatch();
+        CloseDrainedConnections();
+    }
+}
+
+void SearchFrontEnd::Stop()
+{
+    const uint64_t value = 1;
+    [[maybe_unused]] const ssize_t result = write(wake_fd_, &value, sizeof(value));
+}
+
+std::string SearchFrontEnd::FormatDocuments(const std::vector<Document>& documents)
+{
+    std::string result;
+    AppendNumber(result, static_cast<int>(documents.size()));
+    for (const Document& document : documents) {
+        result += ' ';
+        AppendNumber(result, document.id);
+        result += ' ';
+        AppendNumber(result, document.relevance);
+        result += ' ';
+        AppendNumber(result, document.rating);
+    }
+    result += '\n';
+    return result;
+}
+
+void SearchFrontEnd::AddListener(int fd)
+{
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = LISTENER_EVENT_TAG | listen_fds_.size();
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        const std::runtime_error error = MakeSystemError("epoll_ctl failed");
+        close(fd);
+        throw error;
+    }
+    listen_fds_.push_back(fd);
+}
+
+void SearchFrontEnd::AcceptConnections(int listen_fd)
+{
+    while (true) {
+        const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) { continue; }
+            if (errno == EMFILE || errno == ENFILE) {
+                HandleDescriptorExhaustion(listen_fd);
+                if (is_accept_paused_) { return; }
+                continue;
+            }
+            //EAGAIN - очередь пуста, остальные ошибки не останавливают сервер
+            return;
+        }
+        //Для Unix-сокета вызов завершится ошибкой, её можно не проверять
+        const int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        const uint64_t connection_id = ++next_connection_id_;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = connection_id;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+            close(fd);
+            continue;
+        }
+        connections_[connection_id].fd = fd;
+    }
+}
+
+void SearchFrontEnd::HandleDescriptorExhaustion(int listen_fd)
+{
+    std::cerr << "SearchFrontEnd: cannot accept a connection: " << std::strerror(errno) << std::endl;
+    if (reserve_fd_ < 0) {
+        SetAcceptPaused(true);
+        return;
+    }
+    close(reserve_fd_);
+    const int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd >= 0) { close(fd); }
+    reserve_fd_ = OpenReserveDescriptor();
+}
+
+void SearchFrontEnd::SetAcceptPaused(bool is_paused)
+{
+    is_accept_paused_ = is_paused;
+    for (size_t i = 0; i < listen_fds_.size(); ++i) {
+        epoll_event event{};
+        event.events = is_paused ? 0u : static_cast<uint32_t>(EPOLLIN);
+        event.data.u64 = LISTENER_EVENT_TAG | i;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, listen_fds_[i], &event);
+    }
+}
+
+void SearchFrontEnd::ReadQueries(uint64_t connection_id, Connection& connection)
+{
+    char buffer[READ_BUFFER_SIZE];
+    size_t read_size = 0;
+    //Непрочитанное epoll сообщит снова: события соединений срабатывают по уровню
+    while (!connection.is_closing && read_size < MAX_READ_SIZE && connection.input.size() < MAX_INPUT_SIZE) {
+        const ssize_t result = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (result > 0) {
+            read_size += static_cast<size_t>(result);
+            connection.input.append(buffer, static_cast<size_t>(result));
+            //Незавершённая строка проверяется после каждого чтения: иначе клиент, не отправляющий перевод строки,
+            //заставит копить ввод без ограничений. Слишком длинный запрос обрабатывается в ExtractQueries
+            const size_t last_newline = connection.input.rfind('\n');
+            const size_t tail_begin = last_newline == std::string::npos ? 0 : last_newline + 1;
+            if (connection.input.size() - tail_begin > MAX_QUERY_LENGTH) { break; }
+            continue;
+        }
+        if (result < 0 && errno == EINTR) { continue; }
+        if (result < 0 && errno == EAGAIN) { break; }
+        //Клиент закрыл соединение или произошла ошибка: ответим на уже прочитанные запросы и закроем его
+        MarkClosing(connection_id, connection);
+    }
+    ExtractQueries(connection_id, connection);
+    UpdateEvents(connection_id, connection);
+}
+
+void SearchFrontEnd::ExtractQueries(uint64_t connection_id, Connection& connection)
+{
+    //Клиент не читает ответы: строки выполнятся, когда WriteOutput отправит часть ответов
+    if (connection.output.size() >= MAX_OUTPUT_SIZE) { return; }
+    const Clock::time_point received = Clock::now();
+    size_t begin = 0;
+    for (size_t end = connection.input.find('\n'); end != std::string::npos
+            && connection.pending_count < MAX_PENDING_QUERIES; end = connection.input.find('\n', begin)) {
+        size_t length = end - begin;
+        if (length > 0 && connection.input[end - 1] == '\r') { --length; }
+        pending_queries_.push_back({connection_id, connection.input.substr(begin, length), received});
+        ++connection.pending_count;
+        begin = end + 1;
+    }
+    connection.input.erase(0, begin);
+    //Строки перед слишком длинным запросом выполняются, а затем соединение закрывается
+    if (!ScheduleBacklog(connection_id, connection) && connection.input.size() > MAX_QUERY_LENGTH) {
+        connection.output += "ERROR Query is too long.\n";
+        connection.input.clear();
+        MarkClosing(connection_id, connection);
+    }
+}
+
+bool SearchFrontEnd::ScheduleBacklog(uint64_t connection_id, Connection& connection)
+{
+    if (connection.input.find('\n') == std::string::npos) { return false; }
+    if (!connection.has_backlog) {
+        connection.has_backlog = true;
+        backlog_ids_.push_back(connection_id);
+    }
+    return true;
+}
+
+void SearchFrontEnd::ExtractBacklogQueries()
+{
+    std::vector<uint64_t> backlog_ids;
+    backlog_ids.swap(backlog_ids_);
+    for (const uint64_t connection_id : backlog_ids) {
+        const auto it = connections_.find(connection_id);
+        if (it == connections_.end()) { continue; }
+        it->second.has_backlog = false;
+        ExtractQueries(connection_id, it->second);
+        UpdateEvents(connection_id, it->second);
+    }
+}
+
+void SearchFrontEnd::ExecuteBatch()
+{
+    for (size_t batch_begin = 0; batch_begin < pending_queries_.size(); batch_begin += max_batch_size_) {
+        const auto begin = pending_queries_.begin() + batch_begin;
+        const auto end = pending_queries_.begin() + std::min(batch_begin + max_batch_size_, pending_queries_.size());
+        std::vector<std::string> responses(end - begin);
+        std::transform(std::execution::par, begin, end, responses.begin(), [this](const PendingQuery& query) {
+            try {
+                return FormatDocuments(search_server_.FindTopDocuments(query.query));
+            }
+            catch (const std::exception& error) {
+                return "ERROR " + std::string(error.what()) + "\n";
+            }
+        });
+        for (auto it = begin; it != end; ++it) {
+            const auto connection = connections_.find(it->connection_id);
+            if (connection != connections_.end()) {
+                connection->second.output += responses[it - begin];
+            }
+        }
+    }
+
+    std::vector<uint64_t> connection_ids;
+    connection_ids.reserve(pending_queries_.size());
+    for (const PendingQuery& query : pending_queries_) {
+        connection_ids.push_back(query.connection_id);
+    }
+    std::sort(connection_ids.begin(), connection_ids.end());
+    connection_ids.erase(std::unique(connection_ids.begin(), connection_ids.end()), connection_ids.end());
+    for (const uint64_t connection_id : connection_ids) {
+        const auto it = connections_.find(connection_id);
+        if (it != connections_.end()) {
+            it->second.pending_count = 0;
+            WriteOutput(connection_id, it->second);
+        }
+    }
+
+#ifndef SEARCH_SERVER_DISABLE_PROFILING
+    const Clock::time_point now = Clock::now();
+    for (const PendingQuery& query : pending_queries_) {
+        RecordStageDuration(ProfileStage::NONE, ProfileStage::SERVE_REQUEST,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(now - query.received).count());
+    }
+#endif
+    pending_queries_.clear();
+}
+
+void SearchFrontEnd::WriteOutput(uint64_t connection_id, Connection& connection)
+{
+    size_t sent = 0;
+    while (sent < connection.output.size()) {
+        const ssize_t result = send(connection.fd, connection.output.data() + sent, connection.output.size() - sent,
+                MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR) { continue; }
+            if (errno == EAGAIN) { break; }
+            //Клиент недоступен: ответы ему больше не нужны
+            connection.input.clear();
+            connection.output.clear();
+            MarkClosing(connection_id, connection);
+            return;
+        }
+        sent += static_cast<size_t>(result);
+    }
+    connection.output.erase(0, sent);
+    if (connection.output.size() < MAX_OUTPUT_SIZE) { ScheduleBacklog(connection_id, connection); }
+    UpdateEvents(connection_id, connection);
+}
+
+void SearchFrontEnd::UpdateEvents(uint64_t connection_id, Connection& connection)
+{
+    //Готовность к записи нужна, только пока есть неотправленные данные. Чтение возобновляется,
+    //когда ответы отправлены и накопленные строки выполнены
+    const bool is_read_paused = connection.input.size() >= MAX_INPUT_SIZE
+            || connection.output.size() >= MAX_OUTPUT_SIZE;
+    const uint32_t events = (connection.is_closing || is_read_paused ? 0u : static_cast<uint32_t>(EPOLLIN))
+            | (connection.output.empty() ? 0u : static_cast<uint32_t>(EPOLLOUT));
+    if (events == connection.events) { return; }
+    connection.events = events;
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = connection_id;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void SearchFrontEnd::MarkClosing(uint64_t connection_id, Connection& connection)
+{
+    if (connection.is_closing) { return; }
+    connection.is_closing = true;
+    closing_ids_.push_back(connection_id);
+    UpdateEvents(connection_id, connection);
+}
+
+void SearchFrontEnd::CloseDrainedConnections()
+{
+    //Соединения с неотправленными ответами остаются в списке до следующей итерации
+    std::vector<uint64_t> still_closing;
+    for (const uint64_t connection_id : closing_ids_) {
+        const auto it = connections_.find(connection_id);
+        if (it == connections_.end()) { continue; }
+        if (it->second.output.empty() && it->second.input.find('\n') == std::string::npos) {
+            CloseConnection(connection_id);
+        }
+        else {
+            still_closing.push_back(connection_id);
+        }
+    }
+    closing_ids_.swap(still_closing);
+}
+
+void SearchFrontEnd::CloseConnection(uint64_t connection_id)
+{
+    const auto it = connections_.find(connection_id);
+    if (it == connections_.end()) { return; }
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    close(it->second.fd);
+    connections_.erase(it);
+    //Освободился дескриптор: можно вернуть запасной и снова принимать соединения
+    if (reserve_fd_ < 0) { reserve_fd_ = OpenReserveDescriptor(); }
+    if (is_accept_paused_) { SetAcceptPaused(false); }
+}
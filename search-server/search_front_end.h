@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <sys/epoll.h>
+#include <unordered_map>
+#include <vector>
+#include "search_server.h"
+
+//Сетевой фронтенд поискового сервера на epoll. Принимает соединения по TCP и Unix-сокетам.
+//Протокол строковый: запрос - строка с текстом запроса, ответ - строка
+//"<количество> <id> <relevance> <rating> ..." или "ERROR <сообщение>". Ответы приходят в порядке запросов,
+//поэтому клиент может отправлять запросы, не дожидаясь ответов.
+//Один поток обслуживает все соединения: запросы, пришедшие за одну итерацию цикла событий,
+//выполняются одним пакетом параллельно. Соединение, которое не читает ответы, перестаёт читаться,
+//пока они не будут отправлены. Время от чтения запроса до отправки ответа
+//записывается в профиль как этап SERVE_REQUEST
+class SearchFrontEnd
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    //Сервер должен существовать, пока работает фронтенд, и не изменяться во время Run
+    explicit SearchFrontEnd(const SearchServer& search_server, size_t max_batch_size = 1024);
+    
+    SearchFrontEnd(const SearchFrontEnd&) = delete;
+    
+    SearchFrontEnd& operator=(const SearchFrontEnd&) = delete;
+    
+    ~SearchFrontEnd();
+    
+    //Возвращает порт: при port == 0 он выбирается системой. Бросает std::runtime_error
+    uint16_t ListenTcp(const std::string& address, uint16_t port);
+    
+    //Бросает std::runtime_error
+    void ListenUnix(const std::string& path);
+    
+    //Обрабатывает события, пока не будет вызван Stop
+    void Run();
+    
+    //Можно вызывать из любого потока
+    void Stop();
+    
+    static std::string FormatDocuments(const std::vector<Document>& documents);
+
+private:
+    struct Connection
+    {
+        int fd = -1;
+        std::string input;
+        std::string output;
+        bool is_closing = false;
+        //Запросы соединения в текущем пакете
+        size_t pending_count = 0;
+        //Соединение в backlog_ids_: в input остались строки, не вошедшие в пакет
+        bool has_backlog = false;
+        //События, на которые соединение подписано в epoll
+        uint32_t events = EPOLLIN;
+    };
+    
+    struct PendingQuery
+    {
+        uint64_t connection_id;
+        std::string query;
+        Clock::time_point received;
+    };
+    
+    const SearchServer& search_server_;
+    const size_t max_batch_size_;
+    int epoll_fd_;
+    int wake_fd_;
+    std::vector<int> listen_fds_;
+    std::vector<std::string> unix_paths_;
+    std::unordered_map<uint64_t, Connection> connections_;
+    uint64_t next_connection_id_ = 0;
+    std::vector<PendingQuery> pending_queries_;
+    std::vector<uint64_t> closing_ids_;
+    std::vector<uint64_t> backlog_ids_;
+    //Запасной дескриптор: когда дескрипторы кончаются, он освобождается, чтобы принять и сразу закрыть соединение
+    int reserve_fd_ = -1;
+    //Слушающие сокеты сняты с epoll до закрытия какого-нибудь соединения
+    bool is_accept_paused_ = false;
+    
+    void AddListener(int fd);
+    
+    void AcceptConnections(int listen_fd);
+    
+    //Соединение из очереди отклоняется через запасной дескриптор. Без него приём приостанавливается:
+    //иначе слушающий сокет остаётся готовым и цикл событий крутится вхолостую
+    void HandleDescriptorExhaustion(int listen_fd);
+    
+    void SetAcceptPaused(bool is_paused);
+    
+    void ReadQueries(uint64_t connection_id, Connection& connection);
+    
+    //Переносит строки из input в пакет, не больше MAX_PENDING_QUERIES запросов соединения
+    void ExtractQueries(uint64_t connection_id, Connection& connection);
+    
+    //Ставит соединение в очередь следующей итерации, если в input есть целые строки, и сообщает, есть ли они
+    bool ScheduleBacklog(uint64_t connection_id, Connection& connection);
+    
+    void ExtractBacklogQueries();
+    
+    void ExecuteBatch();
+    
+    void WriteOutput(uint64_t connection_id, Connection& connection);
+    
+    void UpdateEvents(uint64_t connection_id, Connection& connection);
+    
+    //Соединение закроется, когда будут отправлены все ответы
+    void MarkClosing(uint64_t connection_id, Connection& connection);
+    
+    void CloseDrainedConnections();
+    
+    void CloseConnection(uint64_t connection_id);
+};
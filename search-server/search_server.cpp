@@ -1,13 +1,16 @@
 #include <numeric>
 #include <cmath>
 #include "search_server.h"
+#include "document_reordering.h"
+#include "sorted_intersection.h"
 
-SearchServer::SearchServer() {}
+SearchServer::SearchServer(std::pmr::memory_resource* resource) : resource_(resource) {}
 
-SearchServer::SearchServer(const std::string& stop_words_text) : SearchServer(std::string_view(stop_words_text)){}
+SearchServer::SearchServer(const std::string& stop_words_text, std::pmr::memory_resource* resource) : SearchServer(
+        std::string_view(stop_words_text), resource){}
 
-SearchServer::SearchServer(const std::string_view& stop_words_text) : SearchServer(
-        SplitIntoWordsView(stop_words_text))  // Invoke delegating constructor from string container
+SearchServer::SearchServer(const std::string_view& stop_words_text, std::pmr::memory_resource* resource)
+        : SearchServer(SplitIntoWordsView(stop_words_text), resource)  // Invoke delegating constructor from string container
 {
     if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
         throw std::invalid_argument("Stop-word contains invalid characters.");
@@ -18,18 +21,64 @@ void SearchServer::AddDocument(int document_id, const std::string_view& document
         const std::vector<int>& ratings)
 {
     if (document_id < 0) { throw std::invalid_argument("Document ID cannot be less than zero"); }
-    if (documents_.count(document_id) != 0) { throw std::invalid_argument("Document ID cannot be repeated"); }
+    if (documents_.Contains(document_id)) { throw std::invalid_argument("Document ID cannot be repeated"); }
     
     const std::vector<std::string_view> words = SplitIntoWordsNoStop(document);
-    const double inv_word_count = 1.0 / words.size();
+    //Проверяем все слова до изменения индекса, чтобы при ошибке сервер остался прежним
     for (const std::string_view& word_view : words) {
         if (!IsValidWord(word_view)) { throw std::invalid_argument("Word in document contains invalid characters."); }
-        auto [it_word, _] = words_.emplace(word_view);
-        word_to_document_freqs_[*it_word][document_id] += inv_word_count;
-        document_to_word_freqs_[document_id][*it_word] += inv_word_count;
     }
+    InsertDocument(document_id, words, status, ratings);
+}
+
+void SearchServer::AddDocuments(const std::vector<DocumentRecord>& documents)
+{
+    AddDocuments(std::execution::seq, documents);
+}
+
+void SearchServer::InsertDocument(int document_id, const std::vector<std::string_view>& words, DocumentStatus status,
+        const std::vector<int>& ratings)
+{
+    const double inv_word_count = 1.0 / words.size();
+    const int ordinal = static_cast<int>(documents_.size());
+    std::pmr::vector<int> term_ids(resource_);
+    term_ids.reserve(words.size());
+    for (const std::string_view& word_view : words) {
+        term_ids.push_back(words_.Insert(word_view).first);
+    }
+    //Повторы слова идут подряд: в постинг слова добавляется одна запись с его частотой
+    std::sort(term_ids.begin(), term_ids.end());
+#ifndef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+    std::pmr::vector<WordFrequenciesView::Entry> word_freqs(resource_);
+#endif
+    for (auto it = term_ids.begin(); it != term_ids.end();) {
+        const auto run_end = std::upper_bound(it, term_ids.end(), *it);
+        auto& document_freqs = word_to_document_freqs_[words_[*it]];
+        //Номер нового документа больше всех номеров, и с подсказкой end() вставка выполняется за O(1)
+        const double term_freq = (run_end - it) * inv_word_count;
+        document_freqs.emplace_hint(document_freqs.end(), ordinal, term_freq);
+        if (max_term_freqs_.size() <= static_cast<size_t>(*it)) {
+            max_term_freqs_.resize(words_.size(), 0.0);
+            term_documents_.resize(words_.size());
+        }
+        max_term_freqs_[*it] = std::max(max_term_freqs_[*it], term_freq);
+        term_documents_[*it].Insert(ordinal);
+#ifndef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+        word_freqs.emplace_back(*it, term_freq);
+#endif
+        it = run_end;
+    }
+#ifndef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+    term_ids.erase(std::unique(term_ids.begin(), term_ids.end()), term_ids.end());
+    term_ids.shrink_to_fit();
+    document_term_ids_.push_back(std::move(term_ids));
+    std::sort(word_freqs.begin(), word_freqs.end(), [this](const auto& lhs, const auto& rhs) {
+        return words_[lhs.first] < words_[rhs.first];
+    });
+    document_word_freqs_.push_back(std::move(word_freqs));
+#endif
     order_documents_id_.insert(document_id);
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
+    documents_.Insert(document_id, ComputeAverageRating(ratings), status);
 }
 
 std::vector<Document> SearchServer::FindTopDocuments(std::execution::parallel_policy, const std::string_view& raw_query,
@@ -50,6 +99,44 @@ std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_p
             });
 }
 
+std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_policy,
+        const std::string_view& raw_query, DocumentStatus status, QueryStats& stats) const
+{
+    return FindTopDocuments(std::execution::seq, raw_query,
+            [status]([[maybe_unused]] int document_id, DocumentStatus document_status, [[maybe_unused]] int rating) {
+                return document_status == status;
+            }, stats);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_policy,
+        const std::string_view& raw_query, DocumentStatus status, const SearchCursor& cursor, size_t page_size) const
+{
+    return FindTopDocuments(std::execution::seq, raw_query,
+            [status]([[maybe_unused]] int document_id, DocumentStatus document_status, [[maybe_unused]] int rating) {
+                return document_status == status;
+            }, cursor, page_size);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_policy,
+        const std::string_view& raw_query, const DocumentFilter& filter) const
+{
+    const CandidateBitmap candidates = filter.Evaluate(documents_);
+    return FindTopDocuments(std::execution::seq, raw_query, std::cref(candidates));
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::execution::parallel_policy,
+        const std::string_view& raw_query, const DocumentFilter& filter) const
+{
+    const CandidateBitmap candidates = filter.Evaluate(documents_);
+    return FindTopDocuments(std::execution::par, raw_query, std::cref(candidates));
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw_query,
+        const DocumentFilter& filter) const
+{
+    return FindTopDocuments(std::execution::seq, raw_query, filter);
+}
+
 std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw_query, DocumentStatus status) const
 {
     return FindTopDocuments(std::execution::seq, raw_query, status);
@@ -70,61 +157,86 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view& raw
     return FindTopDocuments(std::execution::seq, raw_query);
 }
 
+std::future<TopDocumentsResult> SearchServer::FindTopDocumentsAsync(const std::string_view& raw_query,
+        DocumentStatus status, const QueryBudget& budget) const
+{
+    return FindTopDocumentsAsync(raw_query,
+            [status]([[maybe_unused]] int document_id, DocumentStatus document_status, [[maybe_unused]] int rating) {
+                return document_status == status;
+            }, budget);
+}
+
+std::future<TopDocumentsResult> SearchServer::FindTopDocumentsAsync(const std::string_view& raw_query,
+        const QueryBudget& budget) const
+{
+    return FindTopDocumentsAsync(raw_query, DocumentStatus::ACTUAL, budget);
+}
+
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::string_view& raw_query,
         int document_id) const
 {
-    //LOG_DURATION;
-    auto query = ParseQuery(raw_query);
-    std::vector<std::string_view> matched_words;
-    for (const std::string_view& word_view : query.minus_words) {
-        if (document_to_word_freqs_.at(document_id).count(word_view)) {
-            std::vector<std::string_view> v;
-            return std::tie(v, documents_.at(document_id).status);
-        }
-    }
-    for (const std::string_view& word_view : query.plus_words) {
-        if (document_to_word_freqs_.at(document_id).count(word_view)) {
-            auto it = words_.find(word_view);
-            matched_words.emplace_back(*it);
-        }
-    }
-    return std::tie(matched_words, documents_.at(document_id).status);
+    PROFILE_STAGE(ProfileStage::MATCH_DOCUMENT);
+    return MatchQuery(ParseQuery(raw_query), document_id);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::string_view& raw_query,
+        int document_id, QueryStats& stats) const
+{
+    PROFILE_STAGE(ProfileStage::MATCH_DOCUMENT);
+    stats = QueryStats();
+    QueryStageTimer total_timer(&stats, ProfileStage::MATCH_DOCUMENT);
+    const auto query = [&]() {
+        QueryStageTimer parse_timer(&stats, ProfileStage::PARSE);
+        return ParseQuery(raw_query);
+    }();
+    FillTermStats(query, stats);
+    auto result = MatchQuery(query, document_id);
+    stats.result_count = std::get<0>(result).size();
+    return result;
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::execution::parallel_policy,
         const std::string_view& raw_query, int document_id) const
 {
-    //LOG_DURATION;
+    PROFILE_STAGE(ProfileStage::MATCH_DOCUMENT);
     Query query = ParseQueryDuplicate(raw_query);
+    const int ordinal = documents_.GetOrdinal(document_id);
+    const DocumentStatus status = documents_.GetStatus(ordinal);
+    //Найденные обязательные слова сравниваются по количеству, поэтому повторы в запросе убираются
+    std::sort(query.required_words.begin(), query.required_words.end());
+    query.required_words.erase(std::unique(query.required_words.begin(), query.required_words.end()),
+            query.required_words.end());
     
-    bool minus_word_is_find = std::any_of(std::execution::par, query.minus_words.begin(), query.minus_words.end(),
-            [document_id, this](const std::string_view& word_view) -> bool {
-                const auto it = word_to_document_freqs_.find(word_view);
-                return it != word_to_document_freqs_.end() && it->second.count(document_id);
+    //Документ без обязательного слова не подходит под запрос так же, как документ с минус-словом
+    bool minus_word_is_find = DocumentContainsAnyTerm(document_id, query.minus_words)
+            || FindDocumentTerms(document_id, query.required_words).size() != query.required_words.size();
+    minus_word_is_find = minus_word_is_find || std::any_of(query.minus_prefixes.begin(), query.minus_prefixes.end(),
+            [document_id, this](const std::string_view& prefix) {
+                return !FindDocumentTermsWithPrefix(document_id, prefix).empty();
+            });
+    minus_word_is_find = minus_word_is_find || std::any_of(query.minus_fuzzy_words.begin(),
+            query.minus_fuzzy_words.end(), [document_id, this](const FuzzyWord& fuzzy_word) {
+                return !FindDocumentTermsWithinDistance(document_id, fuzzy_word).empty();
             });
     if (minus_word_is_find) {
         std::vector<std::string_view> v;
-        return std::tie(v, documents_.at(document_id).status);
+        return std::tie(v, status);
     }
-    std::vector<std::string_view> matched_words(query.plus_words.size());
-    auto end_it = std::copy_if(std::execution::par, query.plus_words.begin(), query.plus_words.end(),matched_words.begin(),
-            [document_id, this](std::string_view word_view) -> bool {
-                return document_to_word_freqs_.at(document_id).count(word_view);
-            });
-    
-    std::sort(std::execution::par, matched_words.begin(), end_it);
-    end_it = std::unique(std::execution::par, matched_words.begin(), end_it);
-    matched_words.erase(end_it, matched_words.end());
-    
-    std::transform(std::execution::par, matched_words.begin(), matched_words.end(), matched_words.begin(),
-            [this](std::string_view word_view) -> std::string_view {
-                auto it = words_.find(word_view);
-                if(it != words_.end()) { word_view = *it; }
-                else{ throw std::invalid_argument("Word \"" + std::string(word_view) + "\" is not find in words container."); }
-                return word_view;
-            });
+    std::vector<std::string_view> matched_words = FindDocumentTerms(document_id, query.plus_words);
+    for (const std::string_view& prefix : query.plus_prefixes) {
+        const std::vector<std::string_view> terms = FindDocumentTermsWithPrefix(document_id, prefix);
+        matched_words.insert(matched_words.end(), terms.begin(), terms.end());
+    }
+    for (const FuzzyWord& fuzzy_word : query.plus_fuzzy_words) {
+        const std::vector<std::string_view> terms = FindDocumentTermsWithinDistance(document_id, fuzzy_word);
+        matched_words.insert(matched_words.end(), terms.begin(), terms.end());
+    }
+    //Все слова уже указывают в хранилище слов индекса: повторно искать их не нужно
+    std::sort(std::execution::par, matched_words.begin(), matched_words.end());
+    matched_words.erase(std::unique(std::execution::par, matched_words.begin(), matched_words.end()),
+            matched_words.end());
     
-    return std::tie(matched_words, documents_.at(document_id).status);
+    return std::tie(matched_words, status);
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(std::execution::sequenced_policy, const std::string_view& raw_query,
@@ -133,18 +245,158 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     return MatchDocument(raw_query, document_id);
 }
 
+void SearchServer::MatchDocuments(const std::string_view& raw_query, const std::vector<int>& document_ids,
+        std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>>& results) const
+{
+    MatchDocuments(std::execution::seq, raw_query, document_ids, results);
+}
+
 int SearchServer::GetDocumentCount() const
 {
     return documents_.size();
 }
 
-const std::map<std::string_view, double>& SearchServer::GetWordFrequencies(int document_id) const
+void SearchServer::SetFuzzyPenalty(double penalty)
+{
+    if (!(penalty > 0.0 && penalty <= 1.0)) { throw std::invalid_argument("Fuzzy penalty must be in (0, 1]."); }
+    fuzzy_penalty_ = penalty;
+}
+
+double SearchServer::GetFuzzyPenalty() const
+{
+    return fuzzy_penalty_;
+}
+
+void SearchServer::CheckQuery(const std::string_view& raw_query) const
+{
+    ParseQueryDuplicate(raw_query);
+}
+
+CorpusStatistics SearchServer::GetCorpusStatistics(const std::string_view& raw_query) const
+{
+    CorpusStatistics statistics;
+    statistics.document_count = GetDocumentCount();
+    const Query query = ParseQuery(raw_query);
+    for (const std::string_view& word_view : query.plus_words) {
+        const auto it = word_to_document_freqs_.find(word_view);
+        if (it != word_to_document_freqs_.end() && !it->second.empty()) {
+            statistics.document_freqs.emplace(word_view, static_cast<int>(it->second.size()));
+        }
+    }
+    //Документы шардов не пересекаются, поэтому сумма размеров виртуальных постингов - размер общего
+    for (const std::string_view& prefix : query.plus_prefixes) {
+        const size_t document_freq = MergePrefixPostings(prefix, MAX_PREFIX_EXPANSION_COUNT).size();
+        if (document_freq != 0) {
+            statistics.document_freqs.emplace(std::string(prefix) + '*', static_cast<int>(document_freq));
+        }
+    }
+    //Найденные слова оцениваются как обычные, поэтому нужны их собственные частоты
+    for (const FuzzyWord& fuzzy_word : query.plus_fuzzy_words) {
+        for (const auto& [term, _] : ExpandFuzzy(fuzzy_word.data, fuzzy_word.max_distance,
+                MAX_FUZZY_EXPANSION_COUNT)) {
+            statistics.document_freqs.emplace(term, static_cast<int>(word_to_document_freqs_.at(term).size()));
+        }
+    }
+    return statistics;
+}
+
+bool SearchServer::CompareByRelevance(const Document& lhs, const Document& rhs)
 {
-    if (!document_to_word_freqs_.count(document_id)) {
-        const static std::map<std::string_view, double> word_frequencies_empty;
-        return word_frequencies_empty;
+    if (std::abs(lhs.relevance - rhs.relevance) >= ACCURACY_COMPARISON) {
+        return lhs.relevance > rhs.relevance;
+    }
+    if (lhs.rating != rhs.rating) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.id < rhs.id;
+}
+
+WordFrequenciesView SearchServer::GetWordFrequencies(int document_id) const
+{
+    const int ordinal = documents_.FindOrdinal(document_id);
+    if (ordinal < 0) {
+        return {};
+    }
+#ifdef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+    std::vector<WordFrequenciesView::Entry> word_freqs;
+    for (int term_id = 0; term_id < static_cast<int>(term_documents_.size()); ++term_id) {
+        if (term_documents_[term_id].Contains(ordinal)) {
+            word_freqs.emplace_back(term_id, word_to_document_freqs_.at(words_[term_id]).at(ordinal));
+        }
+    }
+    return {std::move(word_freqs), words_};
+#else
+    const std::pmr::vector<WordFrequenciesView::Entry>& word_freqs = document_word_freqs_[ordinal];
+    return {word_freqs.data(), word_freqs.size(), words_};
+#endif
+}
+
+MemoryUsage SearchServer::GetMemoryUsage() const
+{
+    MemoryUsage memory_usage;
+    auto add_string_set = [&memory_usage](std::string_view name, const std::set<std::string, std::less<>>& strings) {
+        StructureMemoryUsage usage{name, strings.size(), strings.size() * EstimateTreeNodeBytes<std::string>()};
+        for (const std::string& str : strings) {
+            usage.bytes += EstimateStringHeapBytes(str);
+        }
+        memory_usage.structures.push_back(usage);
+    };
+    add_string_set("stop_words_", stop_words_);
+    
+    memory_usage.structures.push_back({"words_", words_.size(), words_.GetArenaBytes() + words_.GetIndexBytes()});
+    
+    //Для вложенных словарей считаются записи внутренних словарей
+    StructureMemoryUsage word_to_document_freqs{"word_to_document_freqs_", 0,
+            word_to_document_freqs_.size() * EstimateTreeNodeBytes<decltype(word_to_document_freqs_)::value_type>()};
+    for (const auto& [word, document_freqs] : word_to_document_freqs_) {
+        word_to_document_freqs.element_count += document_freqs.size();
+        word_to_document_freqs.bytes += document_freqs.size() * EstimateTreeNodeBytes<std::pair<const int, double>>();
+        if (!document_freqs.empty()) { memory_usage.AddPostingLength(document_freqs.size()); }
+        int previous_ordinal = -1;
+        for (const auto& posting : document_freqs) {
+            memory_usage.AddPostingGap(posting.first - previous_ordinal);
+            previous_ordinal = posting.first;
+        }
     }
-    return document_to_word_freqs_.at(document_id);
+    memory_usage.structures.push_back(word_to_document_freqs);
+    
+#ifndef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+    StructureMemoryUsage document_term_ids{"document_term_ids_", 0,
+            EstimateAllocationBytes(document_term_ids_.capacity() * sizeof(std::pmr::vector<int>))};
+    for (const std::pmr::vector<int>& term_ids : document_term_ids_) {
+        document_term_ids.element_count += term_ids.size();
+        document_term_ids.bytes += EstimateAllocationBytes(term_ids.capacity() * sizeof(int));
+    }
+    memory_usage.structures.push_back(document_term_ids);
+    StructureMemoryUsage document_word_freqs{"document_word_freqs_", 0,
+            EstimateAllocationBytes(document_word_freqs_.capacity()
+                                    * sizeof(std::pmr::vector<WordFrequenciesView::Entry>))};
+    for (const std::pmr::vector<WordFrequenciesView::Entry>& word_freqs : document_word_freqs_) {
+        document_word_freqs.element_count += word_freqs.size();
+        document_word_freqs.bytes += EstimateAllocationBytes(word_freqs.capacity()
+                                                             * sizeof(WordFrequenciesView::Entry));
+    }
+    memory_usage.structures.push_back(document_word_freqs);
+#endif
+    
+    StructureMemoryUsage term_documents{"term_documents_", 0,
+            EstimateAllocationBytes(term_documents_.capacity() * sizeof(DocumentSet))};
+    for (const DocumentSet& documents : term_documents_) {
+        term_documents.element_count += documents.size();
+        term_documents.bytes += documents.GetBytes();
+    }
+    memory_usage.structures.push_back(term_documents);
+    memory_usage.structures.push_back({"max_term_freqs_", max_term_freqs_.size(),
+                                       EstimateAllocationBytes(max_term_freqs_.capacity() * sizeof(double))});
+    memory_usage.structures.push_back({"documents_", documents_.size(), documents_.GetBytes()});
+    memory_usage.structures.push_back({"order_documents_id_", order_documents_id_.size(),
+                                       order_documents_id_.size() * EstimateTreeNodeBytes<int>()});
+    return memory_usage;
+}
+
+std::pmr::memory_resource* SearchServer::GetMemoryResource() const
+{
+    return resource_;
 }
 
 void SearchServer::RemoveDocument(int document_id)
@@ -152,6 +404,60 @@ void SearchServer::RemoveDocument(int document_id)
     SearchServer::RemoveDocument(std::execution::seq, document_id);
 }
 
+void SearchServer::ReorderDocuments()
+{
+    //Слова документов берутся из обратного индекса, поэтому перестановка работает и без прямого индекса
+    std::vector<std::vector<int>> document_terms(documents_.size());
+    size_t term_count = 0;
+    for (const auto& [word, postings] : word_to_document_freqs_) {
+        for (const auto& posting : postings) {
+            document_terms[posting.first].push_back(static_cast<int>(term_count));
+        }
+        ++term_count;
+    }
+    const std::vector<int> order = ComputeLocalityOrder(document_terms, term_count);
+    std::vector<int> new_ordinals(order.size());
+    for (size_t ordinal = 0; ordinal < order.size(); ++ordinal) {
+        new_ordinals[order[ordinal]] = static_cast<int>(ordinal);
+    }
+    documents_.Reorder(order);
+#ifndef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+    std::pmr::vector<std::pmr::vector<int>> document_term_ids(resource_);
+    document_term_ids.reserve(order.size());
+    for (const int old_ordinal : order) {
+        document_term_ids.push_back(std::move(document_term_ids_[old_ordinal]));
+    }
+    document_term_ids_ = std::move(document_term_ids);
+    std::pmr::vector<std::pmr::vector<WordFrequenciesView::Entry>> document_word_freqs(resource_);
+    document_word_freqs.reserve(order.size());
+    for (const int old_ordinal : order) {
+        document_word_freqs.push_back(std::move(document_word_freqs_[old_ordinal]));
+    }
+    document_word_freqs_ = std::move(document_word_freqs);
+#endif
+    
+    //Узлы постингов переиспользуются: меняется только ключ, память не выделяется заново
+    std::vector<std::pmr::map<int, double>::node_type> nodes;
+    for (auto& [word, postings] : word_to_document_freqs_) {
+        nodes.clear();
+        while (!postings.empty()) {
+            nodes.push_back(postings.extract(postings.begin()));
+            nodes.back().key() = new_ordinals[nodes.back().key()];
+        }
+        std::sort(nodes.begin(), nodes.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.key() < rhs.key();
+        });
+        DocumentSet& documents = term_documents_[FindTermId(word)];
+        documents = DocumentSet(resource_);
+        for (auto& node : nodes) {
+            documents.Insert(node.key());
+            postings.insert(postings.end(), std::move(node));
+        }
+        //После перенумерации номера документов слова идут плотнее, и часть контейнеров выгоднее хранить отрезками
+        documents.Optimize();
+    }
+}
+
 bool SearchServer::IsValidWord(const std::string_view& word)
 {
     return std::none_of(word.begin(), word.end(), [](char c) {
@@ -189,16 +495,49 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings)
 SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text_view) const
 {
     bool is_minus = false;
+    bool is_required = false;
     // Word shouldn't be empty
     if (text_view[0] == '-') {
         is_minus = true;
         text_view = text_view.substr(1);
     }
-    if (text_view[0] == '-') { throw std::invalid_argument("Query word contains \"minus\" character."); }
+    else if (text_view[0] == '+') {
+        is_required = true;
+        text_view = text_view.substr(1);
+    }
     if (is_minus && text_view.empty()) { throw std::invalid_argument("Minus query word is empty."); }
+    if (is_required && text_view.empty()) { throw std::invalid_argument("Required query word is empty."); }
+    if (text_view[0] == '-') { throw std::invalid_argument("Query word contains \"minus\" character."); }
+    if ((is_minus || is_required) && text_view[0] == '+') {
+        throw std::invalid_argument("Query word contains \"plus\" character.");
+    }
+    int max_distance = -1;
+    const size_t tilde_pos = text_view.rfind('~');
+    //Тильда в начале слова, как и одиночные "~" и "*", - обычное слово, как до появления нечётких слов и префиксов
+    if (tilde_pos != std::string_view::npos && tilde_pos > 0) {
+        const std::string_view suffix = text_view.substr(tilde_pos + 1);
+        //"слово~" - одна правка; тильда с другим суффиксом - часть слова
+        if (std::all_of(suffix.begin(), suffix.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            max_distance = suffix.empty() ? 1 : suffix.size() == 1 ? suffix[0] - '0' : MAX_FUZZY_DISTANCE + 1;
+            if (max_distance > MAX_FUZZY_DISTANCE) {
+                throw std::invalid_argument("Fuzzy query word distance is greater than "
+                        + std::to_string(MAX_FUZZY_DISTANCE) + ".");
+            }
+            text_view = text_view.substr(0, tilde_pos);
+        }
+    }
+    bool is_prefix = false;
+    if (max_distance < 0 && text_view.size() > 1 && text_view.back() == '*') {
+        is_prefix = true;
+        text_view.remove_suffix(1);
+    }
     if (!IsValidWord(text_view)) { throw std::invalid_argument("Query word contains invalid characters."); }
+    if (is_required && (is_prefix || max_distance >= 0)) {
+        throw std::invalid_argument("Required query word must not have a prefix or fuzzy suffix.");
+    }
     
-    return {text_view, is_minus, IsStopWord(text_view)};
+    return {text_view, is_minus, !is_prefix && max_distance < 0 && IsStopWord(text_view), is_prefix, max_distance,
+            is_required};
 }
 
 
@@ -212,21 +551,45 @@ SearchServer::Query SearchServer::ParseQuery(const std::string_view& text) const
     };
     sort_unique_erase(query.plus_words);
     sort_unique_erase(query.minus_words);
+    sort_unique_erase(query.plus_prefixes);
+    sort_unique_erase(query.minus_prefixes);
+    sort_unique_erase(query.required_words);
+    auto sort_unique_erase_fuzzy = [](std::vector<FuzzyWord>& words) {
+        auto as_tuple = [](const FuzzyWord& word) { return std::tie(word.data, word.max_distance); };
+        std::sort(words.begin(), words.end(), [&as_tuple](const FuzzyWord& lhs, const FuzzyWord& rhs) {
+            return as_tuple(lhs) < as_tuple(rhs);
+        });
+        auto it_unique = std::unique(words.begin(), words.end(), [&as_tuple](const FuzzyWord& lhs, const FuzzyWord& rhs) {
+            return as_tuple(lhs) == as_tuple(rhs);
+        });
+        words.erase(it_unique, words.end());
+    };
+    sort_unique_erase_fuzzy(query.plus_fuzzy_words);
+    sort_unique_erase_fuzzy(query.minus_fuzzy_words);
     return query;
 }
 
 SearchServer::Query SearchServer::ParseQueryDuplicate(const std::string_view& text) const
 {
+    PROFILE_STAGE(ProfileStage::PARSE);
     Query query;
     for (const std::string_view& word : SplitIntoWordsView(text)) {
         if (word.empty()) { continue; }
         const QueryWord query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
+        if (query_word.max_distance >= 0) {
+            (query_word.is_minus ? query.minus_fuzzy_words : query.plus_fuzzy_words).push_back(
+                    {query_word.data, query_word.max_distance});
+        }
+        else if (query_word.is_prefix) {
+            (query_word.is_minus ? query.minus_prefixes : query.plus_prefixes).emplace_back(query_word.data);
+        }
+        else if (!query_word.is_stop) {
             if (query_word.is_minus) {
                 query.minus_words.emplace_back(query_word.data);
             }
             else {
                 query.plus_words.emplace_back(query_word.data);
+                if (query_word.is_required) { query.required_words.emplace_back(query_word.data); }
             }
         }
     }
@@ -237,3 +600,449 @@ double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view& word
 {
     return std::log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
 }
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchQuery(const Query& query,
+        int document_id) const
+{
+    const DocumentStatus status = documents_.GetStatus(documents_.GetOrdinal(document_id));
+    if (DocumentContainsAnyTerm(document_id, query.minus_words)
+            || FindDocumentTerms(document_id, query.required_words).size() != query.required_words.size()) {
+        std::vector<std::string_view> v;
+        return std::tie(v, status);
+    }
+    for (const std::string_view& prefix : query.minus_prefixes) {
+        if (!FindDocumentTermsWithPrefix(document_id, prefix).empty()) {
+            std::vector<std::string_view> v;
+            return std::tie(v, status);
+        }
+    }
+    for (const FuzzyWord& fuzzy_word : query.minus_fuzzy_words) {
+        if (!FindDocumentTermsWithinDistance(document_id, fuzzy_word).empty()) {
+            std::vector<std::string_view> v;
+            return std::tie(v, status);
+        }
+    }
+    std::vector<std::string_view> matched_words = FindDocumentTerms(document_id, query.plus_words);
+    if (!query.plus_prefixes.empty() || !query.plus_fuzzy_words.empty()) {
+        for (const std::string_view& prefix : query.plus_prefixes) {
+            const std::vector<std::string_view> terms = FindDocumentTermsWithPrefix(document_id, prefix);
+            matched_words.insert(matched_words.end(), terms.begin(), terms.end());
+        }
+        for (const FuzzyWord& fuzzy_word : query.plus_fuzzy_words) {
+            const std::vector<std::string_view> terms = FindDocumentTermsWithinDistance(document_id, fuzzy_word);
+            matched_words.insert(matched_words.end(), terms.begin(), terms.end());
+        }
+        std::sort(matched_words.begin(), matched_words.end());
+        matched_words.erase(std::unique(matched_words.begin(), matched_words.end()), matched_words.end());
+    }
+    return std::tie(matched_words, status);
+}
+
+int SearchServer::FindTermId(const std::string_view& word) const
+{
+    return words_.Find(word);
+}
+
+std::vector<std::string_view> SearchServer::FindDocumentTerms(int document_id,
+        const std::vector<std::string_view>& words) const
+{
+    const std::vector<int> term_ids = FindSortedTermIds(words);
+    std::vector<int> matched_ids(term_ids.size());
+#ifdef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+    const int ordinal = documents_.GetOrdinal(document_id);
+    matched_ids.erase(std::copy_if(term_ids.begin(), term_ids.end(), matched_ids.begin(), [this, ordinal](int term_id) {
+        return term_documents_[term_id].Contains(ordinal);
+    }), matched_ids.end());
+#else
+    const std::pmr::vector<int>& document_term_ids = document_term_ids_[documents_.GetOrdinal(document_id)];
+    matched_ids.resize(IntersectSorted(term_ids.data(), term_ids.size(), document_term_ids.data(),
+            document_term_ids.size(), matched_ids.data()));
+#endif
+    std::vector<std::string_view> terms;
+    terms.reserve(matched_ids.size());
+    for (const int term_id : matched_ids) {
+        terms.push_back(words_[term_id]);
+    }
+    std::sort(terms.begin(), terms.end());
+    return terms;
+}
+
+bool SearchServer::DocumentContainsAnyTerm(int document_id, const std::vector<std::string_view>& words) const
+{
+    const std::vector<int> term_ids = FindSortedTermIds(words);
+#ifdef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+    const int ordinal = documents_.GetOrdinal(document_id);
+    return std::any_of(term_ids.begin(), term_ids.end(), [this, ordinal](int term_id) {
+        return term_documents_[term_id].Contains(ordinal);
+    });
+#else
+    const std::pmr::vector<int>& document_term_ids = document_term_ids_[documents_.GetOrdinal(document_id)];
+    return IntersectsSorted(term_ids.data(), term_ids.size(), document_term_ids.data(), document_term_ids.size());
+#endif
+}
+
+std::vector<int> SearchServer::FindSortedTermIds(const std::vector<std::string_view>& words) const
+{
+    std::vector<int> term_ids;
+    term_ids.reserve(words.size());
+    for (const std::string_view& word_view : words) {
+        const int term_id = FindTermId(word_view);
+        if (term_id >= 0) { term_ids.push_back(term_id); }
+    }
+    std::sort(term_ids.begin(), term_ids.end());
+    term_ids.erase(std::unique(term_ids.begin(), term_ids.end()), term_ids.end());
+    return term_ids;
+}
+
+bool SearchServer::ContainsAll(const std::vector<const DocumentSet*>& documents, int ordinal)
+{
+    return std::all_of(documents.begin(), documents.end(), [ordinal](const DocumentSet* document_set) {
+        return document_set->Contains(ordinal);
+    });
+}
+
+std::vector<const DocumentSet*> SearchServer::CollectMinusDocuments(const Query& query) const
+{
+    std::vector<const DocumentSet*> documents;
+    for (const std::string_view& word_view : query.minus_words) {
+        const int term_id = FindTermId(word_view);
+        if (term_id >= 0) { documents.push_back(&term_documents_[term_id]); }
+    }
+    for (const std::string_view& prefix : query.minus_prefixes) {
+        for (const std::string_view& term : ExpandPrefix(prefix, word_to_document_freqs_.size())) {
+            documents.push_back(&term_documents_[FindTermId(term)]);
+        }
+    }
+    for (const FuzzyWord& fuzzy_word : query.minus_fuzzy_words) {
+        for (const auto& [term, _] : ExpandFuzzy(fuzzy_word.data, fuzzy_word.max_distance,
+                word_to_document_freqs_.size())) {
+            documents.push_back(&term_documents_[FindTermId(term)]);
+        }
+    }
+    return documents;
+}
+
+std::vector<std::string_view> SearchServer::ExpandPrefix(std::string_view prefix, size_t max_count) const
+{
+    std::vector<std::string_view> terms;
+    for (auto it = word_to_document_freqs_.lower_bound(prefix);
+            it != word_to_document_freqs_.end() && terms.size() < max_count
+                    && it->first.substr(0, prefix.size()) == prefix; ++it) {
+        if (!it->second.empty()) {
+            terms.push_back(it->first);
+        }
+    }
+    return terms;
+}
+
+std::vector<std::pair<int, double>> SearchServer::MergePrefixPostings(std::string_view prefix, size_t max_count) const
+{
+    using PostingIterator = std::pmr::map<int, double>::const_iterator;
+    std::vector<std::pair<PostingIterator, PostingIterator>> cursors;
+    size_t total_size = 0;
+    for (const std::string_view& term : ExpandPrefix(prefix, max_count)) {
+        const std::pmr::map<int, double>& postings = word_to_document_freqs_.find(term)->second;
+        cursors.emplace_back(postings.begin(), postings.end());
+        total_size += postings.size();
+    }
+    
+    //k-путевое слияние: в куче номера постингов, упорядоченные по номеру текущего документа
+    std::vector<size_t> heap(cursors.size());
+    for (size_t i = 0; i < heap.size(); ++i) {
+        heap[i] = i;
+    }
+    auto greater = [&cursors](size_t lhs, size_t rhs) {
+        return cursors[lhs].first->first > cursors[rhs].first->first;
+    };
+    std::make_heap(heap.begin(), heap.end(), greater);
+    std::vector<std::pair<int, double>> merged;
+    merged.reserve(total_size);
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        auto& [it, end] = cursors[heap.back()];
+        if (!merged.empty() && merged.back().first == it->first) {
+            merged.back().second += it->second;
+        }
+        else {
+            merged.emplace_back(it->first, it->second);
+        }
+        if (++it == end) {
+            heap.pop_back();
+        }
+        else {
+            std::push_heap(heap.begin(), heap.end(), greater);
+        }
+    }
+    return merged;
+}
+
+SearchServer::MatchTerms SearchServer::ResolveMatchTerms(const Query& query) const
+{
+    static const DocumentSet EMPTY_DOCUMENTS;
+    MatchTerms terms;
+    terms.minus_documents = CollectMinusDocuments(query);
+    for (const std::string_view& word_view : query.required_words) {
+        const int term_id = FindTermId(word_view);
+        terms.required_documents.push_back(term_id >= 0 ? &term_documents_[term_id] : &EMPTY_DOCUMENTS);
+    }
+    std::vector<std::string_view> plus_terms;
+    for (const std::string_view& word_view : query.plus_words) {
+        const int term_id = FindTermId(word_view);
+        if (term_id >= 0) { plus_terms.push_back(words_[term_id]); }
+    }
+    //Как в MatchDocument: все слова с префиксом и все слова в пределах расстояния, без ограничения их числа
+    for (const std::string_view& prefix : query.plus_prefixes) {
+        const std::vector<std::string_view> expansion = ExpandPrefix(prefix, word_to_document_freqs_.size());
+        plus_terms.insert(plus_terms.end(), expansion.begin(), expansion.end());
+    }
+    for (const FuzzyWord& fuzzy_word : query.plus_fuzzy_words) {
+        for (const auto& [term, _] : ExpandFuzzy(fuzzy_word.data, fuzzy_word.max_distance,
+                word_to_document_freqs_.size())) {
+            plus_terms.push_back(term);
+        }
+    }
+    std::sort(plus_terms.begin(), plus_terms.end());
+    plus_terms.erase(std::unique(plus_terms.begin(), plus_terms.end()), plus_terms.end());
+    for (const std::string_view& term : plus_terms) {
+        terms.plus_terms.emplace_back(term, &term_documents_[FindTermId(term)]);
+    }
+    return terms;
+}
+
+std::vector<std::string_view> SearchServer::FindDocumentTermsWithPrefix(int document_id, std::string_view prefix) const
+{
+    std::vector<std::string_view> terms;
+#ifdef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+    const int ordinal = documents_.GetOrdinal(document_id);
+    for (const std::string_view& term : ExpandPrefix(prefix, word_to_document_freqs_.size())) {
+        if (word_to_document_freqs_.at(term).count(ordinal)) {
+            terms.push_back(term);
+        }
+    }
+#else
+    for (const int term_id : document_term_ids_[documents_.GetOrdinal(document_id)]) {
+        const std::string_view term = words_[term_id];
+        if (term.substr(0, prefix.size()) == prefix) {
+            terms.push_back(term);
+        }
+    }
+    std::sort(terms.begin(), terms.end());
+#endif
+    return terms;
+}
+
+std::vector<std::pair<std::string_view, int>> SearchServer::ExpandFuzzy(std::string_view word, int max_distance,
+        size_t max_count) const
+{
+    const size_t width = word.size() + 1;
+    //rows[depth * width + j] - расстояние между первыми depth символами слова индекса и word.substr(0, j)
+    std::vector<int> rows(width);
+    std::iota(rows.begin(), rows.end(), 0);
+    //Слово индекса, для префиксов которого посчитаны строки
+    std::string_view previous;
+    std::vector<std::pair<std::string_view, int>> matches;
+    std::string next_prefix;
+    auto it = word_to_document_freqs_.begin();
+    while (it != word_to_document_freqs_.end()) {
+        const std::string_view term = it->first;
+        size_t depth = 0;
+        const size_t max_depth = std::min({previous.size(), term.size(), rows.size() / width - 1});
+        while (depth < max_depth && previous[depth] == term[depth]) {
+            ++depth;
+        }
+        rows.resize((depth + 1) * width);
+        bool is_dead = false;
+        while (depth < term.size()) {
+            rows.resize((depth + 2) * width);
+            const int* const row = rows.data() + depth * width;
+            int* const next_row = rows.data() + (depth + 1) * width;
+            next_row[0] = static_cast<int>(depth + 1);
+            int row_min = next_row[0];
+            for (size_t j = 1; j < width; ++j) {
+                next_row[j] = std::min({row[j] + 1, next_row[j - 1] + 1, row[j - 1] + (word[j - 1] != term[depth])});
+                row_min = std::min(row_min, next_row[j]);
+            }
+            ++depth;
+            if (row_min > max_distance) {
+                is_dead = true;
+                break;
+            }
+        }
+        previous = term;
+        if (is_dead) {
+            //Ни одно слово с префиксом term.substr(0, depth) не подходит: переходим к первому слову после них
+            next_prefix.assign(term.substr(0, depth));
+            while (!next_prefix.empty() && static_cast<unsigned char>(next_prefix.back()) == 0xFF) {
+                next_prefix.pop_back();
+            }
+            if (next_prefix.empty()) { break; }
+            next_prefix.back() = static_cast<char>(static_cast<unsigned char>(next_prefix.back()) + 1);
+            it = word_to_document_freqs_.lower_bound(std::string_view(next_prefix));
+            continue;
+        }
+        const int distance = rows[depth * width + word.size()];
+        if (distance <= max_distance && !it->second.empty()) {
+            matches.emplace_back(term, distance);
+        }
+        ++it;
+    }
+    std::sort(matches.begin(), matches.end(), [](const auto& lhs, const auto& rhs) {
+        return std::tie(lhs.second, lhs.first) < std::tie(rhs.second, rhs.first);
+    });
+    if (matches.size() > max_count) {
+        matches.resize(max_count);
+    }
+    return matches;
+}
+
+std::vector<std::string_view> SearchServer::FindDocumentTermsWithinDistance(int document_id,
+        const FuzzyWord& fuzzy_word) const
+{
+    const int ordinal = documents_.GetOrdinal(document_id);
+    std::vector<std::string_view> terms;
+    for (const auto& [term, _] : ExpandFuzzy(fuzzy_word.data, fuzzy_word.max_distance,
+            word_to_document_freqs_.size())) {
+        if (word_to_document_freqs_.at(term).count(ordinal)) {
+            terms.push_back(term);
+        }
+    }
+    return terms;
+}
+
+SearchServer::QueryPlan SearchServer::PlanQuery(const Query& query, const SearchControl* control) const
+{
+    QueryPlan plan;
+    const size_t document_count = documents_.size();
+    for (const std::string_view& word_view : query.required_words) {
+        const int term_id = FindTermId(word_view);
+        if (term_id < 0 || term_documents_[term_id].empty()) {
+            plan.strategy = QueryStrategy::EMPTY_RESULT;
+            return plan;
+        }
+        plan.required_documents.push_back(&term_documents_[term_id]);
+    }
+    std::stable_sort(plan.required_documents.begin(), plan.required_documents.end(),
+            [](const DocumentSet* lhs, const DocumentSet* rhs) { return lhs->size() < rhs->size(); });
+    size_t largest_minus_posting = 0;
+    for (const std::string_view& word_view : query.minus_words) {
+        const auto it = word_to_document_freqs_.find(word_view);
+        if (it != word_to_document_freqs_.end()) {
+            largest_minus_posting = std::max(largest_minus_posting, it->second.size());
+        }
+    }
+    if (document_count != 0 && largest_minus_posting == document_count) {
+        plan.strategy = QueryStrategy::EMPTY_RESULT;
+        return plan;
+    }
+    plan.is_minus_first = largest_minus_posting != 0 && 2 * largest_minus_posting >= document_count;
+    
+    //Шарды упорядочивают слова по общей статистике, чтобы складывать вклады в одном порядке
+    std::vector<std::pair<size_t, std::string_view>> plus_words;
+    size_t posting_sum = 0;
+    size_t longest_posting = 0;
+    for (const std::string_view& word_view : query.plus_words) {
+        const auto it = word_to_document_freqs_.find(word_view);
+        if (it == word_to_document_freqs_.end() || it->second.empty()) { continue; }
+        const size_t posting_length = it->second.size();
+        size_t document_freq = posting_length;
+        if (control && control->corpus) {
+            const auto corpus_it = control->corpus->document_freqs.find(word_view);
+            if (corpus_it != control->corpus->document_freqs.end()) {
+                document_freq = static_cast<size_t>(corpus_it->second);
+            }
+        }
+        plus_words.emplace_back(document_freq, word_view);
+        posting_sum += posting_length;
+        longest_posting = std::max(longest_posting, posting_length);
+    }
+    std::sort(plus_words.begin(), plus_words.end());
+    for (const auto& [_, word_view] : plus_words) {
+        plan.plus_words.push_back(word_view);
+    }
+    
+    const bool is_plain = query.plus_prefixes.empty() && query.plus_fuzzy_words.empty()
+                          && query.minus_prefixes.empty() && query.minus_fuzzy_words.empty();
+    if (!control || !is_plain || plan.plus_words.empty()) { return plan; }
+    if (!plan.required_documents.empty()) {
+        plan.strategy = QueryStrategy::INTERSECTION;
+        return plan;
+    }
+    //Отброшенные MaxScore документы не выданы бы и так, но курсор отбрасывает документы уже после выбора
+    const bool is_cursor_free = !control->cursor || control->cursor->IsAtStart();
+    if (is_cursor_free && plan.plus_words.size() > 1
+            && longest_posting >= MAX_SCORE_MIN_SKEW * (posting_sum - longest_posting)) {
+        plan.strategy = QueryStrategy::MAX_SCORE;
+    }
+    else if (posting_sum * plan.plus_words.size() * DOCUMENT_AT_A_TIME_RATIO < document_count) {
+        plan.strategy = QueryStrategy::DOCUMENT_AT_A_TIME;
+    }
+    return plan;
+}
+
+void SearchServer::FillScanStats(QueryStats& stats, size_t postings_scanned, size_t rejected_by_predicate,
+        size_t removed_by_minus_words, size_t removed_by_required_words, size_t candidate_count)
+{
+    size_t plus_postings = 0;
+    for (const TermStats& term : stats.terms) {
+        if (!term.is_minus) { plus_postings += term.posting_length; }
+    }
+    stats.postings_scanned = postings_scanned;
+    stats.postings_skipped = plus_postings - postings_scanned;
+    stats.rejected_by_predicate = rejected_by_predicate;
+    stats.removed_by_minus_words = removed_by_minus_words;
+    stats.removed_by_required_words = removed_by_required_words;
+    stats.candidates_before_top_k = candidate_count;
+}
+
+std::pmr::map<int, double>::const_iterator SearchServer::FindPostingFrom(const std::pmr::map<int, double>& postings,
+        int ordinal)
+{
+    return postings.lower_bound(ordinal);
+}
+
+std::vector<std::pair<int, double>>::const_iterator SearchServer::FindPostingFrom(
+        const std::vector<std::pair<int, double>>& postings, int ordinal)
+{
+    return std::lower_bound(postings.begin(), postings.end(), ordinal,
+            [](const std::pair<int, double>& posting, int value) {
+                return posting.first < value;
+            });
+}
+
+void SearchServer::FillTermStats(const Query& query, QueryStats& stats) const
+{
+    stats.plus_term_count = query.plus_words.size() + query.plus_prefixes.size() + query.plus_fuzzy_words.size();
+    stats.minus_term_count = query.minus_words.size() + query.minus_prefixes.size() + query.minus_fuzzy_words.size();
+    stats.terms.clear();
+    auto add_terms = [&](const std::vector<std::string_view>& words, bool is_minus) {
+        for (const std::string_view& word_view : words) {
+            const auto it = word_to_document_freqs_.find(word_view);
+            stats.terms.push_back({std::string(word_view), is_minus,
+                                   it == word_to_document_freqs_.end() ? 0 : it->second.size()});
+        }
+    };
+    add_terms(query.plus_words, false);
+    add_terms(query.minus_words, true);
+    //Для слова с префиксом - длина виртуального постинга
+    for (const std::string_view& prefix : query.plus_prefixes) {
+        stats.terms.push_back({std::string(prefix) + '*', false,
+                               MergePrefixPostings(prefix, MAX_PREFIX_EXPANSION_COUNT).size()});
+    }
+    for (const std::string_view& prefix : query.minus_prefixes) {
+        stats.terms.push_back({std::string(prefix) + '*', true,
+                               MergePrefixPostings(prefix, word_to_document_freqs_.size()).size()});
+    }
+    //Для слова с правками - суммарная длина постингов найденных слов
+    auto add_fuzzy_terms = [&](const std::vector<FuzzyWord>& words, bool is_minus, size_t max_count) {
+        for (const FuzzyWord& fuzzy_word : words) {
+            size_t posting_length = 0;
+            for (const auto& [term, _] : ExpandFuzzy(fuzzy_word.data, fuzzy_word.max_distance, max_count)) {
+                posting_length += word_to_document_freqs_.at(term).size();
+            }
+            stats.terms.push_back({std::string(fuzzy_word.data) + '~' + std::to_string(fuzzy_word.max_distance),
+                                   is_minus, posting_length});
+        }
+    };
+    add_fuzzy_terms(query.plus_fuzzy_words, false, MAX_FUZZY_EXPANSION_COUNT);
+    add_fuzzy_terms(query.minus_fuzzy_words, true, word_to_document_freqs_.size());
+}
@@ -2,31 +2,67 @@
 
 #include <vector>
 #include <algorithm>
+#include <cmath>
 #include <set>
 #include <map>
+#include <memory_resource>
 #include <execution>
+#include <functional>
+#include <limits>
 #include <mutex>
+#include <numeric>
 #include "document.h"
 #include "string_processing.h"
-#include "log_duration.h"
-#include "concurrent_map.h"
+#include "profiler.h"
+#include "corpus_statistics.h"
+#include "document_columns.h"
+#include "document_filter.h"
+#include "document_set.h"
+#include "memory_usage.h"
+#include "term_dictionary.h"
+#include "word_frequencies_view.h"
+#include "query_budget.h"
+#include "query_stats.h"
+#include "score_accumulator.h"
+#include "thread_pool.h"
 
 
 const double ACCURACY_COMPARISON = 1e-6;
 const size_t MAX_RESULT_DOCUMENT_COUNT = 5;
-const size_t BUCKET_COUNT = 12;
+//Сколько слов индекса (в лексикографическом порядке) подставляется вместо плюс-слова "префикс*".
+//Минус-слова с префиксом раскрываются полностью, чтобы не пропустить исключаемые документы
+const size_t MAX_PREFIX_EXPANSION_COUNT = 64;
+//Наибольшее число правок в слове запроса вида "слово~N"
+const int MAX_FUZZY_DISTANCE = 2;
+//Сколько ближайших слов индекса подставляется вместо плюс-слова "слово~N"; минус-слова раскрываются полностью
+const size_t MAX_FUZZY_EXPANSION_COUNT = 64;
+//Множитель релеванции найденного слова за каждую правку по умолчанию
+const double DEFAULT_FUZZY_PENALTY = 0.5;
+//Число отрезков порядковых номеров документов, которые параллельный поиск оценивает независимо
+const size_t SCORE_BLOCK_COUNT = 64;
+//Планировщик выбирает обход по документам, если сумма длин постингов плюс-слов, умноженная на их число,
+//во столько раз меньше числа документов: тогда накопитель на все документы обходится дороже слияния постингов
+const size_t DOCUMENT_AT_A_TIME_RATIO = 4;
+//Планировщик выбирает MaxScore, если самый длинный постинг плюс-слова во столько раз длиннее остальных вместе
+const size_t MAX_SCORE_MIN_SKEW = 4;
 
 class SearchServer
 {
 public:
-    explicit SearchServer();
+    //resource используется всеми контейнерами индекса, например std::pmr::monotonic_buffer_resource
+    //для индекса, который строится один раз. Ресурс должен пережить сервер
+    explicit SearchServer(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     
-    explicit SearchServer(const std::string& stop_words_text);
+    explicit SearchServer(const std::string& stop_words_text,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     
-    explicit SearchServer(const std::string_view& stop_words_text);
+    explicit SearchServer(const std::string_view& stop_words_text,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     
     template<typename StringContainer>
-    SearchServer(const StringContainer& stop_words) : stop_words_(MakeUniqueNonEmptyStrings(stop_words))
+    SearchServer(const StringContainer& stop_words,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource()) : stop_words_(
+            MakeUniqueNonEmptyStrings(stop_words)), resource_(resource)
     {
         if (!all_of(stop_words_.begin(), stop_words_.end(), IsValidWord)) {
             throw std::invalid_argument("Stop-word contains invalid characters.");
@@ -36,25 +72,52 @@ public:
     void AddDocument(int document_id, const std::string_view& document, DocumentStatus status,
             const std::vector<int>& ratings);
     
+    //Пакетное добавление: слова документов выделяются и проверяются с политикой policy, затем документы
+    //по очереди добавляются в индекс. Если хотя бы один документ некорректен, бросается std::invalid_argument
+    //и сервер не меняется
+    template<typename ExecutionPolicy>
+    void AddDocuments(ExecutionPolicy&& policy, const std::vector<DocumentRecord>& documents)
+    {
+        std::vector<int> batch_ids;
+        batch_ids.reserve(documents.size());
+        for (const DocumentRecord& document : documents) {
+            if (document.id < 0) { throw std::invalid_argument("Document ID cannot be less than zero"); }
+            if (documents_.Contains(document.id)) { throw std::invalid_argument("Document ID cannot be repeated"); }
+            batch_ids.push_back(document.id);
+        }
+        std::sort(batch_ids.begin(), batch_ids.end());
+        if (std::adjacent_find(batch_ids.begin(), batch_ids.end()) != batch_ids.end()) {
+            throw std::invalid_argument("Document ID cannot be repeated");
+        }
+        std::vector<std::vector<std::string_view>> document_words(documents.size());
+        std::transform(policy, documents.begin(), documents.end(), document_words.begin(),
+                [this](const DocumentRecord& document) {
+                    return SplitIntoWordsNoStop(document.text);
+                });
+        const bool is_valid = std::all_of(policy, document_words.begin(), document_words.end(),
+                [](const std::vector<std::string_view>& words) {
+                    return std::all_of(words.begin(), words.end(), IsValidWord);
+                });
+        if (!is_valid) { throw std::invalid_argument("Word in document contains invalid characters."); }
+        for (size_t i = 0; i < documents.size(); ++i) {
+            InsertDocument(documents[i].id, document_words[i], documents[i].status, documents[i].ratings);
+        }
+    }
+    
+    void AddDocuments(const std::vector<DocumentRecord>& documents);
+    
     //Параллельное выполнение, строка, предикат
     template<typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(std::execution::parallel_policy, const std::string_view& raw_query,
             DocumentPredicate document_predicate) const
     {
-        //LOG_DURATION;
+        PROFILE_STAGE(ProfileStage::FIND_TOP_DOCUMENTS);
         
         auto query = ParseQuery(raw_query);
         auto matched_documents = FindAllDocuments(std::execution::par, query, document_predicate);
         
-        std::sort(std::execution::par, matched_documents.begin(), matched_documents.end(),
-                [](const Document& lhs, const Document& rhs) {
-                    if (std::abs(lhs.relevance - rhs.relevance) < ACCURACY_COMPARISON) {
-                        return lhs.rating > rhs.rating;
-                    }
-                    else {
-                        return lhs.relevance > rhs.relevance;
-                    }
-                });
+        PROFILE_STAGE(ProfileStage::TOP_K);
+        std::sort(std::execution::par, matched_documents.begin(), matched_documents.end(), CompareByRelevance);
         if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
             matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
         }
@@ -66,26 +129,93 @@ public:
     std::vector<Document> FindTopDocuments(std::execution::sequenced_policy, const std::string_view& raw_query,
             DocumentPredicate document_predicate) const
     {
-        //LOG_DURATION;
-        auto query = ParseQuery(raw_query);
-        auto matched_documents = FindAllDocuments(query, document_predicate);
-        //LOG_DURATION("FindTopDocuments under FindAll- seq");
-        
-        std::sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-            //Добавил глобальную константу
-            if (std::abs(lhs.relevance - rhs.relevance) < ACCURACY_COMPARISON) {
-                return lhs.rating > rhs.rating;
-            }
-            else {
-                return lhs.relevance > rhs.relevance;
-            }
+        bool is_partial = false;
+        return FindTopDocumentsImpl(raw_query, document_predicate, SearchControl{QueryBudget(), is_partial});
+    }
+    
+    //Последовательное выполнение, строка, предикат, бюджет
+    template<typename DocumentPredicate>
+    TopDocumentsResult FindTopDocuments(std::execution::sequenced_policy, const std::string_view& raw_query,
+            DocumentPredicate document_predicate, const QueryBudget& budget) const
+    {
+        TopDocumentsResult result;
+        result.documents = FindTopDocumentsImpl(raw_query, document_predicate, SearchControl{budget, result.is_partial});
+        return result;
+    }
+    
+    //Последовательное выполнение, строка, предикат, статистика запроса
+    template<typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy, const std::string_view& raw_query,
+            DocumentPredicate document_predicate, QueryStats& stats) const
+    {
+        stats = QueryStats();
+        return FindTopDocumentsImpl(raw_query, document_predicate, SearchControl{QueryBudget(), stats.is_partial, &stats});
+    }
+    
+    //Последовательное выполнение, строка, предикат, статистика корпуса.
+    //IDF считается по переданной статистике, а не по документам этого сервера (поиск по шардам)
+    template<typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy, const std::string_view& raw_query,
+            DocumentPredicate document_predicate, const CorpusStatistics& corpus) const
+    {
+        bool is_partial = false;
+        return FindTopDocumentsImpl(raw_query, document_predicate,
+                SearchControl{QueryBudget(), is_partial, nullptr, &corpus});
+    }
+    
+    //Последовательное выполнение, строка, статус, статистика запроса
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy, const std::string_view& raw_query,
+            DocumentStatus status, QueryStats& stats) const;
+    
+    //Последовательное выполнение, строка, предикат, курсор. Возвращает не больше page_size документов,
+    //идущих за курсором; курсор следующей страницы - SearchCursor::After(последний документ).
+    //Документы до курсора отбрасываются до выбора лучших, поэтому глубокая страница стоит столько же,
+    //сколько первая. При page_size == 0 бросает std::invalid_argument
+    template<typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy, const std::string_view& raw_query,
+            DocumentPredicate document_predicate, const SearchCursor& cursor, size_t page_size) const
+    {
+        if (page_size == 0) { throw std::invalid_argument("Page size must be greater than zero."); }
+        bool is_partial = false;
+        return FindTopDocumentsImpl(raw_query, document_predicate,
+                SearchControl{QueryBudget(), is_partial, nullptr, nullptr, &cursor, page_size});
+    }
+    
+    //Последовательное выполнение, строка, статус, курсор
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy, const std::string_view& raw_query,
+            DocumentStatus status, const SearchCursor& cursor, size_t page_size) const;
+    
+    //Последовательное выполнение, строка, фильтр. Фильтр вычисляется один раз в карту документов,
+    //при оценке проверяется бит карты вместо вызова предиката
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy, const std::string_view& raw_query,
+            const DocumentFilter& filter) const;
+    
+    //Параллельное выполнение, строка, фильтр
+    std::vector<Document> FindTopDocuments(std::execution::parallel_policy, const std::string_view& raw_query,
+            const DocumentFilter& filter) const;
+    
+    //Неявное последовательное выполнение, строка, фильтр
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query, const DocumentFilter& filter) const;
+    
+    //Асинхронное выполнение в общем пуле потоков, строка, предикат, бюджет.
+    //Сервер должен существовать, пока результат не получен из future
+    template<typename DocumentPredicate>
+    std::future<TopDocumentsResult> FindTopDocumentsAsync(const std::string_view& raw_query,
+            DocumentPredicate document_predicate, const QueryBudget& budget = {}) const
+    {
+        return ThreadPool::Shared().Submit([this, query = std::string(raw_query), document_predicate, budget]() {
+            return FindTopDocuments(std::execution::seq, query, document_predicate, budget);
         });
-        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-        }
-        return matched_documents;
     }
     
+    //Асинхронное выполнение, строка, статус, бюджет
+    std::future<TopDocumentsResult> FindTopDocumentsAsync(const std::string_view& raw_query, DocumentStatus status,
+            const QueryBudget& budget = {}) const;
+    
+    //Асинхронное выполнение, строка, бюджет
+    std::future<TopDocumentsResult> FindTopDocumentsAsync(const std::string_view& raw_query,
+            const QueryBudget& budget = {}) const;
+    
     //Неявное последовательное выполнение, строка, предикат
     template<typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(const std::string_view& raw_query,
@@ -123,28 +253,144 @@ public:
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view& raw_query,
             int document_id) const;
     
+    //Последовательное выполнение, статистика запроса
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view& raw_query,
+            int document_id, QueryStats& stats) const;
+    
+    //results[i] - то же, что MatchDocument(raw_query, document_ids[i]). Запрос разбирается, а слова по префиксам
+    //и с правками находятся один раз на все документы; документы проверяются независимо по множествам документов
+    //слов. results переиспользует память векторов слов прошлых вызовов.
+    //Для несуществующего документа бросает std::out_of_range
+    template<typename ExecutionPolicy>
+    void MatchDocuments(ExecutionPolicy&& policy, const std::string_view& raw_query,
+            const std::vector<int>& document_ids,
+            std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>>& results) const
+    {
+        PROFILE_STAGE(ProfileStage::MATCH_DOCUMENT);
+        const MatchTerms terms = ResolveMatchTerms(ParseQuery(raw_query));
+        //Порядковые номера находятся до параллельной части: исключение в ней завершило бы программу
+        std::vector<int> ordinals(document_ids.size());
+        std::transform(document_ids.begin(), document_ids.end(), ordinals.begin(), [this](int document_id) {
+            return documents_.GetOrdinal(document_id);
+        });
+        results.resize(document_ids.size());
+        std::vector<size_t> indexes(document_ids.size());
+        std::iota(indexes.begin(), indexes.end(), 0);
+        std::for_each(policy, indexes.begin(), indexes.end(), [&](size_t index) {
+            const int ordinal = ordinals[index];
+            auto& [words, status] = results[index];
+            words.clear();
+            status = documents_.GetStatus(ordinal);
+            if (std::any_of(terms.minus_documents.begin(), terms.minus_documents.end(),
+                    [ordinal](const DocumentSet* documents) { return documents->Contains(ordinal); })
+                    || !ContainsAll(terms.required_documents, ordinal)) {
+                return;
+            }
+            for (const auto& [term, documents] : terms.plus_terms) {
+                if (documents->Contains(ordinal)) { words.push_back(term); }
+            }
+        });
+    }
+    
+    //Неявное последовательное выполнение
+    void MatchDocuments(const std::string_view& raw_query, const std::vector<int>& document_ids,
+            std::vector<std::tuple<std::vector<std::string_view>, DocumentStatus>>& results) const;
+    
     int GetDocumentCount() const;
     
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    //Релевантность слова, найденного по "слово~N" на расстоянии d, умножается на penalty^d.
+    //penalty должен быть в (0, 1], иначе бросается std::invalid_argument
+    void SetFuzzyPenalty(double penalty);
+    
+    double GetFuzzyPenalty() const;
+    
+    //Число документов сервера и число документов с каждым плюс-словом запроса. Слова по префиксу и с правками
+    //раскрываются по словам этого сервера с обычным лимитом, поэтому при достижении лимита сумма статистик шардов
+    //может отличаться от статистики одного сервера
+    CorpusStatistics GetCorpusStatistics(const std::string_view& raw_query) const;
+    
+    //Бросает std::invalid_argument, если запрос некорректен. Индекс не читается
+    void CheckQuery(const std::string_view& raw_query) const;
+    
+    //Порядок выдачи: по убыванию релевантности, затем рейтинга, затем по возрастанию id
+    static bool CompareByRelevance(const Document& lhs, const Document& rhs);
+    
+    //Частоты слов документа в лексикографическом порядке слов. При SEARCH_SERVER_DISABLE_FORWARD_INDEX
+    //прямой индекс не строится, и слова документа ищутся по множествам документов всех слов индекса
+    WordFrequenciesView GetWordFrequencies(int document_id) const;
+    
+    //Оценка памяти, занимаемой структурами индекса
+    MemoryUsage GetMemoryUsage() const;
+    
+    std::pmr::memory_resource* GetMemoryResource() const;
     
     void RemoveDocument(int document_id);
     
+    //Последний по порядковому номеру документ занимает номер удалённого, его записи в постингах перенумеровываются.
+    //Параллельно только удаляются и переносятся узлы постингов: удаление может одновременно освобождать память
+    //в resource_, что допускают monotonic_buffer_resource и synchronized_pool_resource, но не
+    //unsynchronized_pool_resource. Множества документов слов выделяют память при вставке, поэтому меняются
+    //после параллельной части в одном потоке
     template<typename ExecutionPolicy>
     void RemoveDocument(ExecutionPolicy&& policy, int document_id)
     {
-        std::map<std::string_view, double>& words_freqs_to_erase = document_to_word_freqs_[document_id];
-        std::vector<std::string> words(words_freqs_to_erase.size());
-        std::transform(policy, words_freqs_to_erase.begin(), words_freqs_to_erase.end(), words.begin(),
-                [](const auto& el) { return el.first; });
-    
-        std::for_each(policy, words.begin(), words.end(), [&](auto& word) {
-            word_to_document_freqs_[word].erase(document_id);
+        const int ordinal = documents_.FindOrdinal(document_id);
+        if (ordinal < 0) { return; }
+        const int last_ordinal = static_cast<int>(documents_.size()) - 1;
+        auto move_last_posting = [ordinal, last_ordinal](std::pmr::map<int, double>& postings) {
+            auto node = postings.extract(last_ordinal);
+            if (node.empty()) { return; }
+            node.key() = ordinal;
+            postings.insert(std::move(node));
+        };
+        auto move_last_document = [this, ordinal, last_ordinal](int term_id) {
+            DocumentSet& documents = term_documents_[term_id];
+            if (!documents.Contains(last_ordinal)) { return; }
+            documents.Erase(last_ordinal);
+            documents.Insert(ordinal);
+        };
+#ifdef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+        //Без прямого индекса слова документа неизвестны, поэтому просматриваются все постинги
+        std::for_each(policy, word_to_document_freqs_.begin(), word_to_document_freqs_.end(), [&](auto& word_freqs) {
+            word_freqs.second.erase(ordinal);
+            if (last_ordinal != ordinal) { move_last_posting(word_freqs.second); }
+        });
+        for (int term_id = 0; term_id < static_cast<int>(term_documents_.size()); ++term_id) {
+            term_documents_[term_id].Erase(ordinal);
+            if (last_ordinal != ordinal) { move_last_document(term_id); }
+        }
+#else
+        const std::pmr::vector<int>& term_ids = document_term_ids_[ordinal];
+        std::for_each(policy, term_ids.begin(), term_ids.end(), [&](int term_id) {
+            word_to_document_freqs_.find(words_[term_id])->second.erase(ordinal);
         });
-        document_to_word_freqs_.erase(document_id);
-        documents_.erase(document_id);
+        for (const int term_id : term_ids) {
+            term_documents_[term_id].Erase(ordinal);
+        }
+        if (last_ordinal != ordinal) {
+            const std::pmr::vector<int>& last_term_ids = document_term_ids_[last_ordinal];
+            std::for_each(policy, last_term_ids.begin(), last_term_ids.end(), [&](int term_id) {
+                move_last_posting(word_to_document_freqs_.find(words_[term_id])->second);
+            });
+            for (const int term_id : last_term_ids) {
+                move_last_document(term_id);
+            }
+            document_term_ids_[ordinal] = std::move(document_term_ids_[last_ordinal]);
+            document_word_freqs_[ordinal] = std::move(document_word_freqs_[last_ordinal]);
+        }
+        document_term_ids_.pop_back();
+        document_word_freqs_.pop_back();
+#endif
+        documents_.Erase(document_id);
         order_documents_id_.erase(document_id);
     }
     
+    //Перенумеровывает документы так, чтобы документы с общими словами шли подряд (ComputeLocalityOrder):
+    //разности номеров в постингах уменьшаются, записи одного постинга ближе друг к другу в столбцах документов.
+    //Id документов и результаты поиска не меняются. Вызывается при обслуживании индекса, например после загрузки
+    //корпуса, а не после каждого добавления
+    void ReorderDocuments();
+    
     auto begin()
     {
         return order_documents_id_.begin();
@@ -156,32 +402,88 @@ public:
     }
 
 private:
-    struct DocumentData
-    {
-        int rating;
-        DocumentStatus status;
-    };
     struct QueryWord
     {
         std::string_view data;
         bool is_minus;
         bool is_stop;
+        //Слово запроса вида "префикс*", data - префикс без звёздочки
+        bool is_prefix;
+        //Для слова запроса вида "слово~N" - N, data - слово без суффикса; иначе -1
+        int max_distance = -1;
+        //Слово запроса вида "+слово"
+        bool is_required = false;
+    };
+    //Слово запроса вида "слово~N"
+    struct FuzzyWord
+    {
+        std::string_view data;
+        int max_distance;
     };
     struct Query
     {
         std::vector<std::string_view> plus_words;
         std::vector<std::string_view> minus_words;
+        std::vector<std::string_view> plus_prefixes;
+        std::vector<std::string_view> minus_prefixes;
+        std::vector<FuzzyWord> plus_fuzzy_words;
+        std::vector<FuzzyWord> minus_fuzzy_words;
+        //Слова вида "+слово": документ должен содержать их все. Они же есть в plus_words и оцениваются как обычные
+        std::vector<std::string_view> required_words;
+    };
+    //Параметры последовательного поиска
+    struct SearchControl
+    {
+        const QueryBudget& budget;
+        bool& is_partial;
+        QueryStats* stats = nullptr;
+        //Если задана, IDF считается по ней
+        const CorpusStatistics* corpus = nullptr;
+        //Если задан, выдаются только документы после него
+        const SearchCursor* cursor = nullptr;
+        size_t result_count = MAX_RESULT_DOCUMENT_COUNT;
+    };
+    //Порядок и способ вычисления запроса
+    struct QueryPlan
+    {
+        QueryStrategy strategy = QueryStrategy::TERM_AT_A_TIME;
+        bool is_minus_first = false;
+        //Плюс-слова с непустыми постингами по возрастанию числа документов, то есть по убыванию IDF
+        std::vector<std::string_view> plus_words;
+        //Множества документов обязательных слов от меньшего к большему
+        std::vector<const DocumentSet*> required_documents;
     };
     
     const std::set<std::string, std::less<>> stop_words_;
     
-    std::set<std::string, std::less<>> words_;
+    //Объявлен до контейнеров индекса, чтобы их инициализаторы могли его использовать
+    std::pmr::memory_resource* const resource_;
+    
+    //Слова документов и их id; ключи остальных структур указывают в него
+    TermDictionary words_{resource_};
     
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
-    std::map<int, DocumentData> documents_;
+    //Постинги: порядковые номера документов в documents_ и частоты слова. Номера плотные, и документам,
+    //которые похожи по словам, ReorderDocuments даёт соседние номера
+    std::pmr::map<std::string_view, std::pmr::map<int, double>> word_to_document_freqs_{resource_};
+#ifndef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+    //Прямой индекс по порядковому номеру документа: отсортированные id слов документа
+    std::pmr::vector<std::pmr::vector<int>> document_term_ids_{resource_};
+    //Частоты слов по порядковому номеру документа: id слов с частотами, упорядоченные по словам,
+    //чтобы GetWordFrequencies только оборачивал их
+    std::pmr::vector<std::pmr::vector<WordFrequenciesView::Entry>> document_word_freqs_{resource_};
+#endif
+    //Наибольшая частота слова в документе по id слова. При удалении документов не уменьшается
+    //и остаётся верхней оценкой для MaxScore
+    std::pmr::vector<double> max_term_freqs_{resource_};
+    //Порядковые номера документов слова по id слова: те же номера, что в его постинге, но без частот.
+    //Проверка принадлежности и исключение по минус-словам не обходят дерево постинга
+    std::pmr::vector<DocumentSet> term_documents_{resource_};
+    //Рейтинги и статусы документов: чтение в циклах оценки - обращение к массиву, а не поиск в дереве
+    DocumentColumns documents_{resource_};
     //Изменил тип контейнера
-    std::set<int> order_documents_id_;
+    std::pmr::set<int> order_documents_id_{resource_};
+    
+    double fuzzy_penalty_ = DEFAULT_FUZZY_PENALTY;
     
     static bool IsValidWord(const std::string_view& word);
     
@@ -191,6 +493,54 @@ private:
     
     static int ComputeAverageRating(const std::vector<int>& ratings);
     
+    //Добавляет документ, id и слова которого уже проверены
+    void InsertDocument(int document_id, const std::vector<std::string_view>& words, DocumentStatus status,
+            const std::vector<int>& ratings);
+    
+    //-1, если слова нет в индексе
+    int FindTermId(const std::string_view& word) const;
+    
+    //Слова words, которые есть в документе, в лексикографическом порядке. С прямым индексом возрастающие id слов
+    //пересекаются с id слов документа (IntersectSorted), без него проверяются множества документов слов.
+    //Для несуществующего документа бросает std::out_of_range
+    std::vector<std::string_view> FindDocumentTerms(int document_id, const std::vector<std::string_view>& words) const;
+    
+    //Есть ли в документе хоть одно из слов words
+    bool DocumentContainsAnyTerm(int document_id, const std::vector<std::string_view>& words) const;
+    
+    //Id слов индекса из words по возрастанию; слов не из индекса нет
+    std::vector<int> FindSortedTermIds(const std::vector<std::string_view>& words) const;
+    
+    //Есть ли документ во всех множествах; для пустого списка - true
+    static bool ContainsAll(const std::vector<const DocumentSet*>& documents, int ordinal);
+    
+    //Множества документов минус-слов запроса, в том числе найденных по префиксу и с правками
+    std::vector<const DocumentSet*> CollectMinusDocuments(const Query& query) const;
+    
+    //Слова индекса с непустыми постингами, начинающиеся с prefix, в лексикографическом порядке.
+    //Диапазон находится в упорядоченном word_to_document_freqs_ за O(log n) без просмотра всех слов
+    std::vector<std::string_view> ExpandPrefix(std::string_view prefix, size_t max_count) const;
+    
+    //Постинги слов с префиксом, слитые в один виртуальный постинг: документы по возрастанию номера,
+    //частоты слов одного документа складываются
+    std::vector<std::pair<int, double>> MergePrefixPostings(std::string_view prefix, size_t max_count) const;
+    
+    //Для несуществующего документа бросает std::out_of_range
+    std::vector<std::string_view> FindDocumentTermsWithPrefix(int document_id, std::string_view prefix) const;
+    
+    //Слова индекса с непустыми постингами на расстоянии Левенштейна не больше max_distance от word
+    //и их расстояния; ближайшие первыми, при равенстве - в лексикографическом порядке.
+    //Автомат Левенштейна (строки динамики по префиксам слова индекса) проходит упорядоченный словарь
+    //как бор: строки общего префикса соседних слов не пересчитываются, а префикс, после которого
+    //расстояние уже не может стать допустимым, пропускается вместе со всеми словами за O(log n)
+    std::vector<std::pair<std::string_view, int>> ExpandFuzzy(std::string_view word, int max_distance,
+            size_t max_count) const;
+    
+    //Для несуществующего документа бросает std::out_of_range
+    std::vector<std::string_view> FindDocumentTermsWithinDistance(int document_id, const FuzzyWord& fuzzy_word) const;
+    
+    //"слово*" - префикс, "слово~" и "слово~N" - нечёткое слово с N правками (N не больше MAX_FUZZY_DISTANCE,
+    //иначе std::invalid_argument). Одиночные "*" и "~", а также слова, которые начинаются с "~", - обычные слова
     QueryWord ParseQueryWord(std::string_view text_view) const;
     
     Query ParseQuery(const std::string_view& text) const;
@@ -199,58 +549,172 @@ private:
     
     double ComputeWordInverseDocumentFreq(const std::string_view& word) const;
     
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchQuery(const Query& query, int document_id) const;
+    
+    //Слова запроса с их множествами документов для MatchDocuments
+    struct MatchTerms
+    {
+        //Плюс-слова, слова по префиксам и с правками без повторов в лексикографическом порядке
+        std::vector<std::pair<std::string_view, const DocumentSet*>> plus_terms;
+        std::vector<const DocumentSet*> minus_documents;
+        //Пустое множество для обязательного слова не из индекса
+        std::vector<const DocumentSet*> required_documents;
+    };
+    
+    MatchTerms ResolveMatchTerms(const Query& query) const;
+    
+    template<typename DocumentPredicate>
+    bool IsAccepted(const DocumentPredicate& document_predicate, int document_id, int ordinal) const
+    {
+        return document_predicate(document_id, documents_.GetStatus(ordinal), documents_.GetRating(ordinal));
+    }
+    
+    //Карта, вычисленная по DocumentFilter, передаётся по ссылке, чтобы не копировать её в шаблоны поиска
+    bool IsAccepted(std::reference_wrapper<const CandidateBitmap> candidates, [[maybe_unused]] int document_id,
+            int ordinal) const
+    {
+        return candidates.get().Test(ordinal);
+    }
+    
+    void FillTermStats(const Query& query, QueryStats& stats) const;
+    
+    //Плюс-слова упорядочиваются по числу документов (по статистике корпуса, если она задана), чтобы частичный
+    //результат при исчерпании бюджета учитывал самые редкие слова. Минус-слово, которое есть во всех документах,
+    //даёт пустой результат; минус-слово, которое есть хотя бы в половине документов, применяется до оценки.
+    //Для запросов из одних слов без префиксов и правок выбирается обход по документам или MaxScore.
+    //control == nullptr - параллельный поиск, который всегда обходит слова
+    QueryPlan PlanQuery(const Query& query, const SearchControl* control) const;
+    
+    //Счётчики просмотра постингов; пропущенные записи считаются по длинам постингов плюс-слов в stats.terms
+    static void FillScanStats(QueryStats& stats, size_t postings_scanned, size_t rejected_by_predicate,
+            size_t removed_by_minus_words, size_t removed_by_required_words, size_t candidate_count);
+    
+    //Первая запись постинга с порядковым номером не меньше ordinal
+    static std::pmr::map<int, double>::const_iterator FindPostingFrom(const std::pmr::map<int, double>& postings,
+            int ordinal);
+    
+    static std::vector<std::pair<int, double>>::const_iterator FindPostingFrom(
+            const std::vector<std::pair<int, double>>& postings, int ordinal);
+    
+    template<typename DocumentPredicate>
+    std::vector<Document> FindTopDocumentsImpl(const std::string_view& raw_query, DocumentPredicate document_predicate,
+            const SearchControl& control) const
+    {
+        QueryStats* const stats = control.stats;
+        PROFILE_STAGE(ProfileStage::FIND_TOP_DOCUMENTS);
+        QueryStageTimer total_timer(stats, ProfileStage::FIND_TOP_DOCUMENTS);
+        const auto query = [&]() {
+            QueryStageTimer parse_timer(stats, ProfileStage::PARSE);
+            return ParseQuery(raw_query);
+        }();
+        if (stats) { FillTermStats(query, *stats); }
+        //Запрос мог простоять в очереди дольше своего бюджета
+        control.is_partial = control.budget.IsExhausted();
+        auto matched_documents = FindAllDocuments(std::execution::seq, query, document_predicate, control);
+        
+        PROFILE_STAGE(ProfileStage::TOP_K);
+        QueryStageTimer top_k_timer(stats, ProfileStage::TOP_K);
+        if (control.cursor && !control.cursor->IsAtStart()) {
+            //Документы до курсора и он сам выданы на предыдущих страницах
+            const Document& last_document = control.cursor->GetLastDocument();
+            matched_documents.erase(std::remove_if(matched_documents.begin(), matched_documents.end(),
+                    [&last_document](const Document& document) {
+                        return !CompareByRelevance(last_document, document);
+                    }), matched_documents.end());
+        }
+        const size_t result_count = std::min(control.result_count, matched_documents.size());
+        std::partial_sort(matched_documents.begin(), matched_documents.begin() + result_count, matched_documents.end(),
+                CompareByRelevance);
+        matched_documents.resize(result_count);
+        if (stats) { stats->result_count = matched_documents.size(); }
+        return matched_documents;
+    }
+    
     
+    //Номера документов делятся на отрезки, которые оцениваются параллельно, каждый своим накопителем.
+    //В отрезке слова обходятся в том же порядке, что и при последовательном поиске, поэтому релевантность
+    //совпадает с последовательной до бита при любом числе потоков
     template<typename DocumentPredicate>
     std::vector<Document> FindAllDocuments(std::execution::parallel_policy, const SearchServer::Query& query,
             DocumentPredicate document_predicate) const
     {
-        ConcurrentMap<int, double> concurrent_document_to_relevance(BUCKET_COUNT * 3);
+        using Postings = std::pmr::map<int, double>;
+        const QueryPlan plan = PlanQuery(query, nullptr);
+        if (plan.strategy == QueryStrategy::EMPTY_RESULT) { return {}; }
+        //Постинги плюс-слов с весами в порядке последовательного поиска: слова, слова с префиксом, слова с правками
+        std::vector<std::pair<const Postings*, double>> word_postings;
+        std::vector<std::pair<std::vector<std::pair<int, double>>, double>> prefix_postings;
+        std::vector<std::pair<const Postings*, double>> fuzzy_postings;
+        for (const std::string_view& word_view : plan.plus_words) {
+            word_postings.emplace_back(&word_to_document_freqs_.at(word_view),
+                    ComputeWordInverseDocumentFreq(word_view));
+        }
+        for (const std::string_view& prefix : query.plus_prefixes) {
+            std::vector<std::pair<int, double>> postings = MergePrefixPostings(prefix, MAX_PREFIX_EXPANSION_COUNT);
+            if (postings.empty()) { continue; }
+            const double inverse_document_freq = std::log(GetDocumentCount() * 1.0 / postings.size());
+            prefix_postings.emplace_back(std::move(postings), inverse_document_freq);
+        }
+        for (const FuzzyWord& fuzzy_word : query.plus_fuzzy_words) {
+            for (const auto& [term, distance] : ExpandFuzzy(fuzzy_word.data, fuzzy_word.max_distance,
+                    MAX_FUZZY_EXPANSION_COUNT)) {
+                fuzzy_postings.emplace_back(&word_to_document_freqs_.at(term),
+                        ComputeWordInverseDocumentFreq(term) * std::pow(fuzzy_penalty_, distance));
+            }
+        }
+        const std::vector<const DocumentSet*> minus_documents = CollectMinusDocuments(query);
         
-        auto add_doc_to_rel = [&](const std::string_view& word_view) {
-            if (!word_to_document_freqs_.count(word_view)) { return; }
-            const std::map<int, double>& doc_id_freqs = word_to_document_freqs_.at(word_view);
-            
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word_view);
-            std::for_each(doc_id_freqs.begin(), doc_id_freqs.end(), [&](const std::pair<int, double>& doc) {
-                const auto& [document_id, term_freq] = doc;
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    concurrent_document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
+        const size_t document_count = documents_.size();
+        const size_t block_count = std::max<size_t>(1, std::min(SCORE_BLOCK_COUNT, document_count));
+        std::vector<ScoreAccumulator> blocks;
+        blocks.reserve(block_count);
+        for (size_t block = 0; block < block_count; ++block) {
+            const size_t first_ordinal = document_count * block / block_count;
+            blocks.emplace_back(static_cast<int>(first_ordinal), document_count * (block + 1) / block_count - first_ordinal);
+        }
+        auto apply_minus_words = [&]() {
+            PROFILE_STAGE(ProfileStage::MINUS_WORDS);
+            std::for_each(std::execution::par, blocks.begin(), blocks.end(), [&](ScoreAccumulator& block) {
+                for (const DocumentSet* documents : minus_documents) {
+                    documents->ForEachInRange(block.GetFirstOrdinal(), block.GetEndOrdinal(), [&block](int ordinal) {
+                        block.Exclude(ordinal);
+                    });
                 }
             });
         };
-        
-        auto erase_doc = [&](const std::string_view& word_view) {
-            if (word_to_document_freqs_.count(word_view) == 0) {
-                return;
-            }
-            const std::map<int, double>& document_freqs_ref = word_to_document_freqs_.at(word_view);
-            const std::vector<std::pair<int, double>> doc_id_freqs(document_freqs_ref.begin(),
-                    document_freqs_ref.end());
-            
-            std::for_each(std::execution::par, doc_id_freqs.begin(), doc_id_freqs.end(),
-                    [&](const std::pair<int, double>& doc) {
-                        const auto& [document_id, term_freq] = doc;
-                        concurrent_document_to_relevance[document_id].ref_to_map.erase(document_id);
-                    });
-        };
-        
-        std::vector<std::future<void>> lock;
-        for (const std::string_view& word_view : query.plus_words) {
-            lock.push_back(std::async(add_doc_to_rel, word_view));
-            if (lock.size() == BUCKET_COUNT) { lock.clear(); }
-        }
-        lock.clear();
-        
-        for (const std::string_view& word_view : query.minus_words) {
-            lock.push_back(std::async(erase_doc, word_view));
-            if (lock.size() == BUCKET_COUNT) { lock.clear(); }
+        if (plan.is_minus_first) { apply_minus_words(); }
+        {
+            PROFILE_STAGE(ProfileStage::SCORE);
+            std::for_each(std::execution::par, blocks.begin(), blocks.end(), [&](ScoreAccumulator& block) {
+                auto score_postings = [&](const auto& postings, double weight) {
+                    for (auto it = FindPostingFrom(postings, block.GetFirstOrdinal());
+                            it != postings.end() && it->first < block.GetEndOrdinal(); ++it) {
+                        const auto& [ordinal, term_freq] = *it;
+                        if (block.IsExcluded(ordinal) || (ContainsAll(plan.required_documents, ordinal)
+                                && IsAccepted(document_predicate, documents_.GetId(ordinal), ordinal))) {
+                            block.Add(ordinal, term_freq * weight);
+                        }
+                    }
+                };
+                for (const auto& [postings, weight] : word_postings) {
+                    score_postings(*postings, weight);
+                }
+                for (const auto& [postings, weight] : prefix_postings) {
+                    score_postings(postings, weight);
+                }
+                for (const auto& [postings, weight] : fuzzy_postings) {
+                    score_postings(*postings, weight);
+                }
+            });
         }
-        lock.clear();
+        if (!plan.is_minus_first) { apply_minus_words(); }
         
+        PROFILE_STAGE(ProfileStage::COLLECT);
         std::vector<Document> matched_documents;
-        for (const auto &[document_id, relevance] : concurrent_document_to_relevance.BuildOrdinaryMap()) {
-            matched_documents.emplace_back(document_id, relevance, documents_.at(document_id).rating);
+        for (const ScoreAccumulator& block : blocks) {
+            block.ForEachScored([&](int ordinal, double relevance) {
+                matched_documents.emplace_back(documents_.GetId(ordinal), relevance, documents_.GetRating(ordinal));
+            });
         }
         return matched_documents;
     }
@@ -259,34 +723,294 @@ private:
     std::vector<Document> FindAllDocuments(std::execution::sequenced_policy, const SearchServer::Query& query,
             DocumentPredicate document_predicate) const
     {
-        //LOG_DURATION("FindAllDocuments - seq");
+        bool is_partial = false;
+        return FindAllDocuments(std::execution::seq, query, document_predicate, SearchControl{QueryBudget(), is_partial});
+    }
+    
+    //Бюджет проверяется раз в POSTING_BLOCK_SIZE записей постинга. Минус-слова применяются всегда,
+    //чтобы частичный результат не содержал исключённых документов
+    template<typename DocumentPredicate>
+    std::vector<Document> FindAllDocuments(std::execution::sequenced_policy, const SearchServer::Query& query,
+            DocumentPredicate document_predicate, const SearchControl& control) const
+    {
+        const QueryBudget& budget = control.budget;
+        bool& is_partial = control.is_partial;
+        QueryStats* const stats = control.stats;
+        const QueryPlan plan = PlanQuery(query, &control);
+        if (stats) {
+            stats->strategy = plan.strategy;
+            stats->is_minus_first = plan.is_minus_first;
+        }
+        switch (plan.strategy) {
+            case QueryStrategy::EMPTY_RESULT:
+                if (stats) { FillScanStats(*stats, 0, 0, 0, 0, 0); }
+                return {};
+            case QueryStrategy::DOCUMENT_AT_A_TIME:
+            case QueryStrategy::MAX_SCORE:
+                return FindAllDocumentsByDocument(query, plan, document_predicate, control);
+            case QueryStrategy::INTERSECTION:
+                return FindAllDocumentsByIntersection(query, plan, document_predicate, control);
+            case QueryStrategy::TERM_AT_A_TIME:
+                break;
+        }
         
-        std::map<int, double> document_to_relevance;
-        for (const std::string_view& word_view : query.plus_words) {
-            if (word_to_document_freqs_.count(word_view) == 0) {
-                continue;
+        ScoreAccumulator accumulator(0, documents_.size());
+        size_t postings_scanned = 0;
+        size_t rejected_by_predicate = 0;
+        size_t removed_by_required_words = 0;
+        auto apply_minus_words = [&]() {
+            PROFILE_STAGE(ProfileStage::MINUS_WORDS);
+            QueryStageTimer minus_words_timer(stats, ProfileStage::MINUS_WORDS);
+            for (const DocumentSet* documents : CollectMinusDocuments(query)) {
+                documents->ForEach([&accumulator](int ordinal) { accumulator.Exclude(ordinal); });
             }
-            const double inverse_document_freq = ComputeWordInverseDocumentFreq(word_view);
-            for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word_view)) {
-                const auto& document_data = documents_.at(document_id);
-                if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
+        };
+        //Исключённые заранее документы не проверяются предикатом
+        if (plan.is_minus_first) { apply_minus_words(); }
+        {
+            PROFILE_STAGE(ProfileStage::SCORE);
+            QueryStageTimer score_timer(stats, ProfileStage::SCORE);
+            size_t postings_in_block = 0;
+            auto score_postings = [&](const auto& postings, double inverse_document_freq) {
+                for (const auto& [ordinal, term_freq] : postings) {
+                    if (++postings_in_block == POSTING_BLOCK_SIZE) {
+                        postings_in_block = 0;
+                        if (budget.IsExhausted()) {
+                            is_partial = true;
+                            return;
+                        }
+                    }
+                    ++postings_scanned;
+                    if (!accumulator.IsExcluded(ordinal)) {
+                        if (!ContainsAll(plan.required_documents, ordinal)) {
+                            ++removed_by_required_words;
+                            continue;
+                        }
+                        if (!IsAccepted(document_predicate, documents_.GetId(ordinal), ordinal)) {
+                            ++rejected_by_predicate;
+                            continue;
+                        }
+                    }
+                    accumulator.Add(ordinal, term_freq * inverse_document_freq);
                 }
+            };
+            for (const std::string_view& word_view : plan.plus_words) {
+                if (is_partial) { break; }
+                const double inverse_document_freq = control.corpus
+                        ? control.corpus->ComputeInverseDocumentFreq(word_view)
+                        : ComputeWordInverseDocumentFreq(word_view);
+                score_postings(word_to_document_freqs_.at(word_view), inverse_document_freq);
             }
+            //Слово с префиксом оценивается как одно слово с виртуальным постингом
+            for (const std::string_view& prefix : query.plus_prefixes) {
+                if (is_partial) { break; }
+                const std::vector<std::pair<int, double>> postings = MergePrefixPostings(prefix,
+                        MAX_PREFIX_EXPANSION_COUNT);
+                if (postings.empty()) { continue; }
+                const double inverse_document_freq = control.corpus
+                        ? control.corpus->ComputeInverseDocumentFreq(std::string(prefix) + '*')
+                        : std::log(GetDocumentCount() * 1.0 / postings.size());
+                score_postings(postings, inverse_document_freq);
+            }
+            //Каждое найденное слово оценивается как обычное, со штрафом за каждую правку
+            for (const FuzzyWord& fuzzy_word : query.plus_fuzzy_words) {
+                if (is_partial) { break; }
+                for (const auto& [term, distance] : ExpandFuzzy(fuzzy_word.data, fuzzy_word.max_distance,
+                        MAX_FUZZY_EXPANSION_COUNT)) {
+                    if (is_partial) { break; }
+                    const double inverse_document_freq = control.corpus
+                            ? control.corpus->ComputeInverseDocumentFreq(term)
+                            : ComputeWordInverseDocumentFreq(term);
+                    score_postings(word_to_document_freqs_.at(term),
+                            inverse_document_freq * std::pow(fuzzy_penalty_, distance));
+                }
+            }
+        }
+        if (!plan.is_minus_first) { apply_minus_words(); }
+        
+        PROFILE_STAGE(ProfileStage::COLLECT);
+        QueryStageTimer collect_timer(stats, ProfileStage::COLLECT);
+        std::vector<Document> matched_documents;
+        accumulator.ForEachScored([&](int ordinal, double relevance) {
+            matched_documents.push_back({documents_.GetId(ordinal), relevance, documents_.GetRating(ordinal)});
+        });
+        if (stats) {
+            FillScanStats(*stats, postings_scanned, rejected_by_predicate,
+                    accumulator.GetScoredCount() - matched_documents.size(), removed_by_required_words,
+                    matched_documents.size());
+        }
+        return matched_documents;
+    }
+    
+    //Пересечение: кандидаты - документы самого редкого обязательного слова, остальные обязательные слова проверяются
+    //по их множествам документов от меньшего к большему, поэтому время пропорционально числу документов самого
+    //редкого слова, а не самого частого. Вклады плюс-слов складываются в порядке плана, как при обходе по словам
+    template<typename DocumentPredicate>
+    std::vector<Document> FindAllDocumentsByIntersection(const SearchServer::Query& query, const QueryPlan& plan,
+            DocumentPredicate document_predicate, const SearchControl& control) const
+    {
+        using Postings = std::pmr::map<int, double>;
+        QueryStats* const stats = control.stats;
+        PROFILE_STAGE(ProfileStage::SCORE);
+        QueryStageTimer score_timer(stats, ProfileStage::SCORE);
+        std::vector<std::pair<const Postings*, double>> word_postings;
+        for (const std::string_view& word_view : plan.plus_words) {
+            const double weight = control.corpus ? control.corpus->ComputeInverseDocumentFreq(word_view)
+                                                 : ComputeWordInverseDocumentFreq(word_view);
+            word_postings.emplace_back(&word_to_document_freqs_.at(word_view), weight);
         }
+        const std::vector<const DocumentSet*> minus_documents = CollectMinusDocuments(query);
+        const std::vector<const DocumentSet*> other_required(plan.required_documents.begin() + 1,
+                plan.required_documents.end());
         
-        for (const std::string_view& word_view : query.minus_words) {
-            if (word_to_document_freqs_.count(word_view) == 0) {
-                continue;
+        std::vector<Document> matched_documents;
+        size_t postings_in_block = 0;
+        size_t postings_scanned = 0;
+        size_t rejected_by_predicate = 0;
+        size_t removed_by_minus_words = 0;
+        size_t removed_by_required_words = 0;
+        plan.required_documents.front()->ForEach([&](int ordinal) {
+            if (control.is_partial) { return; }
+            if (++postings_in_block == POSTING_BLOCK_SIZE) {
+                postings_in_block = 0;
+                if (control.budget.IsExhausted()) { control.is_partial = true; }
+            }
+            ++postings_scanned;
+            if (!ContainsAll(other_required, ordinal)) {
+                ++removed_by_required_words;
+                return;
+            }
+            if (std::any_of(minus_documents.begin(), minus_documents.end(),
+                    [ordinal](const DocumentSet* documents) { return documents->Contains(ordinal); })) {
+                ++removed_by_minus_words;
+                return;
+            }
+            if (!IsAccepted(document_predicate, documents_.GetId(ordinal), ordinal)) {
+                ++rejected_by_predicate;
+                return;
             }
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word_view)) {
-                document_to_relevance.erase(document_id);
+            double relevance = 0;
+            for (const auto& [postings, weight] : word_postings) {
+                const auto it = postings->find(ordinal);
+                if (it != postings->end()) { relevance += it->second * weight; }
             }
+            matched_documents.push_back({documents_.GetId(ordinal), relevance, documents_.GetRating(ordinal)});
+        });
+        if (stats) {
+            FillScanStats(*stats, postings_scanned, rejected_by_predicate, removed_by_minus_words,
+                    removed_by_required_words, matched_documents.size());
         }
+        return matched_documents;
+    }
+    
+    //Обход по документам: постинги слов плана идут одновременно по возрастанию номеров, и документ оценивается
+    //целиком, вклады слов складываются в порядке плана, как при обходе по словам. Для MAX_SCORE слова
+    //с наименьшими верхними оценками вклада, сумма которых меньше релевантности худшего из текущих
+    //control.result_count лучших документов, перестают порождать кандидатов и только дооценивают их
+    template<typename DocumentPredicate>
+    std::vector<Document> FindAllDocumentsByDocument(const SearchServer::Query& query, const QueryPlan& plan,
+            DocumentPredicate document_predicate, const SearchControl& control) const
+    {
+        using Postings = std::pmr::map<int, double>;
+        struct TermCursor
+        {
+            const Postings* postings;
+            Postings::const_iterator it;
+            double weight;
+            //Наибольший вклад слова в релевантность документа
+            double upper_bound;
+            bool is_essential;
+        };
+        QueryStats* const stats = control.stats;
+        PROFILE_STAGE(ProfileStage::SCORE);
+        QueryStageTimer score_timer(stats, ProfileStage::SCORE);
+        std::vector<TermCursor> cursors;
+        for (const std::string_view& word_view : plan.plus_words) {
+            const Postings& postings = word_to_document_freqs_.at(word_view);
+            const double weight = control.corpus ? control.corpus->ComputeInverseDocumentFreq(word_view)
+                                                 : ComputeWordInverseDocumentFreq(word_view);
+            cursors.push_back({&postings, postings.begin(), weight, max_term_freqs_[FindTermId(word_view)] * weight,
+                               true});
+        }
+        const std::vector<const DocumentSet*> minus_documents = CollectMinusDocuments(query);
+        //Номера слов по возрастанию верхней оценки: первые non_essential_count из них не порождают кандидатов
+        std::vector<size_t> by_bound(cursors.size());
+        std::iota(by_bound.begin(), by_bound.end(), 0);
+        std::stable_sort(by_bound.begin(), by_bound.end(), [&cursors](size_t lhs, size_t rhs) {
+            return cursors[lhs].upper_bound < cursors[rhs].upper_bound;
+        });
+        size_t non_essential_count = 0;
+        double non_essential_bound = 0;
+        //Куча с минимумом в начале: релевантности лучших документов
+        std::vector<double> top_relevances;
+        const bool is_pruning = plan.strategy == QueryStrategy::MAX_SCORE;
         
         std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance] : document_to_relevance) {
-            matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+        size_t postings_in_block = 0;
+        size_t postings_scanned = 0;
+        size_t rejected_by_predicate = 0;
+        size_t removed_by_minus_words = 0;
+        while (!control.is_partial) {
+            int candidate = std::numeric_limits<int>::max();
+            for (const TermCursor& cursor : cursors) {
+                if (cursor.is_essential && cursor.it != cursor.postings->end()) {
+                    candidate = std::min(candidate, cursor.it->first);
+                }
+            }
+            if (candidate == std::numeric_limits<int>::max()) { break; }
+            const bool is_excluded = std::any_of(minus_documents.begin(), minus_documents.end(),
+                    [candidate](const DocumentSet* documents) { return documents->Contains(candidate); });
+            const bool is_accepted = !is_excluded
+                    && IsAccepted(document_predicate, documents_.GetId(candidate), candidate);
+            if (is_excluded) { ++removed_by_minus_words; }
+            double relevance = 0;
+            for (TermCursor& cursor : cursors) {
+                if (!cursor.is_essential) {
+                    if (!is_accepted) { continue; }
+                    //Кандидаты идут по возрастанию номеров, поэтому курсор только продвигается
+                    if (cursor.it != cursor.postings->end() && cursor.it->first < candidate) {
+                        cursor.it = cursor.postings->lower_bound(candidate);
+                    }
+                }
+                if (cursor.it == cursor.postings->end() || cursor.it->first != candidate) { continue; }
+                if (++postings_in_block == POSTING_BLOCK_SIZE) {
+                    postings_in_block = 0;
+                    if (control.budget.IsExhausted()) { control.is_partial = true; }
+                }
+                ++postings_scanned;
+                if (is_accepted) {
+                    relevance += cursor.it->second * cursor.weight;
+                }
+                else if (!is_excluded) {
+                    ++rejected_by_predicate;
+                }
+                ++cursor.it;
+            }
+            if (!is_accepted) { continue; }
+            matched_documents.push_back({documents_.GetId(candidate), relevance, documents_.GetRating(candidate)});
+            if (!is_pruning) { continue; }
+            if (top_relevances.size() < control.result_count) {
+                top_relevances.push_back(relevance);
+                std::push_heap(top_relevances.begin(), top_relevances.end(), std::greater<>());
+            }
+            else if (relevance > top_relevances.front()) {
+                std::pop_heap(top_relevances.begin(), top_relevances.end(), std::greater<>());
+                top_relevances.back() = relevance;
+                std::push_heap(top_relevances.begin(), top_relevances.end(), std::greater<>());
+            }
+            if (top_relevances.size() < control.result_count) { continue; }
+            //Документ только из неосновных слов не превзойдёт худший из лучших даже с учётом погрешности сравнения
+            while (non_essential_count < by_bound.size()) {
+                TermCursor& cursor = cursors[by_bound[non_essential_count]];
+                if (non_essential_bound + cursor.upper_bound >= top_relevances.front() - ACCURACY_COMPARISON) { break; }
+                non_essential_bound += cursor.upper_bound;
+                cursor.is_essential = false;
+                ++non_essential_count;
+            }
+        }
+        if (stats) {
+            FillScanStats(*stats, postings_scanned, rejected_by_predicate, removed_by_minus_words, 0,
+                    matched_documents.size());
         }
         return matched_documents;
     }
@@ -296,6 +1020,6 @@ private:
     {
         return FindAllDocuments(std::execution::seq, query, document_predicate);
     }
-    
-    
+
+
 };
@@ -0,0 +1,206 @@
+#include "shard_coordinator.h"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+#include "search_server.h"
+
+ShardClient::ShardClient(std::string socket_path) : socket_path_(std::move(socket_path)) {}
+
+ShardClient::~ShardClient()
+{
+    Disconnect();
+}
+
+std::string ShardClient::Call(std::string_view request, ShardClock::time_point deadline)
+{
+    std::unique_lock guard(mutex_, std::defer_lock);
+    if (!guard.try_lock_until(deadline)) { throw ShardTimeoutError("Shard connection is busy until the deadline."); }
+    std::string response;
+    try {
+        if (fd_ < 0) { fd_ = ConnectUnixSocket(socket_path_); }
+        WriteFrame(fd_, request, deadline);
+        if (!ReadFrame(fd_, response, deadline)) { throw ShardIoError("Shard closed the connection."); }
+    }
+    catch (const ShardIoError&) {
+        Disconnect();
+        throw;
+    }
+
+    BinaryReader reader(response);
+    const auto status = static_cast<ShardResponseStatus>(reader.ReadUint8());
+    if (status == ShardResponseStatus::OK) { return response.substr(1); }
+    const std::string message(reader.ReadString());
+    switch (status) {
+        case ShardResponseStatus::INVALID_ARGUMENT:
+            throw std::invalid_argument(message);
+        case ShardResponseStatus::OUT_OF_RANGE:
+            throw std::out_of_range(message);
+        default:
+            throw std::runtime_error(message);
+    }
+}
+
+void ShardClient::Disconnect()
+{
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+ShardCoordinator::ShardCoordinator(const std::vector<std::string>& socket_paths, ShardClock::duration timeout)
+        : timeout_(timeout), pool_(GetPoolSize(socket_paths.size()))
+{
+    clients_.reserve(socket_paths.size());
+    for (const std::string& socket_path : socket_paths) {
+        clients_.push_back(std::make_unique<ShardClient>(socket_path));
+    }
+}
+
+void ShardCoordinator::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+        const std::vector<int>& ratings)
+{
+    if (document_id < 0) { throw std::invalid_argument("Document ID cannot be less than zero"); }
+    BinaryWriter writer;
+    writer.WriteUint8(static_cast<uint8_t>(ShardRequestType::ADD_DOCUMENT));
+    writer.WriteInt32(document_id);
+    writer.WriteString(document);
+    writer.WriteUint8(static_cast<uint8_t>(status));
+    writer.WriteUint32(static_cast<uint32_t>(ratings.size()));
+    for (const int rating : ratings) {
+        writer.WriteInt32(rating);
+    }
+    GetClient(document_id).Call(writer.GetBuffer(), ShardClock::now() + timeout_);
+}
+
+void ShardCoordinator::RemoveDocument(int document_id)
+{
+    if (document_id < 0) { return; }
+    BinaryWriter writer;
+    writer.WriteUint8(static_cast<uint8_t>(ShardRequestType::REMOVE_DOCUMENT));
+    writer.WriteInt32(document_id);
+    GetClient(document_id).Call(writer.GetBuffer(), ShardClock::now() + timeout_);
+}
+
+TopDocumentsResult ShardCoordinator::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const
+{
+    const ShardClock::time_point start = ShardClock::now();
+    std::vector<size_t> shard_ids(clients_.size());
+    for (size_t i = 0; i < shard_ids.size(); ++i) {
+        shard_ids[i] = i;
+    }
+
+    BinaryWriter statistics_request;
+    statistics_request.WriteUint8(static_cast<uint8_t>(ShardRequestType::GET_CORPUS_STATISTICS));
+    statistics_request.WriteString(raw_query);
+    CorpusStatistics corpus;
+    std::vector<size_t> responded_shard_ids;
+    const auto statistics_responses = Broadcast(shard_ids, statistics_request.GetBuffer(), start + timeout_ / 2);
+    for (const auto& [shard_id, response] : statistics_responses) {
+        BinaryReader reader(response);
+        corpus.Merge(ReadCorpusStatistics(reader));
+        responded_shard_ids.push_back(shard_id);
+    }
+
+    BinaryWriter search_request;
+    search_request.WriteUint8(static_cast<uint8_t>(ShardRequestType::FIND_TOP_DOCUMENTS));
+    search_request.WriteString(raw_query);
+    search_request.WriteUint8(static_cast<uint8_t>(status));
+    WriteCorpusStatistics(search_request, corpus);
+    TopDocumentsResult result;
+    const auto responses = Broadcast(responded_shard_ids, search_request.GetBuffer(), start + timeout_);
+    result.is_partial = responses.size() < clients_.size();
+    for (const auto& [shard_id, response] : responses) {
+        BinaryReader reader(response);
+        const std::vector<Document> shard_documents = ReadDocuments(reader);
+        result.documents.insert(result.documents.end(), shard_documents.begin(), shard_documents.end());
+    }
+
+    std::sort(result.documents.begin(), result.documents.end(), SearchServer::CompareByRelevance);
+    if (result.documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+        result.documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    }
+    return result;
+}
+
+std::tuple<std::vector<std::string>, DocumentStatus> ShardCoordinator::MatchDocument(std::string_view raw_query,
+        int document_id) const
+{
+    if (document_id < 0) { throw std::out_of_range("Document ID cannot be less than zero"); }
+    BinaryWriter writer;
+    writer.WriteUint8(static_cast<uint8_t>(ShardRequestType::MATCH_DOCUMENT));
+    writer.WriteString(raw_query);
+    writer.WriteInt32(document_id);
+    const std::string response = GetClient(document_id).Call(writer.GetBuffer(), ShardClock::now() + timeout_);
+
+    BinaryReader reader(response);
+    std::vector<std::string> words(reader.ReadCount(sizeof(uint32_t)));
+    for (std::string& word : words) {
+        word = reader.ReadString();
+    }
+    return {words, ReadDocumentStatus(reader)};
+}
+
+int ShardCoordinator::GetDocumentCount() const
+{
+    BinaryWriter writer;
+    writer.WriteUint8(static_cast<uint8_t>(ShardRequestType::GET_DOCUMENT_COUNT));
+    const ShardClock::time_point deadline = ShardClock::now() + timeout_;
+    int document_count = 0;
+    for (const auto& client : clients_) {
+        const std::string response = client->Call(writer.GetBuffer(), deadline);
+        BinaryReader reader(response);
+        document_count += reader.ReadInt32();
+    }
+    return document_count;
+}
+
+size_t ShardCoordinator::GetShardCount() const
+{
+    return clients_.size();
+}
+
+size_t ShardCoordinator::GetPoolSize(size_t shard_count)
+{
+    if (shard_count == 0) { throw std::invalid_argument("Shard count must be greater than zero."); }
+    return std::min<size_t>(shard_count, std::max(2u, std::thread::hardware_concurrency()));
+}
+
+ShardClient& ShardCoordinator::GetClient(int document_id) const
+{
+    return *clients_[static_cast<size_t>(document_id) % clients_.size()];
+}
+
+std::vector<std::pair<size_t, std::string>> ShardCoordinator::Broadcast(const std::vector<size_t>& shard_ids,
+        std::string_view request, ShardClock::time_point deadline) const
+{
+    std::vector<std::future<std::string>> futures;
+    futures.reserve(shard_ids.size());
+    for (const size_t shard_id : shard_ids) {
+        ShardClient& client = *clients_[shard_id];
+        futures.push_back(pool_.Submit([&client, request, deadline]() {
+            return client.Call(request, deadline);
+        }));
+    }
+
+    //Дожидаемся всех задач, даже если одна из них завершилась ошибкой: они ссылаются на request
+    std::vector<std::pair<size_t, std::string>> responses;
+    std::exception_ptr error;
+    for (size_t i = 0; i < futures.size(); ++i) {
+        try {
+            responses.emplace_back(shard_ids[i], futures[i].get());
+        }
+        catch (const ShardIoError&) {
+            //Шард не ответил вовремя или недоступен: его документы не попадут в выдачу
+        }
+        catch (...) {
+            if (!error) { error = std::current_exception(); }
+        }
+    }
+    if (error) { std::rethrow_exception(error); }
+    return responses;
+}
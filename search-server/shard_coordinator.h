@@ -0,0 +1,77 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "document.h"
+#include "query_budget.h"
+#include "shard_protocol.h"
+#include "thread_pool.h"
+
+//Соединение с одним узлом-шардом. Запросы через одно соединение выполняются по очереди
+class ShardClient
+{
+public:
+    explicit ShardClient(std::string socket_path);
+    
+    ShardClient(const ShardClient&) = delete;
+    
+    ShardClient& operator=(const ShardClient&) = delete;
+    
+    ~ShardClient();
+    
+    //Возвращает тело ответа без байта статуса. Ошибку узла бросает как std::invalid_argument,
+    //std::out_of_range или std::runtime_error. После ShardIoError соединение закрывается
+    //и открывается заново при следующем запросе: опоздавший ответ не будет принят за чужой.
+    //Если соединение до крайнего срока занято другим запросом, бросает ShardTimeoutError
+    std::string Call(std::string_view request, ShardClock::time_point deadline);
+
+private:
+    std::string socket_path_;
+    std::timed_mutex mutex_;
+    int fd_ = -1;
+    
+    void Disconnect();
+};
+
+//Координатор узлов-шардов, запущенных в отдельных процессах. Документ попадает на узел
+//document_id % shard_count, поиск выполняется на всех узлах в два этапа, как в ShardedSearchServer.
+//Узлы, не ответившие вовремя, исключаются из выдачи, и результат помечается как частичный
+class ShardCoordinator
+{
+public:
+    //timeout - время на весь запрос, на сбор статистики отводится его половина
+    ShardCoordinator(const std::vector<std::string>& socket_paths, ShardClock::duration timeout);
+    
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+            const std::vector<int>& ratings);
+    
+    void RemoveDocument(int document_id);
+    
+    TopDocumentsResult FindTopDocuments(std::string_view raw_query,
+            DocumentStatus status = DocumentStatus::ACTUAL) const;
+    
+    std::tuple<std::vector<std::string>, DocumentStatus> MatchDocument(std::string_view raw_query,
+            int document_id) const;
+    
+    int GetDocumentCount() const;
+    
+    size_t GetShardCount() const;
+
+private:
+    std::vector<std::unique_ptr<ShardClient>> clients_;
+    ShardClock::duration timeout_;
+    mutable ThreadPool pool_;
+    
+    static size_t GetPoolSize(size_t shard_count);
+    
+    ShardClient& GetClient(int document_id) const;
+    
+    //Отправляет запрос шардам shard_ids параллельно и дожидается всех ответов.
+    //Не ответившие шарды в результат не попадают, прочие ошибки пробрасываются
+    std::vector<std::pair<size_t, std::string>> Broadcast(const std::vector<size_t>& shard_ids,
+            std::string_view request, ShardClock::time_point deadline) const;
+};
@@ -0,0 +1,188 @@
+#include "shard_node.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+
+ShardNode::ShardNode(const std::string& socket_path, const std::string& stop_words_text) : socket_path_(
+        socket_path), listen_fd_(ListenUnixSocket(socket_path)), server_(stop_words_text) {}
+
+ShardNode::~ShardNode()
+{
+    Stop();
+    close(listen_fd_);
+    unlink(socket_path_.c_str());
+}
+
+void ShardNode::Run()
+{
+    while (!is_stopped_) {
+        const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) { continue; }
+            if (!is_stopped_) {
+                std::cerr << "ShardNode: cannot accept a connection: " << std::strerror(errno) << std::endl;
+            }
+            break;
+        }
+        std::lock_guard guard(connections_mutex_);
+        if (is_stopped_) {
+            close(fd);
+            break;
+        }
+        //Долго работающий узел не копит потоки отключившихся координаторов
+        ReapFinishedConnections();
+        Connection& connection = connections_.emplace_back();
+        connection.fd = fd;
+        connection.thread = std::thread([this, &connection]() { ServeConnection(connection); });
+    }
+
+    std::list<Connection> connections;
+    {
+        std::lock_guard guard(connections_mutex_);
+        connections.swap(connections_);
+    }
+    for (Connection& connection : connections) {
+        connection.thread.join();
+    }
+}
+
+void ShardNode::Stop()
+{
+    is_stopped_ = true;
+    //shutdown будит потоки, заблокированные в accept и recv
+    shutdown(listen_fd_, SHUT_RDWR);
+    std::lock_guard guard(connections_mutex_);
+    for (const Connection& connection : connections_) {
+        if (!connection.is_finished) { shutdown(connection.fd, SHUT_RDWR); }
+    }
+}
+
+void ShardNode::ReapFinishedConnections()
+{
+    for (auto it = connections_.begin(); it != connections_.end();) {
+        if (it->is_finished) {
+            //Поток отметил завершение под мьютексом и больше его не захватывает, поэтому join не блокируется надолго
+            it->thread.join();
+            it = connections_.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void ShardNode::ServeConnection(Connection& connection)
+{
+    const int fd = connection.fd;
+    try {
+        std::string request;
+        while (!is_stopped_ && ReadFrame(fd, request)) {
+            WriteFrame(fd, HandleRequest(request));
+        }
+    }
+    catch (const ShardIoError&) {
+        //Координатор отключился или нарушил протокол: просто закрываем соединение
+    }
+    catch (const std::exception& error) {
+        //Например, нехватка памяти под кадр: закрывается только это соединение, узел продолжает работу
+        std::cerr << "ShardNode: connection failed: " << error.what() << std::endl;
+    }
+    std::lock_guard guard(connections_mutex_);
+    close(fd);
+    connection.is_finished = true;
+}
+
+std::string ShardNode::HandleRequest(std::string_view request)
+{
+    BinaryReader reader(request);
+    BinaryWriter writer;
+    ShardResponseStatus status = ShardResponseStatus::OK;
+    std::string error_message;
+    try {
+        const auto type = static_cast<ShardRequestType>(reader.ReadUint8());
+        writer.WriteUint8(static_cast<uint8_t>(ShardResponseStatus::OK));
+        HandleRequest(type, reader, writer);
+    }
+    catch (const std::invalid_argument& error) {
+        status = ShardResponseStatus::INVALID_ARGUMENT;
+        error_message = error.what();
+    }
+    catch (const std::out_of_range& error) {
+        status = ShardResponseStatus::OUT_OF_RANGE;
+        error_message = error.what();
+    }
+    catch (const std::exception& error) {
+        status = ShardResponseStatus::INTERNAL_ERROR;
+        error_message = error.what();
+    }
+    if (status == ShardResponseStatus::OK) { return writer.GetBuffer(); }
+
+    BinaryWriter error_writer;
+    error_writer.WriteUint8(static_cast<uint8_t>(status));
+    error_writer.WriteString(error_message);
+    return error_writer.GetBuffer();
+}
+
+void ShardNode::HandleRequest(ShardRequestType type, BinaryReader& reader, BinaryWriter& writer)
+{
+    switch (type) {
+        case ShardRequestType::ADD_DOCUMENT: {
+            const int document_id = reader.ReadInt32();
+            const std::string_view document = reader.ReadString();
+            const DocumentStatus status = ReadDocumentStatus(reader);
+            std::vector<int> ratings(reader.ReadCount(sizeof(int32_t)));
+            for (int& rating : ratings) {
+                rating = reader.ReadInt32();
+            }
+            std::unique_lock lock(server_mutex_);
+            server_.AddDocument(document_id, document, status, ratings);
+            return;
+        }
+        case ShardRequestType::REMOVE_DOCUMENT: {
+            const int document_id = reader.ReadInt32();
+            std::unique_lock lock(server_mutex_);
+            server_.RemoveDocument(document_id);
+            return;
+        }
+        case ShardRequestType::GET_CORPUS_STATISTICS: {
+            const std::string_view raw_query = reader.ReadString();
+            std::shared_lock lock(server_mutex_);
+            WriteCorpusStatistics(writer, server_.GetCorpusStatistics(raw_query));
+            return;
+        }
+        case ShardRequestType::FIND_TOP_DOCUMENTS: {
+            const std::string_view raw_query = reader.ReadString();
+            const DocumentStatus status = ReadDocumentStatus(reader);
+            const CorpusStatistics corpus = ReadCorpusStatistics(reader);
+            auto predicate = [status]([[maybe_unused]] int document_id, DocumentStatus document_status,
+                    [[maybe_unused]] int rating) {
+                return document_status == status;
+            };
+            std::shared_lock lock(server_mutex_);
+            WriteDocuments(writer, server_.FindTopDocuments(std::execution::seq, raw_query, predicate, corpus));
+            return;
+        }
+        case ShardRequestType::MATCH_DOCUMENT: {
+            const std::string_view raw_query = reader.ReadString();
+            const int document_id = reader.ReadInt32();
+            std::shared_lock lock(server_mutex_);
+            const auto [words, status] = server_.MatchDocument(raw_query, document_id);
+            writer.WriteUint32(static_cast<uint32_t>(words.size()));
+            for (const std::string_view word : words) {
+                writer.WriteString(word);
+            }
+            writer.WriteUint8(static_cast<uint8_t>(status));
+            return;
+        }
+        case ShardRequestType::GET_DOCUMENT_COUNT: {
+            std::shared_lock lock(server_mutex_);
+            writer.WriteInt32(server_.GetDocumentCount());
+            return;
+        }
+    }
+    throw ShardIoError("Unknown request type.");
+}
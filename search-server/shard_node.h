@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "search_server.h"
+#include "shard_protocol.h"
+
+//Узел-шард: SearchServer, который обслуживает запросы координатора по Unix-сокету.
+//Каждое соединение обрабатывается в своём потоке, запросы одного соединения - по очереди
+class ShardNode
+{
+public:
+    ShardNode(const std::string& socket_path, const std::string& stop_words_text);
+    
+    ShardNode(const ShardNode&) = delete;
+    
+    ShardNode& operator=(const ShardNode&) = delete;
+    
+    //Останавливает узел и удаляет файл сокета. Поток, выполняющий Run, должен быть завершён
+    ~ShardNode();
+    
+    //Принимает соединения, пока не будет вызван Stop. При ошибке accept пишет её в std::cerr и завершается раньше
+    void Run();
+    
+    //Можно вызывать из любого потока, в том числе до Run
+    void Stop();
+
+private:
+    struct Connection
+    {
+        int fd = -1;
+        std::thread thread;
+        //Поток закончил обслуживание и закрыл fd, осталось дождаться его завершения
+        bool is_finished = false;
+    };
+    
+    std::string socket_path_;
+    int listen_fd_;
+    mutable std::shared_mutex server_mutex_;
+    SearchServer server_;
+    std::atomic_bool is_stopped_{false};
+    std::mutex connections_mutex_;
+    //Элементы списка не перемещаются, поэтому поток соединения может ссылаться на свой элемент
+    std::list<Connection> connections_;
+    
+    //Дожидается потоков завершённых соединений и удаляет их. Вызывается под connections_mutex_
+    void ReapFinishedConnections();
+    
+    void ServeConnection(Connection& connection);
+    
+    std::string HandleRequest(std::string_view request);
+    
+    void HandleRequest(ShardRequestType type, BinaryReader& reader, BinaryWriter& writer);
+};
@@ -0,0 +1,268 @@
+#include "shard_protocol.h"
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+std::string MakeErrorMessage(const std::string& message)
+{
+    return message + ": " + std::strerror(errno);
+}
+
+//Ждёт готовности дескриптора к событию events до крайнего срока
+void WaitForDescriptor(int fd, short events, ShardClock::time_point deadline)
+{
+    while (true) {
+        int timeout_ms = -1;
+        if (deadline != ShardClock::time_point::max()) {
+            const auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - ShardClock::now());
+            if (left.count() <= 0) { throw ShardTimeoutError("Shard did not respond in time."); }
+            timeout_ms = static_cast<int>(left.count());
+        }
+        pollfd descriptor{fd, events, 0};
+        const int result = poll(&descriptor, 1, timeout_ms);
+        if (result > 0) { return; }
+        if (result < 0 && errno != EINTR) { throw ShardIoError(MakeErrorMessage("poll failed")); }
+    }
+}
+
+//Читает ровно size байт. Возвращает false, если соединение закрыто до первого байта
+bool ReadExactly(int fd, char* data, size_t size, ShardClock::time_point deadline)
+{
+    size_t received = 0;
+    while (received < size) {
+        WaitForDescriptor(fd, POLLIN, deadline);
+        const ssize_t result = recv(fd, data + received, size - received, 0);
+        if (result == 0) {
+            if (received == 0) { return false; }
+            throw ShardIoError("Connection closed in the middle of a frame.");
+        }
+        if (result < 0) {
+            if (errno == EINTR || errno == EAGAIN) { continue; }
+            throw ShardIoError(MakeErrorMessage("recv failed"));
+        }
+        received += static_cast<size_t>(result);
+    }
+    return true;
+}
+
+sockaddr_un MakeAddress(const std::string& path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw ShardIoError("Socket path \"" + path + "\" is too long.");
+    }
+    std::memcpy(address.sun_path, path.data(), path.size());
+    return address;
+}
+
+} // namespace
+
+void BinaryWriter::WriteUint8(uint8_t value)
+{
+    WriteBytes(&value, sizeof(value));
+}
+
+void BinaryWriter::WriteInt32(int32_t value)
+{
+    WriteBytes(&value, sizeof(value));
+}
+
+void BinaryWriter::WriteUint32(uint32_t value)
+{
+    WriteBytes(&value, sizeof(value));
+}
+
+void BinaryWriter::WriteDouble(double value)
+{
+    WriteBytes(&value, sizeof(value));
+}
+
+void BinaryWriter::WriteString(std::string_view value)
+{
+    WriteUint32(static_cast<uint32_t>(value.size()));
+    WriteBytes(value.data(), value.size());
+}
+
+const std::string& BinaryWriter::GetBuffer() const
+{
+    return buffer_;
+}
+
+void BinaryWriter::WriteBytes(const void* data, size_t size)
+{
+    buffer_.append(static_cast<const char*>(data), size);
+}
+
+BinaryReader::BinaryReader(std::string_view buffer) : buffer_(buffer) {}
+
+uint8_t BinaryReader::ReadUint8()
+{
+    uint8_t value;
+    ReadBytes(&value, sizeof(value));
+    return value;
+}
+
+int32_t BinaryReader::ReadInt32()
+{
+    int32_t value;
+    ReadBytes(&value, sizeof(value));
+    return value;
+}
+
+uint32_t BinaryReader::ReadUint32()
+{
+    uint32_t value;
+    ReadBytes(&value, sizeof(value));
+    return value;
+}
+
+double BinaryReader::ReadDouble()
+{
+    double value;
+    ReadBytes(&value, sizeof(value));
+    return value;
+}
+
+std::string_view BinaryReader::ReadString()
+{
+    const uint32_t size = ReadUint32();
+    if (size > buffer_.size()) { throw ShardIoError("Unexpected end of message."); }
+    const std::string_view value = buffer_.substr(0, size);
+    buffer_.remove_prefix(size);
+    return value;
+}
+
+uint32_t BinaryReader::ReadCount(size_t min_item_size)
+{
+    const uint32_t count = ReadUint32();
+    if (count > buffer_.size() / min_item_size) { throw ShardIoError("Element count exceeds the message size."); }
+    return count;
+}
+
+bool BinaryReader::IsAtEnd() const
+{
+    return buffer_.empty();
+}
+
+void BinaryReader::ReadBytes(void* data, size_t size)
+{
+    if (size > buffer_.size()) { throw ShardIoError("Unexpected end of message."); }
+    std::memcpy(data, buffer_.data(), size);
+    buffer_.remove_prefix(size);
+}
+
+void WriteCorpusStatistics(BinaryWriter& writer, const CorpusStatistics& statistics)
+{
+    writer.WriteInt32(statistics.document_count);
+    writer.WriteUint32(static_cast<uint32_t>(statistics.document_freqs.size()));
+    for (const auto& [word, document_freq] : statistics.document_freqs) {
+        writer.WriteString(word);
+        writer.WriteInt32(document_freq);
+    }
+}
+
+CorpusStatistics ReadCorpusStatistics(BinaryReader& reader)
+{
+    CorpusStatistics statistics;
+    statistics.document_count = reader.ReadInt32();
+    const uint32_t word_count = reader.ReadCount(sizeof(uint32_t) + sizeof(int32_t));
+    for (uint32_t i = 0; i < word_count; ++i) {
+        const std::string_view word = reader.ReadString();
+        statistics.document_freqs.emplace(word, reader.ReadInt32());
+    }
+    return statistics;
+}
+
+void WriteDocuments(BinaryWriter& writer, const std::vector<Document>& documents)
+{
+    writer.WriteUint32(static_cast<uint32_t>(documents.size()));
+    for (const Document& document : documents) {
+        writer.WriteInt32(document.id);
+        writer.WriteDouble(document.relevance);
+        writer.WriteInt32(document.rating);
+    }
+}
+
+std::vector<Document> ReadDocuments(BinaryReader& reader)
+{
+    const uint32_t document_count = reader.ReadCount(sizeof(int32_t) + sizeof(double) + sizeof(int32_t));
+    std::vector<Document> documents;
+    documents.reserve(document_count);
+    for (uint32_t i = 0; i < document_count; ++i) {
+        const int id = reader.ReadInt32();
+        const double relevance = reader.ReadDouble();
+        documents.emplace_back(id, relevance, reader.ReadInt32());
+    }
+    return documents;
+}
+
+DocumentStatus ReadDocumentStatus(BinaryReader& reader)
+{
+    const uint8_t status = reader.ReadUint8();
+    if (status > static_cast<uint8_t>(DocumentStatus::REMOVED)) { throw ShardIoError("Invalid document status."); }
+    return static_cast<DocumentStatus>(status);
+}
+
+void WriteFrame(int fd, std::string_view payload, ShardClock::time_point deadline)
+{
+    if (payload.size() > MAX_SHARD_FRAME_SIZE) { throw ShardIoError("Frame is too large."); }
+    const uint32_t size = static_cast<uint32_t>(payload.size());
+    std::string frame(reinterpret_cast<const char*>(&size), sizeof(size));
+    frame.append(payload);
+    size_t sent = 0;
+    while (sent < frame.size()) {
+        WaitForDescriptor(fd, POLLOUT, deadline);
+        const ssize_t result = send(fd, frame.data() + sent, frame.size() - sent, MSG_NOSIGNAL);
+        if (result < 0) {
+            if (errno == EINTR || errno == EAGAIN) { continue; }
+            throw ShardIoError(MakeErrorMessage("send failed"));
+        }
+        sent += static_cast<size_t>(result);
+    }
+}
+
+bool ReadFrame(int fd, std::string& payload, ShardClock::time_point deadline)
+{
+    uint32_t size = 0;
+    if (!ReadExactly(fd, reinterpret_cast<char*>(&size), sizeof(size), deadline)) { return false; }
+    if (size > MAX_SHARD_FRAME_SIZE) { throw ShardIoError("Frame is too large."); }
+    payload.resize(size);
+    if (size > 0 && !ReadExactly(fd, payload.data(), size, deadline)) {
+        throw ShardIoError("Connection closed in the middle of a frame.");
+    }
+    return true;
+}
+
+int ListenUnixSocket(const std::string& path)
+{
+    const sockaddr_un address = MakeAddress(path);
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) { throw ShardIoError(MakeErrorMessage("socket failed")); }
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        const std::string message = MakeErrorMessage("Cannot listen on \"" + path + "\"");
+        close(fd);
+        throw ShardIoError(message);
+    }
+    return fd;
+}
+
+int ConnectUnixSocket(const std::string& path)
+{
+    const sockaddr_un address = MakeAddress(path);
+    const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) { throw ShardIoError(MakeErrorMessage("socket failed")); }
+    if (connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) < 0) {
+        const std::string message = MakeErrorMessage("Cannot connect to \"" + path + "\"");
+        close(fd);
+        throw ShardIoError(message);
+    }
+    return fd;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "corpus_statistics.h"
+#include "document.h"
+
+//Двоичный протокол между координатором и узлами-шардами на Unix-сокетах.
+//Кадр: длина полезной нагрузки (uint32) и сама нагрузка. Числа передаются в порядке байт хоста:
+//все процессы работают на одной машине
+
+//Максимальный размер кадра, больший кадр считается ошибкой протокола
+const uint32_t MAX_SHARD_FRAME_SIZE = 64u << 20;
+
+enum class ShardRequestType : uint8_t
+{
+    ADD_DOCUMENT = 1, REMOVE_DOCUMENT, GET_CORPUS_STATISTICS, FIND_TOP_DOCUMENTS, MATCH_DOCUMENT, GET_DOCUMENT_COUNT,
+};
+
+//Первый байт ответа. Ошибки узла передаются вместе с сообщением и превращаются координатором
+//в исключения того же типа, что бросил бы SearchServer
+enum class ShardResponseStatus : uint8_t
+{
+    OK, INVALID_ARGUMENT, OUT_OF_RANGE, INTERNAL_ERROR,
+};
+
+//Ошибка обмена с шардом: обрыв соединения, нарушение протокола
+class ShardIoError : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+
+//Шард не ответил до крайнего срока
+class ShardTimeoutError : public ShardIoError
+{
+public:
+    using ShardIoError::ShardIoError;
+};
+
+class BinaryWriter
+{
+public:
+    void WriteUint8(uint8_t value);
+    
+    void WriteInt32(int32_t value);
+    
+    void WriteUint32(uint32_t value);
+    
+    void WriteDouble(double value);
+    
+    void WriteString(std::string_view value);
+    
+    const std::string& GetBuffer() const;
+
+private:
+    std::string buffer_;
+    
+    void WriteBytes(const void* data, size_t size);
+};
+
+//Читает значения в порядке записи BinaryWriter. При нехватке данных бросает ShardIoError
+class BinaryReader
+{
+public:
+    explicit BinaryReader(std::string_view buffer);
+    
+    uint8_t ReadUint8();
+    
+    int32_t ReadInt32();
+    
+    uint32_t ReadUint32();
+    
+    double ReadDouble();
+    
+    //Строка ссылается на буфер читателя
+    std::string_view ReadString();
+    
+    //Число элементов перед их списком. Бросает ShardIoError, если в оставшихся данных не поместится
+    //столько элементов размером не меньше min_item_size: испорченный кадр не вызовет огромного выделения памяти
+    uint32_t ReadCount(size_t min_item_size);
+    
+    bool IsAtEnd() const;
+
+private:
+    std::string_view buffer_;
+    
+    void ReadBytes(void* data, size_t size);
+};
+
+void WriteCorpusStatistics(BinaryWriter& writer, const CorpusStatistics& statistics);
+
+CorpusStatistics ReadCorpusStatistics(BinaryReader& reader);
+
+void WriteDocuments(BinaryWriter& writer, const std::vector<Document>& documents);
+
+std::vector<Document> ReadDocuments(BinaryReader& reader);
+
+DocumentStatus ReadDocumentStatus(BinaryReader& reader);
+
+using ShardClock = std::chrono::steady_clock;
+
+//Отправляет кадр целиком. При ошибке бросает ShardIoError, по истечении deadline - ShardTimeoutError
+void WriteFrame(int fd, std::string_view payload, ShardClock::time_point deadline = ShardClock::time_point::max());
+
+//Читает кадр целиком. Возвращает false, если соединение закрыто до начала кадра
+bool ReadFrame(int fd, std::string& payload, ShardClock::time_point deadline = ShardClock::time_point::max());
+
+//Создаёт слушающий сокет по пути path (существующий файл сокета удаляется). Бросает ShardIoError
+int ListenUnixSocket(const std::string& path);
+
+//Подключается к сокету по пути path. Бросает ShardIoError
+int ConnectUnixSocket(const std::string& path);
@@ -0,0 +1,74 @@
+#include "sharded_search_server.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+ShardedSearchServer::ShardedSearchServer(size_t shard_count, const std::string& stop_words_text)
+        : ShardedSearchServer(shard_count, SplitIntoWordsView(stop_words_text)) {}
+
+void ShardedSearchServer::AddDocument(int document_id, const std::string_view& document, DocumentStatus status,
+        const std::vector<int>& ratings)
+{
+    if (document_id < 0) { throw std::invalid_argument("Document ID cannot be less than zero"); }
+    Shard& shard = GetShard(document_id);
+    std::unique_lock lock(shard.mutex);
+    shard.server.AddDocument(document_id, document, status, ratings);
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id)
+{
+    if (document_id < 0) { return; }
+    Shard& shard = GetShard(document_id);
+    std::unique_lock lock(shard.mutex);
+    shard.server.RemoveDocument(document_id);
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const std::string_view& raw_query,
+        DocumentStatus status) const
+{
+    return FindTopDocuments(raw_query,
+            [status]([[maybe_unused]] int document_id, DocumentStatus document_status, [[maybe_unused]] int rating) {
+                return document_status == status;
+            });
+}
+
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const std::string_view& raw_query) const
+{
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(
+        const std::string_view& raw_query, int document_id) const
+{
+    if (document_id < 0) { throw std::out_of_range("Document ID cannot be less than zero"); }
+    const Shard& shard = GetShard(document_id);
+    std::shared_lock lock(shard.mutex);
+    return shard.server.MatchDocument(raw_query, document_id);
+}
+
+int ShardedSearchServer::GetDocumentCount() const
+{
+    int document_count = 0;
+    for (const auto& shard : shards_) {
+        std::shared_lock lock(shard->mutex);
+        document_count += shard->server.GetDocumentCount();
+    }
+    return document_count;
+}
+
+size_t ShardedSearchServer::GetShardCount() const
+{
+    return shards_.size();
+}
+
+size_t ShardedSearchServer::GetPoolSize(size_t shard_count)
+{
+    if (shard_count == 0) { throw std::invalid_argument("Shard count must be greater than zero."); }
+    return std::min<size_t>(shard_count, std::max(2u, std::thread::hardware_concurrency()));
+}
+
+ShardedSearchServer::Shard& ShardedSearchServer::GetShard(int document_id) const
+{
+    return *shards_[static_cast<size_t>(document_id) % shards_.size()];
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <exception>
+#include <future>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "search_server.h"
+#include "thread_pool.h"
+
+//Поисковый сервер из нескольких независимых шардов. Документ попадает в шард document_id % shard_count.
+//Запрос выполняется на всех шардах параллельно в два этапа: сначала собирается глобальная статистика слов
+//запроса, затем каждый шард ищет свои лучшие документы с глобальным IDF, и результаты сливаются.
+//Для обычных слов выдача совпадает с выдачей одного SearchServer с теми же документами. Слова "префикс*"
+//и "слово~N" каждый шард раскрывает сам не больше чем в MAX_PREFIX_EXPANSION_COUNT и MAX_FUZZY_EXPANSION_COUNT
+//слов. Пока лимит не достигнут, выдача тоже совпадает, иначе шарды могут выбрать разные слова и выдача разойдётся.
+//Добавление и удаление документов в разные шарды можно выполнять из разных потоков одновременно
+class ShardedSearchServer
+{
+public:
+    ShardedSearchServer(size_t shard_count, const std::string& stop_words_text);
+    
+    template<typename StringContainer>
+    ShardedSearchServer(size_t shard_count, const StringContainer& stop_words) : pool_(GetPoolSize(shard_count))
+    {
+        shards_.reserve(shard_count);
+        for (size_t i = 0; i < shard_count; ++i) {
+            shards_.push_back(std::make_unique<Shard>(stop_words));
+        }
+    }
+    
+    void AddDocument(int document_id, const std::string_view& document, DocumentStatus status,
+            const std::vector<int>& ratings);
+    
+    void RemoveDocument(int document_id);
+    
+    template<typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentPredicate document_predicate) const
+    {
+        //Стоп-слова у шардов общие, поэтому ошибка запроса находится до рассылки
+        shards_.front()->server.CheckQuery(raw_query);
+        //Блокировки держит вызывающий поток, пока задачи шардов выполняются в пуле
+        std::vector<std::shared_lock<std::shared_mutex>> locks;
+        locks.reserve(shards_.size());
+        for (const auto& shard : shards_) {
+            locks.emplace_back(shard->mutex);
+        }
+        
+        const std::string query(raw_query);
+        std::vector<std::future<CorpusStatistics>> statistics_futures;
+        statistics_futures.reserve(shards_.size());
+        for (const auto& shard : shards_) {
+            statistics_futures.push_back(pool_.Submit([&shard, &query]() {
+                return shard->server.GetCorpusStatistics(query);
+            }));
+        }
+        CorpusStatistics corpus;
+        for (const CorpusStatistics& statistics : GetAll(statistics_futures)) {
+            corpus.Merge(statistics);
+        }
+        
+        std::vector<std::future<std::vector<Document>>> documents_futures;
+        documents_futures.reserve(shards_.size());
+        for (const auto& shard : shards_) {
+            documents_futures.push_back(pool_.Submit([&shard, &query, &corpus, document_predicate]() {
+                return shard->server.FindTopDocuments(std::execution::seq, query, document_predicate, corpus);
+            }));
+        }
+        std::vector<Document> matched_documents;
+        for (const std::vector<Document>& shard_documents : GetAll(documents_futures)) {
+            matched_documents.insert(matched_documents.end(), shard_documents.begin(), shard_documents.end());
+        }
+        
+        std::sort(matched_documents.begin(), matched_documents.end(), SearchServer::CompareByRelevance);
+        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        }
+        return matched_documents;
+    }
+    
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentStatus status) const;
+    
+    std::vector<Document> FindTopDocuments(const std::string_view& raw_query) const;
+    
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view& raw_query,
+            int document_id) const;
+    
+    int GetDocumentCount() const;
+    
+    size_t GetShardCount() const;
+
+private:
+    struct Shard
+    {
+        template<typename StopWords>
+        explicit Shard(const StopWords& stop_words) : server(stop_words) {}
+        
+        mutable std::shared_mutex mutex;
+        SearchServer server;
+    };
+    
+    std::vector<std::unique_ptr<Shard>> shards_;
+    mutable ThreadPool pool_;
+    
+    //Не больше потоков, чем шардов и ядер. Бросает std::invalid_argument при нулевом числе шардов
+    static size_t GetPoolSize(size_t shard_count);
+    
+    Shard& GetShard(int document_id) const;
+    
+    //Дожидается всех задач, даже если одна из них завершилась ошибкой: они ссылаются на запрос, статистику
+    //и блокировки вызывающего потока. Затем бросает первую ошибку
+    template<typename Result>
+    static std::vector<Result> GetAll(std::vector<std::future<Result>>& futures)
+    {
+        std::vector<Result> results;
+        results.reserve(futures.size());
+        std::exception_ptr error;
+        for (auto& future : futures) {
+            try {
+                results.push_back(future.get());
+            }
+            catch (...) {
+                if (!error) { error = std::current_exception(); }
+            }
+        }
+        if (error) { std::rethrow_exception(error); }
+        return results;
+    }
+};
@@ -0,0 +1,114 @@
+#include "sorted_intersection.h"
+
+#include <algorithm>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+//Во сколько раз больший массив должен быть длиннее меньшего, чтобы экспоненциальный поиск обогнал слияние
+const size_t GALLOP_SIZE_RATIO = 32;
+
+//Первая позиция в [begin, end), где элемент не меньше value: шаги 1, 2, 4, ... затем двоичный поиск
+const int* Gallop(const int* begin, const int* end, int value)
+{
+    size_t step = 1;
+    const int* low = begin;
+    while (begin + step < end && begin[step] < value) {
+        low = begin + step;
+        step *= 2;
+    }
+    return std::lower_bound(low, std::min(begin + step + 1, end), value);
+}
+
+//Элементы small ищутся в large; is_first_only - остановиться на первом общем элементе
+size_t IntersectGalloping(const int* small, size_t small_size, const int* large, size_t large_size, int* out,
+        bool is_first_only)
+{
+    size_t count = 0;
+    const int* position = large;
+    const int* const large_end = large + large_size;
+    for (const int* it = small; it != small + small_size && position != large_end; ++it) {
+        position = Gallop(position, large_end, *it);
+        if (position != large_end && *position == *it) {
+            if (out) { out[count] = *it; }
+            ++count;
+            if (is_first_only) { break; }
+        }
+    }
+    return count;
+}
+
+size_t IntersectMerging(const int* lhs, size_t lhs_size, const int* rhs, size_t rhs_size, int* out,
+        bool is_first_only)
+{
+    size_t count = 0;
+    size_t i = 0;
+    size_t j = 0;
+#ifdef __SSE2__
+    while (i + 4 <= lhs_size && j + 4 <= rhs_size) {
+        const __m128i lhs_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs + i));
+        const __m128i rhs_block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs + j));
+        //Каждый элемент блока lhs сравнивается со всеми четырьмя элементами блока rhs через повороты
+        const __m128i equal = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi32(lhs_block, rhs_block),
+                        _mm_cmpeq_epi32(lhs_block, _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(0, 3, 2, 1)))),
+                _mm_or_si128(_mm_cmpeq_epi32(lhs_block, _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(1, 0, 3, 2))),
+                        _mm_cmpeq_epi32(lhs_block, _mm_shuffle_epi32(rhs_block, _MM_SHUFFLE(2, 1, 0, 3)))));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+        if (mask != 0) {
+            if (is_first_only) { return 1; }
+            for (; mask != 0; mask &= mask - 1) {
+                out[count++] = lhs[i + __builtin_ctz(mask)];
+            }
+        }
+        const int lhs_last = lhs[i + 3];
+        const int rhs_last = rhs[j + 3];
+        if (lhs_last <= rhs_last) { i += 4; }
+        if (rhs_last <= lhs_last) { j += 4; }
+    }
+#endif
+    while (i < lhs_size && j < rhs_size) {
+        if (lhs[i] < rhs[j]) {
+            ++i;
+        }
+        else if (rhs[j] < lhs[i]) {
+            ++j;
+        }
+        else {
+            if (is_first_only) { return 1; }
+            out[count++] = lhs[i];
+            ++i;
+            ++j;
+        }
+    }
+    return count;
+}
+
+size_t Intersect(const int* lhs, size_t lhs_size, const int* rhs, size_t rhs_size, int* out, bool is_first_only)
+{
+    if (lhs_size > rhs_size) {
+        std::swap(lhs, rhs);
+        std::swap(lhs_size, rhs_size);
+    }
+    if (lhs_size == 0) { return 0; }
+    if (rhs_size / lhs_size >= GALLOP_SIZE_RATIO) {
+        return IntersectGalloping(lhs, lhs_size, rhs, rhs_size, out, is_first_only);
+    }
+    return IntersectMerging(lhs, lhs_size, rhs, rhs_size, out, is_first_only);
+}
+
+} // namespace
+
+size_t IntersectSorted(const int* lhs, size_t lhs_size, const int* rhs, size_t rhs_size, int* out)
+{
+    return Intersect(lhs, lhs_size, rhs, rhs_size, out, false);
+}
+
+bool IntersectsSorted(const int* lhs, size_t lhs_size, const int* rhs, size_t rhs_size)
+{
+    return Intersect(lhs, lhs_size, rhs, rhs_size, nullptr, true) != 0;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+//Пересечение двух возрастающих массивов без повторов. Записывает общие элементы по возрастанию в out,
+//в котором должно быть место для min(lhs_size, rhs_size) элементов, и возвращает их число.
+//При сравнимых размерах массивы сливаются блоками по 4 элемента: блок одного массива сравнивается с блоком другого
+//за 4 векторных сравнения (SSE2), затем сдвигается блок с меньшим последним элементом. Если один массив во много
+//раз меньше, каждый его элемент ищется в большем экспоненциальным поиском от предыдущей найденной позиции,
+//и время пропорционально меньшему массиву с логарифмом отношения размеров
+size_t IntersectSorted(const int* lhs, size_t lhs_size, const int* rhs, size_t rhs_size, int* out);
+
+//Есть ли у массивов общий элемент; условия те же, но результат не записывается
+bool IntersectsSorted(const int* lhs, size_t lhs_size, const int* rhs, size_t rhs_size);
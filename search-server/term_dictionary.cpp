@@ -0,0 +1,98 @@
+#include <cstring>
+#include "term_dictionary.h"
+
+TermDictionary::TermDictionary(std::pmr::memory_resource* resource) : resource_(resource), chunks_(resource), words_(
+        resource), index_(resource) {}
+
+TermDictionary::TermDictionary(TermDictionary&& other) noexcept : resource_(other.resource_), chunks_(
+        std::move(other.chunks_)), chunk_used_(other.chunk_used_), chunk_capacity_(other.chunk_capacity_), arena_bytes_(
+        other.arena_bytes_), words_(std::move(other.words_)), index_(std::move(other.index_))
+{
+    other.chunks_.clear();
+    other.chunk_used_ = other.chunk_capacity_ = other.arena_bytes_ = 0;
+}
+
+TermDictionary::~TermDictionary()
+{
+    for (const Chunk& chunk : chunks_) {
+        resource_->deallocate(chunk.data, chunk.size, alignof(char));
+    }
+}
+
+std::pair<int, bool> TermDictionary::Insert(std::string_view word)
+{
+    const auto it = index_.find(word);
+    if (it != index_.end()) {
+        return {it->second, false};
+    }
+    const int term_id = static_cast<int>(words_.size());
+    const std::string_view interned = Intern(word);
+    words_.push_back(interned);
+    index_.emplace(interned, term_id);
+    return {term_id, true};
+}
+
+int TermDictionary::Find(std::string_view word) const
+{
+    const auto it = index_.find(word);
+    return it == index_.end() ? -1 : it->second;
+}
+
+std::string_view TermDictionary::GetWord(int term_id) const
+{
+    return words_.at(term_id);
+}
+
+std::string_view TermDictionary::operator[](int term_id) const
+{
+    return words_[term_id];
+}
+
+size_t TermDictionary::size() const
+{
+    return words_.size();
+}
+
+size_t TermDictionary::GetArenaBytes() const
+{
+    return arena_bytes_;
+}
+
+size_t TermDictionary::GetIndexBytes() const
+{
+    //Узел: указатель на следующий, ключ, значение и кэшированный хеш; плюс массив корзин
+    const size_t node_bytes = sizeof(void*) + sizeof(std::pair<const std::string_view, int>) + sizeof(size_t);
+    return index_.size() * node_bytes + index_.bucket_count() * sizeof(void*)
+            + words_.capacity() * sizeof(std::string_view);
+}
+
+std::string_view TermDictionary::Intern(std::string_view word)
+{
+    if (word.empty()) { return {}; }
+    //Длинные слова получают собственный блок, чтобы не оставлять пустым хвост текущего
+    if (word.size() > CHUNK_SIZE / 4) {
+        char* data = AllocateChunk(word.size());
+        std::memcpy(data, word.data(), word.size());
+        //Текущий блок для коротких слов больше не последний, начинаем новый при следующей вставке
+        chunk_used_ = chunk_capacity_ = 0;
+        return {data, word.size()};
+    }
+    if (chunk_capacity_ - chunk_used_ < word.size()) {
+        AllocateChunk(CHUNK_SIZE);
+        chunk_used_ = 0;
+        chunk_capacity_ = CHUNK_SIZE;
+    }
+    char* data = chunks_.back().data + chunk_used_;
+    std::memcpy(data, word.data(), word.size());
+    chunk_used_ += word.size();
+    return {data, word.size()};
+}
+
+char* TermDictionary::AllocateChunk(size_t size)
+{
+    chunks_.reserve(chunks_.size() + 1);
+    char* data = static_cast<char*>(resource_->allocate(size, alignof(char)));
+    chunks_.push_back({data, size});
+    arena_bytes_ += size;
+    return data;
+}
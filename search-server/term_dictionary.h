@@ -0,0 +1,65 @@
+#pragma once
+
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//Словарь слов индекса. Слова хранятся подряд в блоках, которые только дописываются и никогда
+//не перемещаются, поэтому string_view на слова остаются действительными до уничтожения словаря.
+//Id слов выдаются по порядку добавления
+class TermDictionary
+{
+public:
+    static const size_t CHUNK_SIZE = 64 * 1024;
+    
+    explicit TermDictionary(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    
+    TermDictionary(const TermDictionary&) = delete;
+    
+    TermDictionary& operator=(const TermDictionary&) = delete;
+    
+    TermDictionary(TermDictionary&& other) noexcept;
+    
+    TermDictionary& operator=(TermDictionary&&) = delete;
+    
+    ~TermDictionary();
+    
+    //Возвращает id слова и true, если слово добавлено впервые
+    std::pair<int, bool> Insert(std::string_view word);
+    
+    //-1, если слова нет в словаре
+    int Find(std::string_view word) const;
+    
+    std::string_view GetWord(int term_id) const;
+    
+    std::string_view operator[](int term_id) const;
+    
+    size_t size() const;
+    
+    //Память под блоки слов
+    size_t GetArenaBytes() const;
+    
+    //Приблизительная память хеш-индекса
+    size_t GetIndexBytes() const;
+
+private:
+    struct Chunk
+    {
+        char* data;
+        size_t size;
+    };
+    
+    std::pmr::memory_resource* resource_;
+    std::pmr::vector<Chunk> chunks_;
+    size_t chunk_used_ = 0;
+    size_t chunk_capacity_ = 0;
+    size_t arena_bytes_ = 0;
+    std::pmr::vector<std::string_view> words_;
+    std::pmr::unordered_map<std::string_view, int> index_;
+    
+    std::string_view Intern(std::string_view word);
+    
+    char* AllocateChunk(size_t size);
+};
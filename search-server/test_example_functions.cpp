@@ -1,6 +1,24 @@
 #include "test_example_functions.h"
 #include "paginator.h"
 #include "process_queries.h"
+#include "remove_duplicates.h"
+#include "corpus_generator.h"
+#include "sharded_search_server.h"
+#include "shard_coordinator.h"
+#include "shard_node.h"
+#include "search_front_end.h"
+#include "concurrent_search_server.h"
+#include "corpus_loader.h"
+#include "document_reordering.h"
+#include "document_set.h"
+#include "sorted_intersection.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <fstream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 void AssertImpl(bool value, const std::string& expr_str, const std::string& file, const std::string& func,
         unsigned int line, const std::string& hint)
@@ -730,6 +748,1709 @@ void TestProcessQueriesJoined()
     
 }
 
+void TestFindTopDocumentsAsync()
+{
+    using namespace std;
+    SearchServer search_server("and with"s);
+    int id = 0;
+    for (const string& text : {"funny pet and nasty rat"s,
+                               "funny pet with curly hair"s,
+                               "funny pet and not very nasty rat"s,
+                               "pet with rat and rat and rat"s,
+                               "nasty rat with curly hair"s,}) {
+        search_server.AddDocument(++id, text, DocumentStatus::ACTUAL, {1, 2});
+    }
+    const string query = "curly and funny -not"s;
+    {
+        const auto expected = search_server.FindTopDocuments(query);
+        TopDocumentsResult result = search_server.FindTopDocumentsAsync(query).get();
+        ASSERT(!result.is_partial);
+        ASSERT(result.documents.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQUAL(result.documents[i].id, expected[i].id);
+        }
+    }
+    {
+        CancellationToken token;
+        token.Cancel();
+        TopDocumentsResult result = search_server.FindTopDocumentsAsync(query, DocumentStatus::ACTUAL,
+                QueryBudget(chrono::hours(1), token)).get();
+        ASSERT(result.is_partial);
+        ASSERT(result.documents.empty());
+    }
+    {
+        TopDocumentsResult result = search_server.FindTopDocumentsAsync(query,
+                QueryBudget(QueryBudget::Clock::duration::zero())).get();
+        ASSERT(result.is_partial);
+    }
+    {
+        auto future = search_server.FindTopDocumentsAsync("curly --hair"s);
+        try {
+            future.get();
+            ASSERT_HINT(false, "Parse errors must be passed through the future"s);
+        }
+        catch (const invalid_argument&) {}
+    }
+}
+
+void TestQueryBudgetPartialScan()
+{
+    using namespace std;
+    SearchServer search_server;
+    const int document_count = 5000;
+    for (int id = 0; id < document_count; ++id) {
+        string text = "common"s;
+        for (int i = 0; i < id * 7919 % 13; ++i) { text += " filler"s; }
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, {id % 11});
+    }
+    //Бюджет кончается после 1000 проверенных записей постинга: токен отменяет сам предикат
+    CancellationToken token;
+    int checked_count = 0;
+    auto predicate = [&token, &checked_count](int, DocumentStatus, int) {
+        if (++checked_count == 1000) { token.Cancel(); }
+        return true;
+    };
+    const TopDocumentsResult result = search_server.FindTopDocuments(execution::seq, "common"s, predicate,
+            QueryBudget(chrono::hours(1), token));
+    ASSERT(result.is_partial);
+    //Отмена замечается на границе блока постинга
+    ASSERT(checked_count >= 1000 && checked_count < 1000 + static_cast<int>(POSTING_BLOCK_SIZE));
+    //Документы добавлены по порядку, поэтому просмотрены ровно id из [0, checked_count)
+    const int scanned_count = checked_count;
+    const auto expected = search_server.FindTopDocuments(execution::seq, "common"s,
+            [scanned_count](int document_id, DocumentStatus, int) { return document_id < scanned_count; });
+    ASSERT(!result.documents.empty());
+    ASSERT(result.documents.size() == expected.size());
+    for (size_t i = 0; i < min(result.documents.size(), expected.size()); ++i) {
+        ASSERT_EQUAL(result.documents[i].id, expected[i].id);
+        ASSERT(result.documents[i].relevance == expected[i].relevance);
+        ASSERT(i == 0 || result.documents[i - 1].relevance >= result.documents[i].relevance);
+    }
+}
+
+void TestProfileSnapshot()
+{
+    using namespace std;
+#ifndef SEARCH_SERVER_DISABLE_PROFILING
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    
+    ResetProfile();
+    search_server.FindTopDocuments("curly funny -nasty"s);
+    search_server.FindTopDocuments("curly hair"s);
+    search_server.MatchDocument("curly hair"s, 2);
+    
+    const auto snapshot = GetProfileSnapshot();
+    auto find_stage = [&snapshot](ProfileStage parent, ProfileStage stage) -> const StageProfile* {
+        for (const StageProfile& profile : snapshot) {
+            if (profile.parent == parent && profile.stage == stage) { return &profile; }
+        }
+        return nullptr;
+    };
+    const StageProfile* find_top = find_stage(ProfileStage::NONE, ProfileStage::FIND_TOP_DOCUMENTS);
+    ASSERT(find_top != nullptr);
+    ASSERT_EQUAL(find_top->count, 2);
+    ASSERT(find_top->GetPercentileNs(50) <= find_top->max_ns);
+    for (ProfileStage stage : {ProfileStage::PARSE, ProfileStage::SCORE, ProfileStage::MINUS_WORDS,
+                               ProfileStage::COLLECT, ProfileStage::TOP_K}) {
+        const StageProfile* profile = find_stage(ProfileStage::FIND_TOP_DOCUMENTS, stage);
+        ASSERT_HINT(profile != nullptr, string(GetProfileStageName(stage)));
+        ASSERT_EQUAL(profile->count, 2);
+        ASSERT(profile->total_ns <= find_top->total_ns);
+    }
+    const StageProfile* match_parse = find_stage(ProfileStage::MATCH_DOCUMENT, ProfileStage::PARSE);
+    ASSERT(match_parse != nullptr);
+    ASSERT_EQUAL(match_parse->count, 1);
+    
+    //Профиль завершившегося потока освобождается, а его данные остаются в снимке
+    const size_t active_count = GetActiveProfileCount();
+    for (int i = 0; i < 20; ++i) {
+        thread([&search_server]() { search_server.FindTopDocuments("curly hair"s); }).join();
+    }
+    ASSERT(GetActiveProfileCount() == active_count);
+    const auto after_threads = GetProfileSnapshot();
+    const auto find_top_after = find_if(after_threads.begin(), after_threads.end(), [](const StageProfile& profile) {
+        return profile.parent == ProfileStage::NONE && profile.stage == ProfileStage::FIND_TOP_DOCUMENTS;
+    });
+    ASSERT(find_top_after != after_threads.end());
+    ASSERT_EQUAL(find_top_after->count, 22);
+#endif
+}
+
+void TestQueryStats()
+{
+    using namespace std;
+    SearchServer search_server("and with"s);
+    int id = 0;
+    for (const string& text : {"funny pet and nasty rat"s,
+                               "funny pet with curly hair"s,
+                               "funny pet and not very nasty rat"s,
+                               "pet with rat and rat and rat"s,
+                               "nasty rat with curly hair"s,}) {
+        search_server.AddDocument(++id, text, DocumentStatus::ACTUAL, {1, 2});
+    }
+    {
+        QueryStats stats;
+        const auto documents = search_server.FindTopDocuments(execution::seq, "curly funny -not unknown"s,
+                [](int document_id, [[maybe_unused]] DocumentStatus status, [[maybe_unused]] int rating) {
+                    return document_id != 2;
+                }, stats);
+        ASSERT_EQUAL(stats.plus_term_count, 3);
+        ASSERT_EQUAL(stats.minus_term_count, 1);
+        ASSERT_EQUAL(stats.terms.size(), 4);
+        //curly: 2, 5; funny: 1, 2, 3
+        ASSERT_EQUAL(stats.postings_scanned, 5);
+        ASSERT_EQUAL(stats.postings_skipped, 0);
+        ASSERT_EQUAL(stats.rejected_by_predicate, 2);
+        ASSERT_EQUAL(stats.removed_by_minus_words, 1);
+        ASSERT_EQUAL(stats.candidates_before_top_k, 2);
+        ASSERT(stats.result_count == documents.size());
+        ASSERT(!stats.is_partial);
+        ASSERT(stats.GetStageNs(ProfileStage::FIND_TOP_DOCUMENTS) >= stats.GetStageNs(ProfileStage::SCORE));
+    }
+    {
+        QueryStats stats;
+        const auto documents = search_server.FindTopDocuments(execution::seq, "curly hair"s, DocumentStatus::BANNED,
+                stats);
+        ASSERT(documents.empty());
+        ASSERT_EQUAL(stats.rejected_by_predicate, 4);
+    }
+    {
+        QueryStats stats;
+        const auto [words, status] = search_server.MatchDocument("curly hair -nasty"s, 2, stats);
+        ASSERT_EQUAL(words.size(), 2);
+        ASSERT_EQUAL(stats.plus_term_count, 2);
+        ASSERT_EQUAL(stats.minus_term_count, 1);
+        ASSERT_EQUAL(stats.result_count, 2);
+    }
+}
+
+void TestGetMemoryUsage()
+{
+    using namespace std;
+    SearchServer search_server("and with"s);
+    const auto empty_usage = search_server.GetMemoryUsage();
+    int id = 0;
+    for (const string& text : {"funny pet and nasty rat"s,
+                               "funny pet with curly hair"s,
+                               "funny pet and not very nasty rat"s,
+                               "pet with rat and rat and rat"s,
+                               "nasty rat with curly hair"s,}) {
+        search_server.AddDocument(++id, text, DocumentStatus::ACTUAL, {1, 2});
+    }
+    const auto usage = search_server.GetMemoryUsage();
+    ASSERT(usage.GetTotalBytes() > empty_usage.GetTotalBytes());
+    map<string_view, size_t> element_counts;
+    for (const StructureMemoryUsage& structure : usage.structures) {
+        element_counts[structure.name] = structure.element_count;
+    }
+    ASSERT_EQUAL(element_counts.at("stop_words_"sv), 2);
+    ASSERT_EQUAL(element_counts.at("words_"sv), 8);
+    ASSERT_EQUAL(element_counts.at("documents_"sv), 5);
+    ASSERT_EQUAL(element_counts.at("order_documents_id_"sv), 5);
+    //По записи на каждое уникальное слово документа
+    ASSERT_EQUAL(element_counts.at("word_to_document_freqs_"sv), 20);
+#ifndef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+    ASSERT_EQUAL(element_counts.at("document_term_ids_"sv), 20);
+#endif
+    //funny, pet, nasty, rat, curly, hair, not, very: длины 3, 4, 3, 4, 2, 2, 1, 1
+    ASSERT(usage.posting_length_histogram == vector<size_t>({2, 4, 2}));
+    
+    search_server.RemoveDocument(3);
+    const auto usage_after_remove = search_server.GetMemoryUsage();
+    ASSERT(usage_after_remove.GetTotalBytes() < usage.GetTotalBytes());
+    //Постинги not и very опустели и в гистограмму не попадают
+    ASSERT(usage_after_remove.posting_length_histogram == vector<size_t>({0, 6}));
+}
+
+void TestTermDictionary()
+{
+    using namespace std;
+    TermDictionary dictionary;
+    ASSERT(dictionary.Insert("cat"sv) == make_pair(0, true));
+    ASSERT(dictionary.Insert("dog"sv) == make_pair(1, true));
+    ASSERT(dictionary.Insert("cat"sv) == make_pair(0, false));
+    ASSERT_EQUAL(dictionary.Find("dog"sv), 1);
+    ASSERT_EQUAL(dictionary.Find("bird"sv), -1);
+    
+    const string_view cat = dictionary[0];
+    const string long_word(TermDictionary::CHUNK_SIZE, 'x');
+    const int long_word_id = dictionary.Insert(long_word).first;
+    for (int i = 0; i < 20'000; ++i) {
+        dictionary.Insert("word"s + to_string(i));
+    }
+    ASSERT(cat.data() == dictionary[0].data());
+    ASSERT(cat == "cat"sv);
+    ASSERT(dictionary.GetWord(long_word_id) == long_word);
+    ASSERT_EQUAL(dictionary.Find("word19999"sv), 20'002);
+    ASSERT_EQUAL(dictionary.size(), 20'003);
+    ASSERT(dictionary.GetArenaBytes() >= 2 * TermDictionary::CHUNK_SIZE);
+}
+
+void TestMemoryResource()
+{
+    using namespace std;
+    class CountingResource : public pmr::memory_resource
+    {
+    public:
+        size_t allocated_bytes = 0;
+        size_t deallocated_bytes = 0;
+    
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override
+        {
+            allocated_bytes += bytes;
+            return pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override
+        {
+            deallocated_bytes += bytes;
+            pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        
+        bool do_is_equal(const pmr::memory_resource& other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+    
+    const vector<string> texts{"funny pet and nasty rat"s,
+                               "funny pet with curly hair"s,
+                               "funny pet and not very nasty rat"s,
+                               "pet with rat and rat and rat"s,
+                               "nasty rat with curly hair"s,};
+    const string query = "curly and funny -not"s;
+    SearchServer default_server("and with"s);
+    int id = 0;
+    for (const string& text : texts) {
+        default_server.AddDocument(++id, text, DocumentStatus::ACTUAL, {1, 2});
+    }
+    const auto expected = default_server.FindTopDocuments(query);
+    
+    CountingResource counting_resource;
+    {
+        SearchServer search_server("and with"s, &counting_resource);
+        ASSERT(search_server.GetMemoryResource() == &counting_resource);
+        id = 0;
+        for (const string& text : texts) {
+            search_server.AddDocument(++id, text, DocumentStatus::ACTUAL, {1, 2});
+        }
+        ASSERT(counting_resource.allocated_bytes > 0);
+        const auto documents = search_server.FindTopDocuments(query);
+        ASSERT(documents.size() == expected.size());
+        for (size_t i = 0; i < documents.size(); ++i) {
+            ASSERT_EQUAL(documents[i].id, expected[i].id);
+        }
+        search_server.RemoveDocument(2);
+    }
+    ASSERT(counting_resource.allocated_bytes == counting_resource.deallocated_bytes);
+    
+    pmr::monotonic_buffer_resource arena;
+    SearchServer arena_server(vector<string>{"and"s, "with"s}, &arena);
+    id = 0;
+    for (const string& text : texts) {
+        arena_server.AddDocument(++id, text, DocumentStatus::ACTUAL, {1, 2});
+    }
+    ASSERT(arena_server.FindTopDocuments(query).size() == expected.size());
+    
+    //Параллельное удаление на монотонном ресурсе совпадает с последовательным
+    arena_server.RemoveDocument(execution::par, 1);
+    default_server.RemoveDocument(1);
+    const auto arena_documents = arena_server.FindTopDocuments(query);
+    const auto default_documents = default_server.FindTopDocuments(query);
+    ASSERT(arena_documents.size() == default_documents.size());
+    for (size_t i = 0; i < arena_documents.size(); ++i) {
+        ASSERT_EQUAL(arena_documents[i].id, default_documents[i].id);
+        ASSERT(abs(arena_documents[i].relevance - default_documents[i].relevance) < ACCURACY_COMPARISON);
+    }
+}
+
+void TestShardedSearchServer()
+{
+    using namespace std;
+    mt19937 generator(7);
+    const auto dictionary = GenerateDictionary(generator, 300, 6);
+    ZipfWordSampler sampler(dictionary, 1.0);
+    const auto documents = GenerateZipfQueries(generator, sampler, 500, 20);
+    const auto queries = GenerateZipfQueries(generator, sampler, 50, 5, 0.2);
+    
+    SearchServer search_server(dictionary[0]);
+    ShardedSearchServer sharded_server(3, dictionary[0]);
+    ASSERT_EQUAL(sharded_server.GetShardCount(), 3);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const int id = static_cast<int>(i);
+        const DocumentStatus status = id % 5 ? DocumentStatus::ACTUAL : DocumentStatus::BANNED;
+        search_server.AddDocument(id, documents[i], status, {id % 7, -(id % 3)});
+        sharded_server.AddDocument(id, documents[i], status, {id % 7, -(id % 3)});
+    }
+    for (int id = 0; id < 500; id += 7) {
+        search_server.RemoveDocument(id);
+        sharded_server.RemoveDocument(id);
+    }
+    ASSERT_EQUAL(sharded_server.GetDocumentCount(), search_server.GetDocumentCount());
+    
+    auto assert_equal_documents = [](const vector<Document>& lhs, const vector<Document>& rhs) {
+        ASSERT(lhs.size() == rhs.size());
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            ASSERT_EQUAL(lhs[i].id, rhs[i].id);
+            ASSERT(lhs[i].relevance == rhs[i].relevance);
+            ASSERT_EQUAL(lhs[i].rating, rhs[i].rating);
+        }
+    };
+    for (const string& query : queries) {
+        assert_equal_documents(sharded_server.FindTopDocuments(query), search_server.FindTopDocuments(query));
+        assert_equal_documents(sharded_server.FindTopDocuments(query, DocumentStatus::BANNED),
+                search_server.FindTopDocuments(query, DocumentStatus::BANNED));
+        auto predicate = [](int document_id, [[maybe_unused]] DocumentStatus status, int rating) {
+            return document_id % 2 == 0 && rating > 0;
+        };
+        assert_equal_documents(sharded_server.FindTopDocuments(query, predicate),
+                search_server.FindTopDocuments(query, predicate));
+    }
+    {
+        const auto [sharded_words, sharded_status] = sharded_server.MatchDocument(queries[0], 11);
+        const auto [words, status] = search_server.MatchDocument(queries[0], 11);
+        ASSERT(sharded_words == words);
+        ASSERT(sharded_status == status);
+    }
+    //Ошибка запроса находится до рассылки, а ошибка одного шарда бросается, когда закончат все шарды
+    for (const string& query : {"cat --dog"s, "cat -"s}) {
+        bool is_thrown = false;
+        try {
+            sharded_server.FindTopDocuments(query);
+        }
+        catch (const invalid_argument&) {
+            is_thrown = true;
+        }
+        ASSERT_HINT(is_thrown, query);
+    }
+    bool is_thrown = false;
+    try {
+        sharded_server.FindTopDocuments(queries[0], [](int document_id, DocumentStatus, int) {
+            if (document_id % 3 == 0) { throw runtime_error("predicate"s); }
+            return true;
+        });
+    }
+    catch (const runtime_error&) {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    sharded_server.AddDocument(1000, documents[0], DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL(sharded_server.GetDocumentCount(), search_server.GetDocumentCount() + 1);
+    ASSERT(!sharded_server.FindTopDocuments(documents[0]).empty());
+}
+
+void TestShardCoordinator()
+{
+    using namespace std;
+    char directory_template[] = "/tmp/search-server-test-XXXXXX";
+    const string directory = mkdtemp(directory_template);
+    vector<string> socket_paths;
+    vector<unique_ptr<ShardNode>> nodes;
+    vector<thread> node_threads;
+    for (int i = 0; i < 3; ++i) {
+        socket_paths.push_back(directory + "/shard"s + to_string(i) + ".sock"s);
+        nodes.push_back(make_unique<ShardNode>(socket_paths.back(), "and with"s));
+        node_threads.emplace_back([&node = *nodes.back()]() { node.Run(); });
+    }
+    
+    {
+        mt19937 generator(11);
+        const auto dictionary = GenerateDictionary(generator, 200, 6);
+        ZipfWordSampler sampler(dictionary, 1.0);
+        const auto documents = GenerateZipfQueries(generator, sampler, 200, 15);
+        const auto queries = GenerateZipfQueries(generator, sampler, 30, 4, 0.2);
+        
+        SearchServer search_server("and with"s);
+        ShardCoordinator coordinator(socket_paths, chrono::seconds(10));
+        for (size_t i = 0; i < documents.size(); ++i) {
+            const int id = static_cast<int>(i);
+            const DocumentStatus status = id % 4 ? DocumentStatus::ACTUAL : DocumentStatus::IRRELEVANT;
+            search_server.AddDocument(id, documents[i], status, {id % 5, 1});
+            coordinator.AddDocument(id, documents[i], status, {id % 5, 1});
+        }
+        coordinator.RemoveDocument(3);
+        search_server.RemoveDocument(3);
+        ASSERT_EQUAL(coordinator.GetDocumentCount(), search_server.GetDocumentCount());
+        
+        for (const string& query : queries) {
+            for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT}) {
+                const TopDocumentsResult result = coordinator.FindTopDocuments(query, status);
+                const vector<Document> expected = search_server.FindTopDocuments(query, status);
+                ASSERT(!result.is_partial);
+                ASSERT(result.documents.size() == expected.size());
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    ASSERT_EQUAL(result.documents[i].id, expected[i].id);
+                    ASSERT(result.documents[i].relevance == expected[i].relevance);
+                    ASSERT_EQUAL(result.documents[i].rating, expected[i].rating);
+                }
+            }
+        }
+        
+        const auto [words, status] = coordinator.MatchDocument(queries[0], 5);
+        const auto [expected_words, expected_status] = search_server.MatchDocument(queries[0], 5);
+        ASSERT(words == vector<string>(expected_words.begin(), expected_words.end()));
+        ASSERT(status == expected_status);
+        
+        //Ошибки узла превращаются в исключения того же типа
+        bool is_thrown = false;
+        try {
+            coordinator.AddDocument(5, "duplicate"s, DocumentStatus::ACTUAL, {});
+        }
+        catch (const invalid_argument&) {
+            is_thrown = true;
+        }
+        ASSERT_HINT(is_thrown, "Duplicate document ID must be reported by the shard"s);
+    }
+    
+    {
+        //Узел, который принимает соединения, но никогда не отвечает
+        const string silent_path = directory + "/silent.sock"s;
+        const int silent_fd = ListenUnixSocket(silent_path);
+        ShardCoordinator coordinator({socket_paths[1], silent_path}, chrono::milliseconds(200));
+        const TopDocumentsResult result = coordinator.FindTopDocuments("cat"s);
+        ASSERT(result.is_partial);
+        
+        //Запрос, ждущий занятое соединение, не ждёт дольше своего крайнего срока
+        ShardClient client(silent_path);
+        BinaryWriter request;
+        request.WriteUint8(static_cast<uint8_t>(ShardRequestType::GET_DOCUMENT_COUNT));
+        thread busy_caller([&client, &request]() {
+            try {
+                client.Call(request.GetBuffer(), ShardClock::now() + chrono::milliseconds(600));
+            }
+            catch (const ShardIoError&) {}
+        });
+        this_thread::sleep_for(chrono::milliseconds(50));
+        const auto start = ShardClock::now();
+        bool is_timed_out = false;
+        try {
+            client.Call(request.GetBuffer(), start + chrono::milliseconds(100));
+        }
+        catch (const ShardTimeoutError&) {
+            is_timed_out = true;
+        }
+        ASSERT(is_timed_out);
+        ASSERT(ShardClock::now() - start < chrono::milliseconds(400));
+        busy_caller.join();
+        close(silent_fd);
+        unlink(silent_path.c_str());
+    }
+    
+    {
+        //Число элементов из испорченного кадра не вызывает выделения памяти больше самого кадра
+        BinaryWriter writer;
+        writer.WriteUint32(1u << 30);
+        writer.WriteInt32(1);
+        BinaryReader reader(writer.GetBuffer());
+        bool is_thrown = false;
+        try {
+            ReadDocuments(reader);
+        }
+        catch (const ShardIoError&) {
+            is_thrown = true;
+        }
+        ASSERT(is_thrown);
+    }
+    
+    {
+        //Слово, появившееся на шарде после сбора статистики, не влияет на релевантность и не ломает запрос
+        SearchServer shard_server;
+        shard_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+        shard_server.AddDocument(2, "dog fish"s, DocumentStatus::ACTUAL, {1});
+        CorpusStatistics corpus;
+        corpus.document_count = 4;
+        corpus.document_freqs.emplace("dog"s, 2);
+        ASSERT(corpus.ComputeInverseDocumentFreq("cat"sv) == 0.0);
+        const auto documents = shard_server.FindTopDocuments(execution::seq, "cat dog"s,
+                [](int, DocumentStatus, int) { return true; }, corpus);
+        ASSERT(documents.size() == 2u);
+        ASSERT(documents[0].relevance == documents[1].relevance);
+    }
+    
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i]->Stop();
+        node_threads[i].join();
+    }
+    nodes.clear();
+    rmdir(directory.c_str());
+}
+
+void TestSearchFrontEnd()
+{
+    using namespace std;
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2, 3});
+    search_server.AddDocument(3, "big cat nasty hair"s, DocumentStatus::ACTUAL, {1, 2, 8});
+    
+    auto read_lines = [](int fd, size_t line_count) {
+        string input;
+        char buffer[4096];
+        while (static_cast<size_t>(count(input.begin(), input.end(), '\n')) < line_count) {
+            const ssize_t result = read(fd, buffer, sizeof(buffer));
+            ASSERT(result > 0);
+            input.append(buffer, static_cast<size_t>(result));
+        }
+        return input;
+    };
+#ifndef SEARCH_SERVER_DISABLE_PROFILING
+    auto get_serve_count = []() {
+        uint64_t count = 0;
+        for (const StageProfile& profile : GetProfileSnapshot()) {
+            if (profile.stage == ProfileStage::SERVE_REQUEST) { count += profile.count; }
+        }
+        return count;
+    };
+    const uint64_t serve_count_before = get_serve_count();
+#endif
+    
+    char directory_template[] = "/tmp/search-server-test-XXXXXX";
+    const string directory = mkdtemp(directory_template);
+    const string socket_path = directory + "/front_end.sock"s;
+    SearchFrontEnd front_end(search_server, 2);
+    front_end.ListenUnix(socket_path);
+    const uint16_t port = front_end.ListenTcp("127.0.0.1"s, 0);
+    ASSERT(port != 0);
+    thread server_thread([&front_end]() { front_end.Run(); });
+    
+    {
+        //Несколько запросов одной записью, в том числе некорректный и с окончанием \r\n
+        const int fd = ConnectUnixSocket(socket_path);
+        const string request = "funny pet\ncat --hair\nnasty -rat\r\ncurly"s;
+        ASSERT(write(fd, request.data(), request.size()) == static_cast<ssize_t>(request.size()));
+        const string input = read_lines(fd, 3);
+        ASSERT(input.substr(0, input.find('\n') + 1)
+                == SearchFrontEnd::FormatDocuments(search_server.FindTopDocuments("funny pet"s)));
+        const size_t second_end = input.find('\n', input.find('\n') + 1);
+        ASSERT(input.compare(input.find('\n') + 1, 6, "ERROR "s) == 0);
+        ASSERT(input.substr(second_end + 1)
+                == SearchFrontEnd::FormatDocuments(search_server.FindTopDocuments("nasty -rat"s)));
+        //Незавершённая строка выполняется после получения перевода строки
+        ASSERT(write(fd, "\n", 1) == 1);
+        ASSERT(read_lines(fd, 1) == SearchFrontEnd::FormatDocuments(search_server.FindTopDocuments("curly"s)));
+        close(fd);
+    }
+    {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+        ASSERT(connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+        const string request = "hair\n"s;
+        ASSERT(write(fd, request.data(), request.size()) == static_cast<ssize_t>(request.size()));
+        ASSERT(read_lines(fd, 1) == SearchFrontEnd::FormatDocuments(search_server.FindTopDocuments("hair"s)));
+        close(fd);
+    }
+    {
+        //Строка без перевода строки длиннее лимита: фронтенд отвечает ошибкой и закрывает соединение,
+        //не дочитывая остальное
+        const int fd = ConnectUnixSocket(socket_path);
+        thread writer([fd]() {
+            const string chunk(64 * 1024, 'a');
+            for (int i = 0; i < 64; ++i) {
+                if (send(fd, chunk.data(), chunk.size(), MSG_NOSIGNAL) < 0) { break; }
+            }
+        });
+        const string input = read_lines(fd, 1);
+        ASSERT(input.compare(0, 6, "ERROR "s) == 0);
+        //После ошибки соединение закрыто: чтение доходит до конца потока
+        char buffer[4096];
+        while (read(fd, buffer, sizeof(buffer)) > 0) {}
+        shutdown(fd, SHUT_RDWR);
+        writer.join();
+        close(fd);
+    }
+    {
+        //Клиент отправляет запросы и не читает ответы: фронтенд перестаёт читать соединение,
+        //а когда ответы прочитаны, отвечает на все запросы по порядку
+        const int fd = ConnectUnixSocket(socket_path);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        const string query = "funny pet\n"s;
+        string requests;
+        for (int i = 0; i < 4096; ++i) {
+            requests += query;
+        }
+        size_t sent = 0;
+        while (sent < 64u * 1024 * 1024) {
+            const ssize_t result = send(fd, requests.data() + sent % requests.size(),
+                    requests.size() - sent % requests.size(), MSG_NOSIGNAL);
+            if (result > 0) {
+                sent += static_cast<size_t>(result);
+                continue;
+            }
+            ASSERT(result < 0 && errno == EAGAIN);
+            pollfd poll_fd{fd, POLLOUT, 0};
+            if (poll(&poll_fd, 1, 500) > 0) { continue; }
+            //Фронтенд мог быть занят пакетом: после ответа другому клиенту он точно прошёл цикл событий
+            const int probe_fd = ConnectUnixSocket(socket_path);
+            ASSERT(write(probe_fd, "hair\n", 5) == 5);
+            ASSERT(read_lines(probe_fd, 1) == SearchFrontEnd::FormatDocuments(search_server.FindTopDocuments("hair"s)));
+            close(probe_fd);
+            if (poll(&poll_fd, 1, 500) == 0) { break; }
+        }
+        ASSERT_HINT(sent < 64u * 1024 * 1024, "Front end must stop reading a client that does not read"s);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+        //Последняя строка могла уйти не целиком: её конец дописывается, пока читаются ответы
+        const string rest = query.substr(sent % query.size() == 0 ? query.size() : sent % query.size());
+        thread writer([fd, &rest]() {
+            ASSERT(send(fd, rest.data(), rest.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(rest.size()));
+        });
+        const size_t query_count = (sent + query.size() - 1) / query.size();
+        const string expected = SearchFrontEnd::FormatDocuments(search_server.FindTopDocuments("funny pet"s));
+        string input;
+        size_t line_count = 0;
+        vector<char> buffer(1 << 16);
+        while (line_count < query_count) {
+            const ssize_t result = read(fd, buffer.data(), buffer.size());
+            ASSERT(result > 0);
+            input.append(buffer.data(), static_cast<size_t>(result));
+            size_t begin = 0;
+            for (size_t end = input.find('\n'); end != string::npos; end = input.find('\n', begin)) {
+                ASSERT(input.compare(begin, end + 1 - begin, expected) == 0);
+                ++line_count;
+                begin = end + 1;
+            }
+            input.erase(0, begin);
+        }
+        writer.join();
+        ASSERT(line_count == query_count);
+        close(fd);
+    }
+    
+    front_end.Stop();
+    server_thread.join();
+#ifndef SEARCH_SERVER_DISABLE_PROFILING
+    ASSERT(get_serve_count() >= serve_count_before + 5);
+#endif
+    ASSERT(SearchFrontEnd::FormatDocuments({{2, 0.5, 2}}) == "1 2 0.5 2\n"s);
+    rmdir(directory.c_str());
+}
+
+void TestConcurrentSearchServer()
+{
+    using namespace std;
+    const int document_count = 300;
+    ConcurrentSearchServer search_server("and with"s);
+    atomic_bool is_writing = true;
+    vector<thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back([&search_server, &is_writing, document_count]() {
+            int last_count = 0;
+            bool is_removing = false;
+            while (is_writing) {
+                search_server.Read([&last_count, &is_removing, document_count](const SearchServer& server) {
+                    //Версия не меняется, пока закреплена, и не откатывается назад:
+                    //число документов сначала только растёт, затем только убывает
+                    const int count = server.GetDocumentCount();
+                    is_removing = is_removing || count < last_count;
+                    ASSERT(is_removing ? count <= last_count && count >= document_count / 2 : count >= last_count);
+                    const auto documents = server.FindTopDocuments("common"s);
+                    ASSERT(documents.size() == min<size_t>(count, MAX_RESULT_DOCUMENT_COUNT));
+                    ASSERT_EQUAL(server.GetDocumentCount(), count);
+                    last_count = count;
+                });
+            }
+        });
+    }
+    for (int id = 0; id < document_count; ++id) {
+        search_server.AddDocument(id, "common word"s + to_string(id), DocumentStatus::ACTUAL, {id});
+    }
+    for (int id = 0; id < document_count; id += 2) {
+        search_server.RemoveDocument(id);
+    }
+    is_writing = false;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    
+    //Ошибочное изменение не затрагивает ни одну из копий
+    bool is_thrown = false;
+    try {
+        search_server.AddDocument(document_count, "common bad\x12word"s, DocumentStatus::ACTUAL, {});
+    }
+    catch (const invalid_argument&) {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    //Каждое изменение переключает активную копию, поэтому проверяем обе
+    for (int i = 0; i < 2; ++i) {
+        search_server.AddDocument(document_count + 1 + i, "rare"s, DocumentStatus::ACTUAL, {});
+        ASSERT_EQUAL(search_server.GetDocumentCount(), document_count / 2 + 1 + i);
+        ASSERT_EQUAL(search_server.FindTopDocuments("common"s).front().id, document_count - 1);
+        ASSERT(search_server.FindTopDocuments("bad"s).empty());
+        const auto [words, status] = search_server.MatchDocument("common word1"s, 1);
+        ASSERT(words == vector<string>({"common"s, "word1"s}));
+    }
+}
+
+void TestPrefixQueries()
+{
+    using namespace std;
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "cat catalog dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "category fish"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(3, "dog doghouse"s, DocumentStatus::ACTUAL, {3});
+    search_server.AddDocument(4, "caterpillar"s, DocumentStatus::ACTUAL, {4});
+    
+    {
+        //Слова с префиксом оцениваются как одно слово: документ 1 содержит два таких слова
+        const auto documents = search_server.FindTopDocuments("cat*"s);
+        ASSERT(documents.size() == 3u);
+        ASSERT_EQUAL(documents[0].id, 4);
+        ASSERT_EQUAL(documents[1].id, 1);
+        ASSERT_EQUAL(documents[2].id, 2);
+        ASSERT(abs(documents[0].relevance - log(4.0 / 3)) < ACCURACY_COMPARISON);
+        ASSERT(abs(documents[1].relevance - 2.0 / 3 * log(4.0 / 3)) < ACCURACY_COMPARISON);
+    }
+    {
+        const auto documents = search_server.FindTopDocuments("dog -cat*"s);
+        ASSERT(documents.size() == 1u);
+        ASSERT_EQUAL(documents[0].id, 3);
+        const auto par_documents = search_server.FindTopDocuments(execution::par, "dog -cat*"s);
+        ASSERT(par_documents.size() == 1u);
+        ASSERT_EQUAL(par_documents[0].id, 3);
+        ASSERT(search_server.FindTopDocuments("dogs*"s).empty());
+    }
+    {
+        const auto seq_documents = search_server.FindTopDocuments("cat* fish -doghouse"s);
+        const auto par_documents = search_server.FindTopDocuments(execution::par, "cat* fish -doghouse"s);
+        ASSERT(seq_documents.size() == par_documents.size());
+        for (size_t i = 0; i < seq_documents.size(); ++i) {
+            ASSERT_EQUAL(seq_documents[i].id, par_documents[i].id);
+            ASSERT(abs(seq_documents[i].relevance - par_documents[i].relevance) < ACCURACY_COMPARISON);
+        }
+    }
+    {
+        const auto [words, status] = search_server.MatchDocument("cat* fish"s, 1);
+        ASSERT(words == vector<string_view>({"cat"sv, "catalog"sv}));
+        const auto [par_words, par_status] = search_server.MatchDocument(execution::par, "fish cat*"s, 2);
+        ASSERT(par_words == vector<string_view>({"category"sv, "fish"sv}));
+        ASSERT(get<0>(search_server.MatchDocument("dog -cat*"s, 1)).empty());
+        ASSERT(get<0>(search_server.MatchDocument(execution::par, "dog -cat*"s, 1)).empty());
+    }
+    {
+        //Одиночная звёздочка - обычное слово, а не пустой префикс
+        SearchServer star_server(""s);
+        star_server.AddDocument(1, "cat * dog"s, DocumentStatus::ACTUAL, {1});
+        star_server.AddDocument(2, "cat"s, DocumentStatus::ACTUAL, {2});
+        const auto documents = star_server.FindTopDocuments("*"s);
+        ASSERT(documents.size() == 1u);
+        ASSERT_EQUAL(documents[0].id, 1);
+        ASSERT(star_server.FindTopDocuments("cat -*"s).size() == 1u);
+        ASSERT(get<0>(star_server.MatchDocument("cat *"s, 1)) == vector<string_view>({"*"sv, "cat"sv}));
+    }
+    
+    //Раскрытие плюс-слова ограничено MAX_PREFIX_EXPANSION_COUNT словами
+    SearchServer wide_server(""s);
+    const int word_count = static_cast<int>(MAX_PREFIX_EXPANSION_COUNT) + 10;
+    for (int id = 0; id < word_count; ++id) {
+        wide_server.AddDocument(id, "w"s + to_string(1000 + id), DocumentStatus::ACTUAL, {});
+    }
+    QueryStats stats;
+    wide_server.FindTopDocuments(execution::seq, "w*"s, DocumentStatus::ACTUAL, stats);
+    ASSERT(stats.terms.size() == 1u);
+    ASSERT(stats.terms[0].word == "w*"s);
+    ASSERT(stats.terms[0].posting_length == MAX_PREFIX_EXPANSION_COUNT);
+    ASSERT(stats.postings_scanned == MAX_PREFIX_EXPANSION_COUNT);
+    ASSERT(wide_server.FindTopDocuments("-w* w1000"s).empty());
+    
+    //Глобальный IDF слова с префиксом совпадает у шардированного и обычного сервера
+    ShardedSearchServer sharded_server(2, "and with"s);
+    sharded_server.AddDocument(1, "cat catalog dog"s, DocumentStatus::ACTUAL, {1});
+    sharded_server.AddDocument(2, "category fish"s, DocumentStatus::ACTUAL, {2});
+    sharded_server.AddDocument(3, "dog doghouse"s, DocumentStatus::ACTUAL, {3});
+    sharded_server.AddDocument(4, "caterpillar"s, DocumentStatus::ACTUAL, {4});
+    const auto sharded_documents = sharded_server.FindTopDocuments("cat* dog"s);
+    const auto expected_documents = search_server.FindTopDocuments("cat* dog"s);
+    ASSERT(sharded_documents.size() == expected_documents.size());
+    for (size_t i = 0; i < expected_documents.size(); ++i) {
+        ASSERT_EQUAL(sharded_documents[i].id, expected_documents[i].id);
+        ASSERT(sharded_documents[i].relevance == expected_documents[i].relevance);
+    }
+    
+    //При достижении лимита раскрытия каждый шард берёт свои первые слова, и выдача расходится с одним сервером:
+    //один сервер раскрывает "p*" в p000-p063 из документов с чётными id, нечётный шард - в p064-p099
+    SearchServer single_server;
+    ShardedSearchServer wide_sharded_server(2, ""s);
+    for (int i = 0; i < 100; ++i) {
+        const int id = i < 64 ? 2 * i : 2 * i + 1;
+        const string word = (i < 10 ? "p00"s : "p0"s) + to_string(i);
+        single_server.AddDocument(id, word, DocumentStatus::ACTUAL, {id % 2 ? 10 : 1});
+        wide_sharded_server.AddDocument(id, word, DocumentStatus::ACTUAL, {id % 2 ? 10 : 1});
+    }
+    for (int id = 200; id < 300; ++id) {
+        single_server.AddDocument(id, "filler"s, DocumentStatus::ACTUAL, {1});
+        wide_sharded_server.AddDocument(id, "filler"s, DocumentStatus::ACTUAL, {1});
+    }
+    const auto single_documents = single_server.FindTopDocuments("p*"s);
+    const auto wide_sharded_documents = wide_sharded_server.FindTopDocuments("p*"s);
+    ASSERT(!single_documents.empty() && !wide_sharded_documents.empty());
+    ASSERT(none_of(single_documents.begin(), single_documents.end(),
+            [](const Document& document) { return document.id % 2 == 1; }));
+    ASSERT(all_of(wide_sharded_documents.begin(), wide_sharded_documents.end(),
+            [](const Document& document) { return document.id % 2 == 1; }));
+    ASSERT(wide_sharded_documents[0].relevance != single_documents[0].relevance);
+}
+
+void TestFuzzyQueries()
+{
+    using namespace std;
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cart fish"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(3, "dog house"s, DocumentStatus::ACTUAL, {3});
+    search_server.AddDocument(4, "cast"s, DocumentStatus::ACTUAL, {4});
+    search_server.AddDocument(5, "bird"s, DocumentStatus::ACTUAL, {5});
+    
+    {
+        //Каждая правка умножает релевантность на штраф
+        const auto documents = search_server.FindTopDocuments("cat~1"s);
+        ASSERT(documents.size() == 3u);
+        ASSERT_EQUAL(documents[0].id, 1);
+        ASSERT_EQUAL(documents[1].id, 4);
+        ASSERT_EQUAL(documents[2].id, 2);
+        ASSERT(abs(documents[0].relevance - log(5.0)) < ACCURACY_COMPARISON);
+        ASSERT(abs(documents[1].relevance - DEFAULT_FUZZY_PENALTY * log(5.0)) < ACCURACY_COMPARISON);
+        ASSERT(abs(documents[2].relevance - 0.5 * DEFAULT_FUZZY_PENALTY * log(5.0)) < ACCURACY_COMPARISON);
+        ASSERT(search_server.FindTopDocuments("cat~0"s).size() == 1u);
+        ASSERT(search_server.FindTopDocuments("cat~"s).size() == 3u);
+        ASSERT(search_server.FindTopDocuments("dig~2"s).size() == 1u);
+    }
+    {
+        const auto seq_documents = search_server.FindTopDocuments("cat~1 hose~1 -fish"s);
+        const auto par_documents = search_server.FindTopDocuments(execution::par, "cat~1 hose~1 -fish"s);
+        ASSERT(seq_documents.size() == 3u);
+        ASSERT(seq_documents.size() == par_documents.size());
+        for (size_t i = 0; i < seq_documents.size(); ++i) {
+            ASSERT_EQUAL(seq_documents[i].id, par_documents[i].id);
+            ASSERT(abs(seq_documents[i].relevance - par_documents[i].relevance) < ACCURACY_COMPARISON);
+        }
+        ASSERT(search_server.FindTopDocuments("house -dug~1"s).empty());
+        ASSERT(search_server.FindTopDocuments(execution::par, "house -dug~1"s).empty());
+    }
+    {
+        const auto [words, status] = search_server.MatchDocument("cat~1 fish"s, 2);
+        ASSERT(words == vector<string_view>({"cart"sv, "fish"sv}));
+        const auto [par_words, par_status] = search_server.MatchDocument(execution::par, "fish cat~1"s, 2);
+        ASSERT(par_words == vector<string_view>({"cart"sv, "fish"sv}));
+        ASSERT(get<0>(search_server.MatchDocument("cart -cat~1"s, 2)).empty());
+        ASSERT(get<0>(search_server.MatchDocument(execution::par, "cart -cat~1"s, 2)).empty());
+    }
+    {
+        search_server.SetFuzzyPenalty(1.0);
+        const auto documents = search_server.FindTopDocuments("cat~1"s);
+        ASSERT(abs(documents[0].relevance - documents[1].relevance) < ACCURACY_COMPARISON);
+        search_server.SetFuzzyPenalty(DEFAULT_FUZZY_PENALTY);
+        bool is_thrown = false;
+        try {
+            search_server.SetFuzzyPenalty(0.0);
+        }
+        catch (const invalid_argument&) {
+            is_thrown = true;
+        }
+        ASSERT_HINT(is_thrown, "Fuzzy penalty must be positive"s);
+    }
+    for (const string& query : {"cat~3"s, "cat~10"s, "-cat~5"s}) {
+        bool is_thrown = false;
+        try {
+            search_server.FindTopDocuments(query);
+        }
+        catch (const invalid_argument&) {
+            is_thrown = true;
+        }
+        ASSERT_HINT(is_thrown, "Invalid fuzzy word must be rejected"s);
+    }
+    //Тильда с нецифровым суффиксом - часть слова
+    ASSERT(search_server.FindTopDocuments("cat~x"s).empty());
+    {
+        //Одиночная тильда и тильда в начале слова - обычные слова
+        SearchServer tilde_server(""s);
+        tilde_server.AddDocument(1, "cat ~ dog"s, DocumentStatus::ACTUAL, {1});
+        tilde_server.AddDocument(2, "cat ~1"s, DocumentStatus::ACTUAL, {2});
+        const auto documents = tilde_server.FindTopDocuments("~"s);
+        ASSERT(documents.size() == 1u);
+        ASSERT_EQUAL(documents[0].id, 1);
+        const auto minus_documents = tilde_server.FindTopDocuments("cat -~1"s);
+        ASSERT(minus_documents.size() == 1u);
+        ASSERT_EQUAL(minus_documents[0].id, 1);
+    }
+    
+    //Раскрытие совпадает с перебором всех слов индекса
+    auto levenshtein = [](const string& lhs, const string& rhs) {
+        vector<int> row(rhs.size() + 1);
+        iota(row.begin(), row.end(), 0);
+        for (size_t i = 1; i <= lhs.size(); ++i) {
+            int diagonal = row[0];
+            row[0] = static_cast<int>(i);
+            for (size_t j = 1; j <= rhs.size(); ++j) {
+                const int above = row[j];
+                row[j] = min({row[j] + 1, row[j - 1] + 1, diagonal + (lhs[i - 1] != rhs[j - 1])});
+                diagonal = above;
+            }
+        }
+        return row.back();
+    };
+    SearchServer word_server(""s);
+    vector<string> words;
+    mt19937 generator(7);
+    for (int id = 0; id < 2000; ++id) {
+        string word(uniform_int_distribution<int>(1, 6)(generator), 'a');
+        for (char& c : word) {
+            c = static_cast<char>('a' + uniform_int_distribution<int>(0, 3)(generator));
+        }
+        words.push_back(word);
+        word_server.AddDocument(id, word, DocumentStatus::ACTUAL, {});
+    }
+    for (const string& word : {"abc"s, "dd"s, "abcdab"s}) {
+        for (int distance = 0; distance <= MAX_FUZZY_DISTANCE; ++distance) {
+            set<string> expected_words;
+            size_t expected_postings = 0;
+            for (const string& document_word : words) {
+                if (levenshtein(word, document_word) <= distance) {
+                    expected_words.insert(document_word);
+                    ++expected_postings;
+                }
+            }
+            if (expected_words.size() > MAX_FUZZY_EXPANSION_COUNT) { continue; }
+            QueryStats stats;
+            word_server.FindTopDocuments(execution::seq, word + '~' + to_string(distance), DocumentStatus::ACTUAL,
+                    stats);
+            ASSERT(stats.terms.size() == 1u);
+            ASSERT(stats.terms[0].posting_length == expected_postings);
+        }
+    }
+    
+    //Глобальный IDF найденных слов совпадает у шардированного и обычного сервера
+    ShardedSearchServer sharded_server(2, "and with"s);
+    sharded_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1});
+    sharded_server.AddDocument(2, "cart fish"s, DocumentStatus::ACTUAL, {2});
+    sharded_server.AddDocument(3, "dog house"s, DocumentStatus::ACTUAL, {3});
+    sharded_server.AddDocument(4, "cast"s, DocumentStatus::ACTUAL, {4});
+    sharded_server.AddDocument(5, "bird"s, DocumentStatus::ACTUAL, {5});
+    const auto sharded_documents = sharded_server.FindTopDocuments("cat~1 hose~1"s);
+    const auto expected_documents = search_server.FindTopDocuments("cat~1 hose~1"s);
+    ASSERT(sharded_documents.size() == expected_documents.size());
+    for (size_t i = 0; i < expected_documents.size(); ++i) {
+        ASSERT_EQUAL(sharded_documents[i].id, expected_documents[i].id);
+        ASSERT(abs(sharded_documents[i].relevance - expected_documents[i].relevance) < ACCURACY_COMPARISON);
+    }
+}
+
+void TestSearchAfterCursor()
+{
+    using namespace std;
+    SearchServer search_server("and with"s);
+    const int document_count = 23;
+    for (int id = 0; id < document_count; ++id) {
+        //Много документов с равной релевантностью, чтобы порядок определяли рейтинг и id
+        search_server.AddDocument(id, "cat"s + string(id % 4, 's') + " tail"s, DocumentStatus::ACTUAL, {id % 3});
+    }
+    search_server.AddDocument(100, "dog"s, DocumentStatus::BANNED, {});
+    
+    const string query = "cat catss tail"s;
+    //Страницы по курсору складываются в полную выдачу в порядке CompareByRelevance
+    SearchCursor cursor;
+    vector<Document> all_documents;
+    for (int page = 0;; ++page) {
+        const auto documents = search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, cursor, 4);
+        ASSERT(documents.size() <= 4u);
+        if (documents.empty()) { break; }
+        all_documents.insert(all_documents.end(), documents.begin(), documents.end());
+        cursor = SearchCursor::After(documents.back());
+    }
+    ASSERT_EQUAL(static_cast<int>(all_documents.size()), document_count);
+    ASSERT(is_sorted(all_documents.begin(), all_documents.end(), SearchServer::CompareByRelevance));
+    set<int> ids;
+    for (const Document& document : all_documents) {
+        ids.insert(document.id);
+    }
+    ASSERT_EQUAL(static_cast<int>(ids.size()), document_count);
+    //Первая страница совпадает с обычной выдачей
+    const auto top_documents = search_server.FindTopDocuments(query);
+    for (size_t i = 0; i < top_documents.size(); ++i) {
+        ASSERT_EQUAL(top_documents[i].id, all_documents[i].id);
+    }
+    
+    //Ленивые страницы: следующая запрашивается только при переходе к ней
+    int fetch_count = 0;
+    auto pages = PaginateByCursor([&](const SearchCursor& page_cursor, size_t page_size) {
+        ++fetch_count;
+        return search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, page_cursor, page_size);
+    }, 5);
+    auto it = pages.begin();
+    ASSERT_EQUAL(fetch_count, 1);
+    ASSERT((*it).size() == 5u);
+    ASSERT_EQUAL((*it)[0].id, all_documents[0].id);
+    ++it;
+    ASSERT_EQUAL(fetch_count, 2);
+    ASSERT_EQUAL(it->front().id, all_documents[5].id);
+    size_t page_count = 0;
+    size_t paged_document_count = 0;
+    for (const vector<Document>& page : pages) {
+        ++page_count;
+        paged_document_count += page.size();
+    }
+    ASSERT(page_count == 5u);
+    ASSERT_EQUAL(static_cast<int>(paged_document_count), document_count);
+    const auto banned_pages = PaginateByCursor([&](const SearchCursor& page_cursor, size_t page_size) {
+        return search_server.FindTopDocuments(execution::seq, "dog"s, DocumentStatus::ACTUAL, page_cursor, page_size);
+    }, 5);
+    ASSERT(banned_pages.begin() == banned_pages.end());
+    
+    //Paginate по итераторам без произвольного доступа
+    const list<int> values{1, 2, 3, 4, 5, 6, 7};
+    vector<size_t> page_sizes;
+    for (const auto& page : Paginate(values, 3)) {
+        page_sizes.push_back(distance(page.begin_it, page.end_it));
+    }
+    ASSERT(page_sizes == vector<size_t>({3u, 3u, 1u}));
+    const vector<int> empty_values;
+    const auto empty_pages = Paginate(empty_values, 3);
+    ASSERT_EQUAL(distance(empty_pages.begin(), empty_pages.end()), 1);
+    
+    bool is_thrown = false;
+    try {
+        search_server.FindTopDocuments(execution::seq, query, DocumentStatus::ACTUAL, SearchCursor(), 0);
+    }
+    catch (const invalid_argument&) {
+        is_thrown = true;
+    }
+    ASSERT_HINT(is_thrown, "Page size must be positive"s);
+}
+
+void TestCorpusLoader()
+{
+    using namespace std;
+    char directory_template[] = "/tmp/corpus-loader-test-XXXXXX";
+    const string directory = mkdtemp(directory_template);
+    const string path = directory + "/corpus.tsv"s;
+    {
+        ofstream output(path);
+        output << "1\tACTUAL\t1 2 3\tfluffy cat\n"s
+               << "\n"s
+               << "2\tBANNED\t\tcat with tail\r\n"s
+               << "3\tACTUAL\t-4\tdog"s;
+    }
+    SearchServer search_server("with"s);
+    const CorpusLoadStats stats = LoadCorpus(path, search_server);
+    ASSERT(stats.document_count == 3u);
+    ASSERT(stats.bytes > 0u);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 3);
+    const auto documents = search_server.FindTopDocuments("cat dog"s);
+    ASSERT(documents.size() == 2u);
+    ASSERT_EQUAL(documents[0].id, 3);
+    ASSERT_EQUAL(documents[0].rating, -4);
+    ASSERT_EQUAL(documents[1].rating, 2);
+    const auto [words, status] = search_server.MatchDocument("tail cat"s, 2);
+    ASSERT(words == vector<string_view>({"cat"sv, "tail"sv}));
+    ASSERT(status == DocumentStatus::BANNED);
+    
+    //Ошибочный корпус не меняет сервер
+    for (const string& text : {"4\tACTUAL\t1\tnew\n4\tACTUAL\t1\tnew\n"s, "4\tNEW\t1\tnew\n"s,
+            "4\tACTUAL\t1 x\tnew\n"s, "4\tACTUAL\tnew\n"s, "1\tACTUAL\t\tnew\n"s,
+            "4\tACTUAL\t1\tnew\tword\n"s}) {
+        {
+            ofstream output(path);
+            output << text;
+        }
+        bool is_thrown = false;
+        try {
+            LoadCorpus(path, search_server);
+        }
+        catch (const invalid_argument&) {
+            is_thrown = true;
+        }
+        ASSERT_HINT(is_thrown, "Invalid corpus must be rejected"s);
+        ASSERT_EQUAL(search_server.GetDocumentCount(), 3);
+    }
+    remove(path.c_str());
+    bool is_thrown = false;
+    try {
+        LoadCorpus(path, search_server);
+    }
+    catch (const runtime_error&) {
+        is_thrown = true;
+    }
+    ASSERT_HINT(is_thrown, "Missing corpus file must be reported"s);
+    rmdir(directory.c_str());
+    
+    //Разбиение на части не меняет записи, а пакетное добавление даёт тот же индекс
+    string corpus;
+    mt19937 generator(3);
+    const auto dictionary = GenerateDictionary(generator, 1000, 8);
+    vector<string> texts;
+    for (int id = 0; corpus.size() < 3 * 1024 * 1024; ++id) {
+        texts.push_back(GenerateQuery(generator, dictionary, 20));
+        corpus += FormatCorpusRecord({id, DocumentStatus::ACTUAL, {id % 10}, texts.back()});
+    }
+    const auto single_chunk = ParseCorpus(corpus, 1);
+    const auto many_chunks = ParseCorpus(corpus, 8);
+    ASSERT(single_chunk.size() == texts.size());
+    ASSERT(many_chunks.size() == texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) {
+        ASSERT_EQUAL(many_chunks[i].id, static_cast<int>(i));
+        ASSERT(many_chunks[i].text == texts[i]);
+        ASSERT(many_chunks[i].ratings == single_chunk[i].ratings);
+    }
+    //Ошибка в первой части: остальные части ещё разбираются, и файл отображён, пока они не закончатся
+    {
+        char bad_directory_template[] = "/tmp/corpus-loader-test-XXXXXX";
+        const string bad_directory = mkdtemp(bad_directory_template);
+        const string bad_path = bad_directory + "/corpus.tsv"s;
+        {
+            ofstream output(bad_path);
+            output << "x\tACTUAL\t\tbad\n"s << corpus;
+        }
+        string message;
+        try {
+            LoadCorpus(bad_path, search_server);
+        }
+        catch (const invalid_argument& error) {
+            message = error.what();
+        }
+        ASSERT_HINT(message.find("offset 0:"s) != string::npos, message);
+        ASSERT_EQUAL(search_server.GetDocumentCount(), 3);
+        remove(bad_path.c_str());
+        rmdir(bad_directory.c_str());
+    }
+    SearchServer bulk_server(""s);
+    bulk_server.AddDocuments(execution::par, many_chunks);
+    SearchServer single_server(""s);
+    for (size_t i = 0; i < texts.size(); ++i) {
+        single_server.AddDocument(static_cast<int>(i), texts[i], DocumentStatus::ACTUAL, {static_cast<int>(i % 10)});
+    }
+    for (const string& query : GenerateQueries(generator, dictionary, 20, 5)) {
+        const auto bulk_documents = bulk_server.FindTopDocuments(query);
+        const auto single_documents = single_server.FindTopDocuments(query);
+        ASSERT(bulk_documents.size() == single_documents.size());
+        for (size_t i = 0; i < bulk_documents.size(); ++i) {
+            ASSERT_EQUAL(bulk_documents[i].id, single_documents[i].id);
+            ASSERT(bulk_documents[i].relevance == single_documents[i].relevance);
+        }
+    }
+}
+
+void TestDocumentColumns()
+{
+    using namespace std;
+    DocumentColumns columns;
+    map<int, pair<int, DocumentStatus>> expected;
+    //Малые id попадают в таблицу прямой адресации, большие - в хеш-таблицу
+    for (int id : {5, 0, 1'000'000'000, 3, 70'000, 2, 1'500}) {
+        const DocumentStatus status = static_cast<DocumentStatus>(id % 4);
+        columns.Insert(id, -id, status);
+        expected[id] = {-id, status};
+    }
+    for (int id = 10; id < 3000; id += 3) {
+        columns.Insert(id, id, DocumentStatus::ACTUAL);
+        expected[id] = {id, DocumentStatus::ACTUAL};
+    }
+    for (int id : {5, 1'000'000'000, 13, 1'500, 9}) {
+        ASSERT_EQUAL(columns.Erase(id), expected.erase(id) != 0);
+    }
+    ASSERT(columns.size() == expected.size());
+    for (const auto& [id, data] : expected) {
+        const int ordinal = columns.GetOrdinal(id);
+        ASSERT_EQUAL(columns.GetId(ordinal), id);
+        ASSERT_EQUAL(columns.GetRating(ordinal), data.first);
+        ASSERT(columns.GetStatus(ordinal) == data.second);
+    }
+    ASSERT(!columns.Contains(5));
+    ASSERT(!columns.Contains(1'000'000'000));
+    ASSERT_EQUAL(columns.FindOrdinal(-1), -1);
+    bool is_thrown = false;
+    try {
+        columns.GetOrdinal(13);
+    }
+    catch (const out_of_range&) {
+        is_thrown = true;
+    }
+    ASSERT_HINT(is_thrown, "Removed document must not be found"s);
+}
+
+void TestDocumentFilter()
+{
+    using namespace std;
+    SearchServer search_server("and with"s);
+    const int document_count = 300;
+    for (int id = 0; id < document_count; ++id) {
+        search_server.AddDocument(id, "word"s + to_string(id % 10) + " word"s + to_string(id % 7) + " tail"s,
+                static_cast<DocumentStatus>(id % 4), {id % 7 - 2});
+    }
+    for (int id = 0; id < document_count; id += 11) {
+        search_server.RemoveDocument(id);
+    }
+    const DocumentFilter filter = DocumentFilter::StatusIn({DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT})
+                                  && DocumentFilter::RatingAtLeast(1) && DocumentFilter::IdModulo(2, 0);
+    const auto predicate = [](int document_id, DocumentStatus status, int rating) {
+        return (status == DocumentStatus::ACTUAL || status == DocumentStatus::IRRELEVANT) && rating >= 1
+               && document_id % 2 == 0;
+    };
+    for (const string& query : {"word3 word4"s, "word2 -word5 tail"s, "word1 word6 word0"s}) {
+        const auto expected = search_server.FindTopDocuments(query, predicate);
+        ASSERT(!expected.empty());
+        for (const auto& documents : {search_server.FindTopDocuments(query, filter),
+                                      search_server.FindTopDocuments(execution::par, query, filter)}) {
+            ASSERT(documents.size() == expected.size());
+            for (size_t i = 0; i < expected.size(); ++i) {
+                ASSERT_EQUAL(documents[i].id, expected[i].id);
+                ASSERT(abs(documents[i].relevance - expected[i].relevance) < ACCURACY_COMPARISON);
+            }
+        }
+    }
+    
+    //Карта совпадает с поэлементной проверкой, в том числе для делителя не степени двойки
+    const DocumentFilter filters[] = {filter, DocumentFilter(), DocumentFilter::RatingAtMost(0) && DocumentFilter::IdModulo(3, 1),
+                                      DocumentFilter::StatusIn({}), DocumentFilter::RatingAtLeast(2) && DocumentFilter::RatingAtMost(1)};
+    DocumentColumns columns;
+    for (int id = 0; id < 1000; id += 3) {
+        columns.Insert(id, id % 9 - 4, static_cast<DocumentStatus>(id % 4));
+    }
+    columns.Erase(30);
+    for (const DocumentFilter& current_filter : filters) {
+        const CandidateBitmap candidates = current_filter.Evaluate(columns);
+        ASSERT(candidates.size() == columns.size());
+        size_t expected_count = 0;
+        for (size_t ordinal = 0; ordinal < columns.size(); ++ordinal) {
+            const int id = columns.GetId(ordinal);
+            const bool is_matched = current_filter.Matches(id, columns.GetStatus(ordinal), columns.GetRating(ordinal));
+            ASSERT_EQUAL(candidates.Test(ordinal), is_matched);
+            expected_count += is_matched;
+        }
+        ASSERT(candidates.Count() == expected_count);
+    }
+    
+    bool is_thrown = false;
+    try {
+        DocumentFilter::IdModulo(0, 0);
+    }
+    catch (const invalid_argument&) {
+        is_thrown = true;
+    }
+    ASSERT_HINT(is_thrown, "Zero divisor must be rejected"s);
+}
+
+void TestReorderDocuments()
+{
+    using namespace std;
+    //Документы четырёх тем перемешаны по id; у документов одной темы общие слова
+    auto build = [](SearchServer& search_server) {
+        mt19937 generator(7);
+        for (int id = 0; id < 256; ++id) {
+            const int topic = static_cast<int>(generator() % 4);
+            string text = "common n"s + to_string(generator() % 50);
+            for (int i = 0; i < 6; ++i) {
+                text += " t"s + to_string(topic) + "w"s + to_string(generator() % 8);
+            }
+            search_server.AddDocument(id, text, id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL,
+                    {id % 5 - 1});
+        }
+    };
+    SearchServer reordered_server;
+    build(reordered_server);
+    SearchServer search_server;
+    build(search_server);
+    
+    const vector<string> queries = {"t0w1 t1w2 common"s, "t2w3 -t2w4"s, "t3w* -n1*"s, "t1w5~1 common -n3~1"s};
+    auto assert_same_documents = [](const vector<Document>& lhs, const vector<Document>& rhs) {
+        ASSERT(lhs.size() == rhs.size());
+        for (size_t i = 0; i < min(lhs.size(), rhs.size()); ++i) {
+            ASSERT_EQUAL(lhs[i].id, rhs[i].id);
+            ASSERT_EQUAL(lhs[i].rating, rhs[i].rating);
+            ASSERT(abs(lhs[i].relevance - rhs[i].relevance) < ACCURACY_COMPARISON);
+        }
+    };
+    auto assert_same_results = [&]() {
+        ASSERT_EQUAL(reordered_server.GetDocumentCount(), search_server.GetDocumentCount());
+        for (const string& query : queries) {
+            const auto expected = search_server.FindTopDocuments(query);
+            ASSERT(!expected.empty());
+            assert_same_documents(reordered_server.FindTopDocuments(query), expected);
+            assert_same_documents(reordered_server.FindTopDocuments(execution::par, query), expected);
+            assert_same_documents(reordered_server.FindTopDocuments(query, DocumentStatus::BANNED),
+                    search_server.FindTopDocuments(query, DocumentStatus::BANNED));
+            const DocumentFilter filter = DocumentFilter::RatingAtLeast(1) && DocumentFilter::IdModulo(3, 1);
+            assert_same_documents(reordered_server.FindTopDocuments(query, filter),
+                    search_server.FindTopDocuments(query, filter));
+            for (const int document_id : search_server) {
+                const auto expected_match = search_server.MatchDocument(query, document_id);
+                ASSERT(reordered_server.MatchDocument(query, document_id) == expected_match);
+                ASSERT(reordered_server.MatchDocument(execution::par, query, document_id) == expected_match);
+            }
+        }
+#ifndef SEARCH_SERVER_DISABLE_FORWARD_INDEX
+        for (const int document_id : search_server) {
+            const auto expected_freqs = search_server.GetWordFrequencies(document_id);
+            const auto freqs = reordered_server.GetWordFrequencies(document_id);
+            ASSERT((map<string_view, double>(freqs.begin(), freqs.end()))
+                   == (map<string_view, double>(expected_freqs.begin(), expected_freqs.end())));
+        }
+#endif
+    };
+    
+    reordered_server.ReorderDocuments();
+    assert_same_results();
+    ASSERT(reordered_server.GetMemoryUsage().GetAverageGapBits() < search_server.GetMemoryUsage().GetAverageGapBits());
+    
+    //Удаление переносит последний документ на место удалённого, добавление получает следующий номер
+    for (const int document_id : {0, 255, 17, 100, 101, 3}) {
+        reordered_server.RemoveDocument(document_id);
+        search_server.RemoveDocument(execution::par, document_id);
+    }
+    reordered_server.RemoveDocument(execution::par, 42);
+    search_server.RemoveDocument(42);
+    reordered_server.AddDocument(1000, "t0w1 t0w2 common"s, DocumentStatus::ACTUAL, {5});
+    search_server.AddDocument(1000, "t0w1 t0w2 common"s, DocumentStatus::ACTUAL, {5});
+    assert_same_results();
+    
+    reordered_server.ReorderDocuments();
+    assert_same_results();
+    
+    const vector<int> order = ComputeLocalityOrder({{0, 1}, {2}, {0, 1}, {}}, 3);
+    ASSERT((set<int>(order.begin(), order.end())) == (set<int>{0, 1, 2, 3}));
+    ASSERT(ComputeLocalityOrder({}, 0).empty());
+}
+
+void TestDeterministicParallelScoring()
+{
+    using namespace std;
+    mt19937 generator(5);
+    const vector<string> dictionary = GenerateDictionary(generator, 300, 6);
+    ZipfWordSampler sampler(dictionary, 1.0);
+    SearchServer search_server;
+    for (int id = 0; id < 3000; ++id) {
+        search_server.AddDocument(id, GenerateZipfQuery(generator, sampler, 20), DocumentStatus::ACTUAL, {id % 9});
+    }
+    for (int id = 0; id < 3000; id += 7) {
+        search_server.RemoveDocument(id);
+    }
+    vector<string> queries = GenerateZipfQueries(generator, sampler, 30, 8, 0.2);
+    queries.push_back(dictionary[0].substr(0, 1) + "* "s + dictionary[1] + "~1 "s + dictionary[2]);
+    queries.push_back(dictionary[3] + "~2 -"s + dictionary[4].substr(0, 1) + "*"s);
+    for (const string& query : queries) {
+        const auto expected = search_server.FindTopDocuments(execution::seq, query);
+        for (int run = 0; run < 2; ++run) {
+            const auto documents = search_server.FindTopDocuments(execution::par, query);
+            ASSERT(documents.size() == expected.size());
+            for (size_t i = 0; i < min(documents.size(), expected.size()); ++i) {
+                ASSERT_EQUAL(documents[i].id, expected[i].id);
+                ASSERT_HINT(documents[i].relevance == expected[i].relevance, "Relevance must match bit for bit"s);
+            }
+        }
+    }
+}
+
+void TestQueryPlanner()
+{
+    using namespace std;
+    SearchServer search_server;
+    for (int id = 0; id < 2000; ++id) {
+        string text = "all w"s + to_string(id % 100) + " rare"s + to_string(id % 500);
+        if (id % 10 != 0) { text += " base"s; }
+        if (id % 2 == 0) { text += " half"s; }
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, {id % 7});
+    }
+    auto predicate = [](int document_id, [[maybe_unused]] DocumentStatus status, int rating) {
+        return rating > 2 || document_id % 3 == 0;
+    };
+    const vector<tuple<string, QueryStrategy, bool>> cases = {
+            {"rare1 rare2 rare3"s, QueryStrategy::DOCUMENT_AT_A_TIME, false},
+            {"rare1 rare2 -half"s, QueryStrategy::DOCUMENT_AT_A_TIME, true},
+            {"base rare3 rare4"s, QueryStrategy::MAX_SCORE, false},
+            {"w1 w2 w3 w4 w5 w6"s, QueryStrategy::TERM_AT_A_TIME, false},
+            {"w1 w2 w3 w4 w5 w6 -half"s, QueryStrategy::TERM_AT_A_TIME, true},
+            {"w1 rare3 -all"s, QueryStrategy::EMPTY_RESULT, false},};
+    for (const auto& [query, strategy, is_minus_first] : cases) {
+        QueryStats stats;
+        const auto documents = search_server.FindTopDocuments(execution::seq, query, predicate, stats);
+        ASSERT_HINT(stats.strategy == strategy, query);
+        ASSERT_HINT(stats.is_minus_first == is_minus_first, query);
+        ASSERT(stats.result_count == documents.size());
+        //Параллельный поиск всегда обходит слова: результат должен совпасть до бита
+        const auto expected = search_server.FindTopDocuments(execution::par, query, predicate);
+        ASSERT(documents.size() == expected.size());
+        for (size_t i = 0; i < min(documents.size(), expected.size()); ++i) {
+            ASSERT_EQUAL(documents[i].id, expected[i].id);
+            ASSERT_HINT(documents[i].relevance == expected[i].relevance, query);
+        }
+        if (strategy == QueryStrategy::MAX_SCORE) {
+            ASSERT(stats.postings_skipped > 0);
+        }
+        if (strategy == QueryStrategy::EMPTY_RESULT) {
+            ASSERT(documents.empty());
+            ASSERT_EQUAL(stats.postings_scanned, 0);
+        }
+    }
+}
+
+void TestDocumentSet()
+{
+    using namespace std;
+    mt19937 generator(11);
+    //Редкие номера - массив, частые - битовая карта, подряд идущие после Optimize - отрезки
+    DocumentSet sparse;
+    DocumentSet dense;
+    set<int> expected_sparse;
+    set<int> expected_dense;
+    for (int i = 0; i < 3000; ++i) {
+        const int ordinal = static_cast<int>(generator() % 200000);
+        sparse.Insert(ordinal);
+        expected_sparse.insert(ordinal);
+    }
+    for (int ordinal = 60000; ordinal < 80000; ++ordinal) {
+        if (ordinal % 3 != 0 || ordinal > 66000) {
+            dense.Insert(ordinal);
+            expected_dense.insert(ordinal);
+        }
+    }
+    ASSERT(dense.GetBitmapCount() > 0);
+    for (int i = 0; i < 500; ++i) {
+        const int ordinal = 60000 + static_cast<int>(generator() % 20000);
+        dense.Erase(ordinal);
+        expected_dense.erase(ordinal);
+    }
+    dense.Optimize();
+    ASSERT(dense.GetRunCount() > 0);
+    dense.Insert(80000);
+    dense.Insert(70001);
+    expected_dense.insert({80000, 70001});
+    
+    auto to_vector = [](const DocumentSet& documents) {
+        vector<int> ordinals;
+        documents.ForEach([&ordinals](int ordinal) { ordinals.push_back(ordinal); });
+        return ordinals;
+    };
+    ASSERT(sparse.size() == expected_sparse.size());
+    ASSERT(dense.size() == expected_dense.size());
+    ASSERT(to_vector(sparse) == vector<int>(expected_sparse.begin(), expected_sparse.end()));
+    ASSERT(to_vector(dense) == vector<int>(expected_dense.begin(), expected_dense.end()));
+    for (int ordinal = 0; ordinal < 200000; ordinal += 13) {
+        ASSERT(sparse.Contains(ordinal) == (expected_sparse.count(ordinal) != 0));
+        ASSERT(dense.Contains(ordinal) == (expected_dense.count(ordinal) != 0));
+    }
+    vector<int> in_range;
+    dense.ForEachInRange(65535, 65600, [&in_range](int ordinal) { in_range.push_back(ordinal); });
+    ASSERT(in_range == vector<int>(expected_dense.lower_bound(65535), expected_dense.lower_bound(65600)));
+    
+    vector<int> intersection;
+    set_intersection(expected_sparse.begin(), expected_sparse.end(), expected_dense.begin(), expected_dense.end(),
+            back_inserter(intersection));
+    vector<int> united;
+    set_union(expected_sparse.begin(), expected_sparse.end(), expected_dense.begin(), expected_dense.end(),
+            back_inserter(united));
+    ASSERT(to_vector(sparse & dense) == intersection);
+    ASSERT(to_vector(dense & dense) == to_vector(dense));
+    ASSERT(to_vector(sparse | dense) == united);
+    ASSERT((sparse | dense).size() == united.size());
+    
+    //Множества документов слов остаются согласованными с постингами после удаления и перенумерации
+    SearchServer search_server;
+    for (int id = 0; id < 300; ++id) {
+        search_server.AddDocument(id, "w"s + to_string(id % 7) + " v"s + to_string(id % 11), DocumentStatus::ACTUAL,
+                {1});
+    }
+    for (int id = 0; id < 300; id += 5) {
+        search_server.RemoveDocument(id);
+    }
+    search_server.ReorderDocuments();
+    for (const int id : search_server) {
+        const auto [words, status] = search_server.MatchDocument("w3 v4 -w5"s, id);
+        vector<string_view> expected_words;
+        if (id % 7 != 5) {
+            if (id % 11 == 4) { expected_words.push_back("v4"sv); }
+            if (id % 7 == 3) { expected_words.push_back("w3"sv); }
+        }
+        ASSERT(words == expected_words);
+    }
+    for (const Document& document : search_server.FindTopDocuments("w3 v4 -v4"s)) {
+        ASSERT_EQUAL(document.id % 7, 3);
+        ASSERT(document.id % 11 != 4);
+    }
+}
+
+void TestMatchDocuments()
+{
+    using namespace std;
+    mt19937 generator(17);
+    const vector<string> dictionary = GenerateDictionary(generator, 200, 5);
+    ZipfWordSampler sampler(dictionary, 1.0);
+    SearchServer search_server;
+    for (int id = 0; id < 500; ++id) {
+        search_server.AddDocument(id, GenerateZipfQuery(generator, sampler, 15),
+                id % 4 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {1});
+    }
+    search_server.RemoveDocument(10);
+    vector<int> document_ids;
+    for (int id = 499; id >= 0; id -= 3) {
+        if (id != 10) { document_ids.push_back(id); }
+    }
+    vector<string> queries = GenerateZipfQueries(generator, sampler, 10, 6, 0.3);
+    queries.push_back(dictionary[0].substr(0, 1) + "* "s + dictionary[1] + "~1 "s + dictionary[2]);
+    queries.push_back(dictionary[3] + " "s + dictionary[5] + " -"s + dictionary[4].substr(0, 2) + "*"s);
+    queries.push_back(dictionary[6] + " -"s + dictionary[7] + "~1"s);
+    
+    vector<tuple<vector<string_view>, DocumentStatus>> results;
+    for (const string& query : queries) {
+        for (int run = 0; run < 2; ++run) {
+            if (run == 0) {
+                search_server.MatchDocuments(query, document_ids, results);
+            }
+            else {
+                search_server.MatchDocuments(execution::par, query, document_ids, results);
+            }
+            ASSERT(results.size() == document_ids.size());
+            for (size_t i = 0; i < document_ids.size(); ++i) {
+                ASSERT_HINT(results[i] == search_server.MatchDocument(query, document_ids[i]), query);
+            }
+        }
+    }
+    //Буфер предыдущего вызова переиспользуется, лишние результаты отбрасываются
+    search_server.MatchDocuments(queries[0], {document_ids[0]}, results);
+    ASSERT(results.size() == 1u);
+    try {
+        search_server.MatchDocuments(execution::par, queries[0], {1, 10}, results);
+        ASSERT_HINT(false, "Removed document must not be matched"s);
+    }
+    catch (const out_of_range&) {}
+}
+
+void TestSortedIntersection()
+{
+    using namespace std;
+    mt19937 generator(23);
+    auto generate = [&generator](size_t size, int range) {
+        set<int> values;
+        while (values.size() < size) {
+            values.insert(static_cast<int>(generator() % range));
+        }
+        return vector<int>(values.begin(), values.end());
+    };
+    //Сравнимые размеры - слияние блоками, в тысячу раз разные - экспоненциальный поиск
+    for (const auto& [lhs_size, rhs_size] : vector<pair<size_t, size_t>>{{0, 5}, {3, 3}, {7, 13}, {100, 120},
+                                                                          {1000, 900}, {2, 2000}, {5000, 4}}) {
+        for (int round = 0; round < 5; ++round) {
+            const int range = static_cast<int>(2 * max(lhs_size, rhs_size) + 1);
+            const vector<int> lhs = generate(lhs_size, range);
+            const vector<int> rhs = generate(rhs_size, range);
+            vector<int> expected;
+            set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), back_inserter(expected));
+            vector<int> result(min(lhs_size, rhs_size));
+            result.resize(IntersectSorted(lhs.data(), lhs.size(), rhs.data(), rhs.size(), result.data()));
+            ASSERT(result == expected);
+            ASSERT(IntersectsSorted(lhs.data(), lhs.size(), rhs.data(), rhs.size()) == !expected.empty());
+        }
+    }
+    const vector<int> evens = {0, 2, 4, 6, 8, 10, 12, 14};
+    const vector<int> odds = {1, 3, 5, 7, 9, 11, 13, 15};
+    ASSERT(!IntersectsSorted(evens.data(), evens.size(), odds.data(), odds.size()));
+    vector<int> result(evens.size());
+    ASSERT(IntersectSorted(evens.data(), evens.size(), evens.data(), evens.size(), result.data()) == evens.size());
+    ASSERT(result == evens);
+}
+
+void TestRequiredWords()
+{
+    using namespace std;
+    SearchServer search_server("and"s);
+    for (int id = 0; id < 3000; ++id) {
+        string text = "all w"s + to_string(id % 50) + " rare"s + to_string(id % 300);
+        if (id % 3 == 0) { text += " third"s; }
+        if (id % 7 == 0) { text += " seventh"s; }
+        search_server.AddDocument(id, text, DocumentStatus::ACTUAL, {id % 5});
+    }
+    for (const string& query : {"+"s, "+-cat"s, "-+cat"s, "++cat"s, "+cat*"s, "+cat~1"s}) {
+        try {
+            search_server.FindTopDocuments(query);
+            ASSERT_HINT(false, query);
+        }
+        catch (const invalid_argument&) {}
+    }
+    auto predicate = [](int document_id, [[maybe_unused]] DocumentStatus status, int rating) {
+        return rating > 0 || document_id % 2 == 0;
+    };
+    const vector<pair<string, vector<string>>> cases = {
+            {"+third +seventh w1 w2"s, {"third"s, "seventh"s}},
+            {"+third +seventh +all -w7"s, {"third"s, "seventh"s, "all"s}},
+            {"+rare21 all third -seventh"s, {"rare21"s}},
+            {"+w3 +and +w3 rare3"s, {"w3"s}},};
+    for (const auto& [query, required] : cases) {
+        QueryStats stats;
+        const auto documents = search_server.FindTopDocuments(execution::seq, query, predicate, stats);
+        ASSERT_HINT(stats.strategy == QueryStrategy::INTERSECTION, query);
+        ASSERT_HINT(!documents.empty(), query);
+        //Параллельный поиск обходит слова и отбрасывает документы без обязательных слов: результат совпадает до бита
+        const auto expected = search_server.FindTopDocuments(execution::par, query, predicate);
+        ASSERT(documents.size() == expected.size());
+        for (size_t i = 0; i < min(documents.size(), expected.size()); ++i) {
+            ASSERT_EQUAL(documents[i].id, expected[i].id);
+            ASSERT_HINT(documents[i].relevance == expected[i].relevance, query);
+        }
+        vector<int> document_ids;
+        for (const Document& document : documents) {
+            const auto [words, status] = search_server.MatchDocument(query, document.id);
+            for (const string& word : required) {
+                ASSERT_HINT(count(words.begin(), words.end(), word) == 1, query);
+            }
+            //Повторное обязательное слово не мешает совпадению ни в одной из перегрузок
+            const auto [par_words, par_status] = search_server.MatchDocument(execution::par, query, document.id);
+            ASSERT_HINT(par_words == words, query);
+            document_ids.push_back(document.id);
+        }
+        vector<tuple<vector<string_view>, DocumentStatus>> results;
+        search_server.MatchDocuments(query, document_ids, results);
+        ASSERT(results.size() == document_ids.size());
+        for (size_t i = 0; i < document_ids.size(); ++i) {
+            ASSERT_HINT(get<0>(results[i]) == get<0>(search_server.MatchDocument(query, document_ids[i])), query);
+        }
+    }
+    //Документы без обязательного слова не считаются отброшенными предикатом
+    for (const string& query : {"+third +seventh w1"s, "+third +seventh rare2*"s}) {
+        QueryStats stats;
+        search_server.FindTopDocuments(execution::seq, query,
+                [](int, DocumentStatus, int) { return true; }, stats);
+        ASSERT_HINT(stats.removed_by_required_words > 0, query);
+        ASSERT_EQUAL_HINT(stats.rejected_by_predicate, 0, query);
+    }
+    //Документ без обязательного слова не подходит под запрос
+    {
+        const auto [words, status] = search_server.MatchDocument("+seventh all"s, 1);
+        ASSERT(words.empty());
+        const auto [par_words, par_status] = search_server.MatchDocument(execution::par, "+seventh all"s, 1);
+        ASSERT(par_words.empty());
+        vector<tuple<vector<string_view>, DocumentStatus>> results;
+        search_server.MatchDocuments("+seventh all"s, {0, 1}, results);
+        ASSERT(get<0>(results[0]).size() == 2u);
+        ASSERT(get<0>(results[1]).empty());
+    }
+    //Обязательного слова нет в индексе: постинги не просматриваются
+    {
+        QueryStats stats;
+        const auto documents = search_server.FindTopDocuments(execution::seq, "all +unknown"s, predicate, stats);
+        ASSERT(documents.empty());
+        ASSERT(stats.strategy == QueryStrategy::EMPTY_RESULT);
+        ASSERT_EQUAL(stats.postings_scanned, 0);
+    }
+}
+
+void TestRemoveDuplicates()
+{
+    using namespace std;
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    //Дубликат 2: частоты и стоп-слова не важны
+    search_server.AddDocument(3, "funny pet with curly hair hair and"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(4, "nasty rat funny pet"s, DocumentStatus::ACTUAL, {1, 2});
+    search_server.AddDocument(5, "curly hair"s, DocumentStatus::ACTUAL, {1, 2});
+    //Работает и без прямого индекса: слова документа берутся из множеств документов слов
+    RemoveDuplicates(search_server);
+    ASSERT(vector<int>(search_server.begin(), search_server.end()) == vector<int>({1, 2, 5}));
+}
+
 void TestSearchServer()
 {
     RUN_TEST (TestAddDocumentMustBeFoundFromQuery);
@@ -748,5 +2469,30 @@ void TestSearchServer()
     RUN_TEST (TestProcessQueries);
     RUN_TEST (TestIteratorTree);
     RUN_TEST (TestProcessQueriesJoined);
+    RUN_TEST (TestFindTopDocumentsAsync);
+    RUN_TEST (TestQueryBudgetPartialScan);
+    RUN_TEST (TestProfileSnapshot);
+    RUN_TEST (TestQueryStats);
+    RUN_TEST (TestGetMemoryUsage);
+    RUN_TEST (TestTermDictionary);
+    RUN_TEST (TestMemoryResource);
+    RUN_TEST (TestShardedSearchServer);
+    RUN_TEST (TestShardCoordinator);
+    RUN_TEST (TestSearchFrontEnd);
+    RUN_TEST (TestConcurrentSearchServer);
+    RUN_TEST (TestPrefixQueries);
+    RUN_TEST (TestFuzzyQueries);
+    RUN_TEST (TestSearchAfterCursor);
+    RUN_TEST (TestCorpusLoader);
+    RUN_TEST (TestDocumentColumns);
+    RUN_TEST (TestDocumentFilter);
+    RUN_TEST (TestReorderDocuments);
+    RUN_TEST (TestDeterministicParallelScoring);
+    RUN_TEST (TestQueryPlanner);
+    RUN_TEST (TestDocumentSet);
+    RUN_TEST (TestMatchDocuments);
+    RUN_TEST (TestSortedIntersection);
+    RUN_TEST (TestRequiredWords);
+    RUN_TEST (TestRemoveDuplicates);
 }
 
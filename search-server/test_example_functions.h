@@ -145,6 +145,57 @@ void TestProcessQueries();
 void TestIteratorTree();
 
 void TestProcessQueriesJoined();
+//Асинхронный поиск с крайним сроком и отменой.
+void TestFindTopDocumentsAsync();
+//Бюджет, закончившийся посреди постинга, даёт лучшие документы из просмотренных.
+void TestQueryBudgetPartialScan();
+//Сбор времени выполнения этапов поиска.
+void TestProfileSnapshot();
+//Статистика выполнения запроса.
+void TestQueryStats();
+//Оценка памяти структур индекса.
+void TestGetMemoryUsage();
+//Словарь слов: id по порядку добавления и неизменные string_view.
+void TestTermDictionary();
+//Контейнеры индекса выделяют память из переданного memory_resource.
+void TestMemoryResource();
+//Шардированный сервер выдаёт те же документы, что и обычный.
+void TestShardedSearchServer();
+//Координатор узлов-шардов на Unix-сокетах выдаёт те же документы, что и обычный сервер,
+//а при молчащем узле возвращает частичный результат.
+void TestShardCoordinator();
+//Сетевой фронтенд отвечает на запросы по TCP и Unix-сокету в порядке их поступления.
+void TestSearchFrontEnd();
+//Запросы к ConcurrentSearchServer во время добавления документов видят согласованные версии индекса.
+void TestConcurrentSearchServer();
+//Слова запроса вида "префикс*" раскрываются в слова индекса с этим префиксом.
+void TestPrefixQueries();
+//Слова запроса вида "слово~N" раскрываются в слова индекса на расстоянии Левенштейна не больше N.
+void TestFuzzyQueries();
+//Страницы, полученные по курсору, совпадают с полной выдачей, а Paginate не просматривает диапазон заранее.
+void TestSearchAfterCursor();
+//Корпус, загруженный из файла, отображённого в память, совпадает с добавленным по одному документу.
+void TestCorpusLoader();
+//Столбцы метаданных находят документы по id после добавлений и удалений, в том числе для больших id.
+void TestDocumentColumns();
+//Поиск с DocumentFilter выдаёт те же документы, что и с эквивалентным предикатом.
+void TestDocumentFilter();
+//После ReorderDocuments поиск, сопоставление и удаление дают те же результаты, а разности номеров в постингах меньше.
+void TestReorderDocuments();
+//Параллельный поиск выдаёт ту же релевантность, что и последовательный, до бита.
+void TestDeterministicParallelScoring();
+//Планировщик выбирает способ вычисления запроса, не меняя результат.
+void TestQueryPlanner();
+//Множество документов хранит номера массивами, битовыми картами и отрезками и пересекает их.
+void TestDocumentSet();
+//Пакетный MatchDocuments выдаёт то же, что MatchDocument для каждого документа.
+void TestMatchDocuments();
+//Пересечение возрастающих массивов совпадает с std::set_intersection при любом соотношении размеров.
+void TestSortedIntersection();
+//Слова "+слово" обязательны: найденные документы содержат их все.
+void TestRequiredWords();
+//Документы с тем же набором слов, что у документа с меньшим id, удаляются.
+void TestRemoveDuplicates();
 // Функция TestSearchServer является точкой входа для запуска тестов
 void TestSearchServer();
 // --------- Окончание модульных тестов поисковой системы -----------
@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <stdexcept>
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t thread_count)
+{
+    if (thread_count == 0) { throw std::invalid_argument("Thread count must be greater than zero."); }
+    workers_.reserve(thread_count);
+    try {
+        for (size_t i = 0; i < thread_count; ++i) {
+            workers_.emplace_back([this]() { Work(); });
+        }
+    }
+    catch (...) {
+        //Уже запущенные потоки нужно остановить: уничтожение присоединяемого std::thread вызывает std::terminate
+        Stop();
+        throw;
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    Stop();
+}
+
+void ThreadPool::Stop()
+{
+    {
+        std::lock_guard guard(mutex_);
+        is_stopped_ = true;
+    }
+    has_task_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::GetThreadCount() const
+{
+    return workers_.size();
+}
+
+ThreadPool& ThreadPool::Shared()
+{
+    static ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()));
+    return pool;
+}
+
+void ThreadPool::Push(std::function<void()> task)
+{
+    {
+        std::lock_guard guard(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    has_task_.notify_one();
+}
+
+void ThreadPool::Work()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            has_task_.wait(lock, [this]() { return is_stopped_ || !tasks_.empty(); });
+            //Перед остановкой дорабатываем оставшиеся задачи, чтобы не оставить future без результата
+            if (tasks_.empty()) { return; }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
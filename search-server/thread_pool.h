@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//Пул потоков с общей очередью задач
+class ThreadPool
+{
+public:
+    explicit ThreadPool(size_t thread_count);
+    
+    ThreadPool(const ThreadPool&) = delete;
+    
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    ~ThreadPool();
+    
+    template<typename Function>
+    std::future<std::invoke_result_t<Function>> Submit(Function func)
+    {
+        using Result = std::invoke_result_t<Function>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+        std::future<Result> result = task->get_future();
+        Push([task]() { (*task)(); });
+        return result;
+    }
+    
+    size_t GetThreadCount() const;
+    
+    //Общий пул для асинхронных запросов к поисковому серверу
+    static ThreadPool& Shared();
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable has_task_;
+    bool is_stopped_ = false;
+    
+    void Push(std::function<void()> task);
+    
+    void Work();
+    
+    void Stop();
+};
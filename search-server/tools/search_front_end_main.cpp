@@ -0,0 +1,66 @@
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "../corpus_generator.h"
+#include "../profiler.h"
+#include "../search_front_end.h"
+
+using namespace std;
+
+//Сетевой фронтенд на синтетическом корпусе: search_front_end <port|socket_path> [document_count] [seed]
+//Порт слушается на 127.0.0.1. Работает до SIGINT или SIGTERM, затем печатает задержки запросов
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 4) {
+        cerr << "Usage: "s << argv[0] << " <port|socket_path> [document_count] [seed]"s << endl;
+        return 1;
+    }
+
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try {
+        const string endpoint = argv[1];
+        const int document_count = argc > 2 ? stoi(argv[2]) : 10'000;
+        mt19937 generator(argc > 3 ? static_cast<uint32_t>(stoul(argv[3])) : 42);
+        const auto dictionary = GenerateDictionary(generator, 5'000, 10);
+        ZipfWordSampler sampler(dictionary, 1.0);
+        SearchServer search_server(dictionary[0]);
+        for (int id = 0; id < document_count; ++id) {
+            search_server.AddDocument(id, GenerateZipfQuery(generator, sampler, 50), DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+
+        SearchFrontEnd front_end(search_server);
+        if (endpoint.find_first_not_of("0123456789"s) == string::npos) {
+            front_end.ListenTcp("127.0.0.1"s, static_cast<uint16_t>(stoi(endpoint)));
+        }
+        else {
+            front_end.ListenUnix(endpoint);
+        }
+        thread signal_waiter([&front_end, &signals]() {
+            int signal = 0;
+            sigwait(&signals, &signal);
+            front_end.Stop();
+        });
+        front_end.Run();
+        signal_waiter.join();
+
+        for (const StageProfile& profile : GetProfileSnapshot()) {
+            if (profile.stage == ProfileStage::SERVE_REQUEST) {
+                cout << "requests: "s << profile.count << ", p50: "s << profile.GetPercentileNs(50) / 1000.0
+                     << " us, p99: "s << profile.GetPercentileNs(99) / 1000.0 << " us"s << endl;
+            }
+        }
+    }
+    catch (const exception& error) {
+        cerr << error.what() << endl;
+        return 1;
+    }
+}
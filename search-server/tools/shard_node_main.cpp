@@ -0,0 +1,52 @@
+#include <csignal>
+#include <pthread.h>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "../shard_node.h"
+
+using namespace std;
+
+//Узел-шард поискового сервера: shard_node <socket_path> [stop_words]
+//Работает до SIGINT или SIGTERM
+int main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 3) {
+        cerr << "Usage: "s << argv[0] << " <socket_path> [stop_words]"s << endl;
+        return 1;
+    }
+
+    //Сигналы принимает отдельный поток через sigwait, остальные потоки их не получают
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    try {
+        ShardNode node(argv[1], argc == 3 ? argv[2] : ""s);
+        thread signal_waiter([&node, &signals]() {
+            int signal = 0;
+            sigwait(&signals, &signal);
+            node.Stop();
+        });
+        int exit_code = 0;
+        try {
+            node.Run();
+        }
+        catch (const exception& error) {
+            cerr << error.what() << endl;
+            exit_code = 1;
+        }
+        //Run завершается и без сигнала, если accept вернул ошибку: тогда поток сигналов будится сигналом,
+        //который он ждёт. Уже получивший сигнал поток завершён, и сигнал ему ничего не делает
+        pthread_kill(signal_waiter.native_handle(), SIGTERM);
+        signal_waiter.join();
+        return exit_code;
+    }
+    catch (const exception& error) {
+        cerr << error.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,50 @@
+#include <algorithm>
+#include "word_frequencies_view.h"
+
+WordFrequenciesView::WordFrequenciesView() = default;
+
+WordFrequenciesView::WordFrequenciesView(const Entry* entries, size_t size, const TermDictionary& words) : entries_(
+        entries), size_(size), words_(&words) {}
+
+WordFrequenciesView::WordFrequenciesView(std::vector<Entry> entries, const TermDictionary& words) : words_(&words)
+{
+    std::sort(entries.begin(), entries.end(), [&words](const Entry& lhs, const Entry& rhs) {
+        return words[lhs.first] < words[rhs.first];
+    });
+    storage_ = std::make_shared<const std::vector<Entry>>(std::move(entries));
+    entries_ = storage_->data();
+    size_ = storage_->size();
+}
+
+WordFrequenciesView::Iterator WordFrequenciesView::begin() const
+{
+    return Iterator(words_, entries_);
+}
+
+WordFrequenciesView::Iterator WordFrequenciesView::end() const
+{
+    return Iterator(words_, entries_ + size_);
+}
+
+size_t WordFrequenciesView::size() const
+{
+    return size_;
+}
+
+bool WordFrequenciesView::empty() const
+{
+    return size_ == 0;
+}
+
+bool operator==(const WordFrequenciesView& lhs, const std::map<std::string_view, double>& rhs)
+{
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin(),
+            [](const std::pair<std::string_view, double>& left, const std::pair<const std::string_view, double>& right) {
+                return left.first == right.first && left.second == right.second;
+            });
+}
+
+bool operator!=(const WordFrequenciesView& lhs, const std::map<std::string_view, double>& rhs)
+{
+    return !(lhs == rhs);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "term_dictionary.h"
+
+//Частоты слов документа поверх прямого индекса: пары из id слова и частоты, упорядоченные по словам,
+//поэтому слова перебираются в лексикографическом порядке, как в std::map, а разыменование стоит O(1).
+//Действительно, пока индекс не изменён: удаление любого документа и ReorderDocuments меняют порядковые номера
+class WordFrequenciesView
+{
+public:
+    using Entry = std::pair<int, double>;
+    
+    class Iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+        
+        Iterator() = default;
+        
+        Iterator(const TermDictionary* words, const Entry* entry) : words_(words), entry_(entry) {}
+        
+        value_type operator*() const
+        {
+            return {(*words_)[entry_->first], entry_->second};
+        }
+        
+        Iterator& operator++()
+        {
+            ++entry_;
+            return *this;
+        }
+        
+        Iterator operator++(int)
+        {
+            Iterator result(*this);
+            ++entry_;
+            return result;
+        }
+        
+        bool operator==(const Iterator& rhs) const
+        {
+            return entry_ == rhs.entry_;
+        }
+        
+        bool operator!=(const Iterator& rhs) const
+        {
+            return !(*this == rhs);
+        }
+    
+    private:
+        const TermDictionary* words_ = nullptr;
+        const Entry* entry_ = nullptr;
+    };
+    
+    //Пустое представление
+    WordFrequenciesView();
+    
+    //entries - пары документа, упорядоченные по словам; представление не копирует их и не владеет ими
+    WordFrequenciesView(const Entry* entries, size_t size, const TermDictionary& words);
+    
+    //Владеющее представление для сервера без прямого индекса, где пары собираются при запросе.
+    //entries - пары в любом порядке
+    WordFrequenciesView(std::vector<Entry> entries, const TermDictionary& words);
+    
+    Iterator begin() const;
+    
+    Iterator end() const;
+    
+    size_t size() const;
+    
+    bool empty() const;
+
+private:
+    //Копии представления делят собранные пары
+    std::shared_ptr<const std::vector<Entry>> storage_;
+    const Entry* entries_ = nullptr;
+    size_t size_ = 0;
+    const TermDictionary* words_ = nullptr;
+};
+
+//Совпадают слова, их порядок и частоты
+bool operator==(const WordFrequenciesView& lhs, const std::map<std::string_view, double>& rhs);
+
+bool operator!=(const WordFrequenciesView& lhs, const std::map<std::string_view, double>& rhs);